@@ -0,0 +1,238 @@
+#include "metrics.hpp"
+#include <cstdio>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+namespace mgm {
+
+namespace {
+
+constexpr std::array<std::string_view, MetricOpCount> OpNames = {
+    "findStationOnLine", "findTransitionStationByName", "validateSystem", "addLine", "removeLine",
+    "addStationToLine", "removeStationFromLine", "modifyStationInLine", "addTransfer", "applyBatch"};
+
+/// Blocks of live threads and the totals of finished ones.
+struct Registry {
+    std::mutex mutex;
+    std::vector<metrics::ThreadMetrics *> live;
+    MetricsSnapshot retired;
+    uint64_t originTicks = metrics::ticks();
+    std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+};
+
+/// Never destroyed, so threads that exit during static destruction can still retire.
+Registry &registry() {
+    static Registry *instance = new Registry;
+    return *instance;
+}
+
+void addBlock(MetricsSnapshot &to, const metrics::ThreadMetrics &block) {
+    for (size_t op = 0; op < MetricOpCount; ++op) {
+        const auto &from = block.ops[op];
+        auto &total = to.operations[op];
+        total.calls += from.calls.load(std::memory_order_relaxed);
+        total.errors += from.errors.load(std::memory_order_relaxed);
+        total.samples += from.samples.load(std::memory_order_relaxed);
+        total.sampledNs += static_cast<double>(from.sampledTicks.load(std::memory_order_relaxed));
+        for (size_t b = 0; b < metrics::BucketCount; ++b)
+            total.buckets[b] += from.buckets[b].load(std::memory_order_relaxed);
+    }
+}
+
+/// Folds the block of an exiting thread into the totals.
+struct Retirement {
+    ~Retirement() {
+        if (!metrics::current)
+            return;
+        Registry &reg = registry();
+        std::lock_guard lock(reg.mutex);
+        addBlock(reg.retired, *metrics::current);
+        std::erase(reg.live, metrics::current);
+        delete metrics::current;
+        metrics::current = nullptr;
+    }
+};
+
+/// Length of a tick, measured against the steady clock since the registry was created.
+double measureNsPerTick(const Registry &reg) {
+#if defined(__x86_64__) || defined(__i386__)
+    using namespace std::chrono;
+    auto elapsed = steady_clock::now() - reg.origin;
+    if (elapsed < milliseconds(1)) {
+        std::this_thread::sleep_for(milliseconds(1) - elapsed);
+        elapsed = steady_clock::now() - reg.origin;
+    }
+    uint64_t ticks = metrics::ticks() - reg.originTicks;
+    return ticks ? static_cast<double>(duration_cast<nanoseconds>(elapsed).count()) / static_cast<double>(ticks) : 1.0;
+#else
+    static_cast<void>(reg);
+    return 1.0;
+#endif
+}
+
+size_t lastBucket(const OperationMetrics &op) {
+    for (size_t b = metrics::BucketCount; b > 0; --b) {
+        if (op.buckets[b - 1])
+            return b - 1;
+    }
+    return 0;
+}
+
+/// Upper end of a bucket in nanoseconds.
+double bucketCeilingNs(size_t bucket, double nsPerTick) {
+    uint64_t ceiling = bucket + 1 < metrics::BucketCount ? metrics::bucketFloor(bucket + 1) : metrics::bucketFloor(bucket);
+    return static_cast<double>(ceiling) * nsPerTick;
+}
+
+void appendNumber(mgc::TextSink &out, const char *format, double value) {
+    std::array<char, 32> text;
+    int n = std::snprintf(text.data(), text.size(), format, value);
+    out.append(std::string_view(text.data(), static_cast<size_t>(n)));
+}
+
+} // namespace
+
+std::string_view metricOpName(MetricOp op) noexcept {
+    return OpNames[static_cast<size_t>(op)];
+}
+
+namespace metrics {
+
+ThreadMetrics *registerThread() noexcept {
+    thread_local Retirement retirement;
+    static_cast<void>(retirement);
+    auto *block = new (std::nothrow) ThreadMetrics;
+    if (!block)
+        return &discarded;
+    try {
+        Registry &reg = registry();
+        std::lock_guard lock(reg.mutex);
+        reg.live.push_back(block);
+    } catch (...) {
+        delete block;
+        return &discarded;
+    }
+    current = block;
+    return block;
+}
+
+MetricsSnapshot snapshot() {
+    Registry &reg = registry();
+    MetricsSnapshot result;
+#if METRO_METRICS
+    result.enabled = true;
+#endif
+    result.nsPerTick = measureNsPerTick(reg);
+    {
+        std::lock_guard lock(reg.mutex);
+        result.operations = reg.retired.operations;
+        for (const ThreadMetrics *block : reg.live)
+            addBlock(result, *block);
+    }
+    for (auto &op : result.operations)
+        op.sampledNs *= result.nsPerTick;
+    return result;
+}
+
+} // namespace metrics
+
+double OperationMetrics::meanNs() const noexcept {
+    return samples ? sampledNs / static_cast<double>(samples) : 0.0;
+}
+
+double OperationMetrics::percentileNs(double fraction, double nsPerTick) const noexcept {
+    if (!samples)
+        return 0.0;
+    auto rank = static_cast<uint64_t>(fraction * static_cast<double>(samples));
+    uint64_t seen = 0;
+    for (size_t b = 0; b < metrics::BucketCount; ++b) {
+        seen += buckets[b];
+        if (seen > rank)
+            return bucketCeilingNs(b, nsPerTick);
+    }
+    return bucketCeilingNs(lastBucket(*this), nsPerTick);
+}
+
+void MetricsSnapshot::writeText(mgc::TextSink &out) const {
+    out.append("operation calls errors samples mean_ns p50_ns p99_ns max_ns\n");
+    for (size_t i = 0; i < MetricOpCount; ++i) {
+        const OperationMetrics &op = operations[i];
+        out.append(OpNames[i]);
+        for (uint64_t count : {op.calls, op.errors, op.samples}) {
+            out.put(' ');
+            mgc::appendNumber(out, count);
+        }
+        out.put(' ');
+        appendNumber(out, "%.1f", op.meanNs());
+        for (double fraction : {0.5, 0.99}) {
+            out.put(' ');
+            appendNumber(out, "%.0f", op.percentileNs(fraction, nsPerTick));
+        }
+        out.put(' ');
+        appendNumber(out, "%.0f", op.samples ? bucketCeilingNs(lastBucket(op), nsPerTick) : 0.0);
+        out.put('\n');
+    }
+}
+
+void MetricsSnapshot::writeJson(mgc::TextSink &out) const {
+    out.append("{\"enabled\":");
+    out.append(enabled ? "true" : "false");
+    out.append(",\"sample_every\":");
+    mgc::appendNumber(out, metrics::SampleEvery);
+    out.append(",\"ns_per_tick\":");
+    appendNumber(out, "%.6g", nsPerTick);
+    out.append(",\"operations\":{");
+    for (size_t i = 0; i < MetricOpCount; ++i) {
+        const OperationMetrics &op = operations[i];
+        if (i)
+            out.put(',');
+        out.put('"');
+        out.append(OpNames[i]);
+        out.append("\":{\"calls\":");
+        mgc::appendNumber(out, op.calls);
+        out.append(",\"errors\":");
+        mgc::appendNumber(out, op.errors);
+        out.append(",\"samples\":");
+        mgc::appendNumber(out, op.samples);
+        out.append(",\"mean_ns\":");
+        appendNumber(out, "%.1f", op.meanNs());
+        out.append(",\"p50_ns\":");
+        appendNumber(out, "%.0f", op.percentileNs(0.5, nsPerTick));
+        out.append(",\"p90_ns\":");
+        appendNumber(out, "%.0f", op.percentileNs(0.9, nsPerTick));
+        out.append(",\"p99_ns\":");
+        appendNumber(out, "%.0f", op.percentileNs(0.99, nsPerTick));
+        out.append(",\"histogram\":[");
+        bool first = true;
+        for (size_t b = 0; b < metrics::BucketCount; ++b) {
+            if (!op.buckets[b])
+                continue;
+            out.append(first ? "[" : ",[");
+            first = false;
+            appendNumber(out, "%.0f", static_cast<double>(metrics::bucketFloor(b)) * nsPerTick);
+            out.put(',');
+            mgc::appendNumber(out, op.buckets[b]);
+            out.put(']');
+        }
+        out.append("]}");
+    }
+    out.append("}}\n");
+}
+
+std::string MetricsSnapshot::getText() const {
+    std::string text;
+    mgc::TextSink out(text);
+    writeText(out);
+    return text;
+}
+
+std::string MetricsSnapshot::getJson() const {
+    std::string text;
+    mgc::TextSink out(text);
+    writeJson(out);
+    return text;
+}
+
+} // namespace mgm
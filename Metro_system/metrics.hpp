@@ -0,0 +1,269 @@
+#ifndef METRICS_HPP_
+#define METRICS_HPP_
+
+#include "../container/textSink.hpp"
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/**
+ * @file metrics.hpp
+ * @brief Per-thread call counters and latency histograms of MetroSystem operations.
+ *
+ * Instrumented operations open a METRO_METRIC_SCOPE, which counts the call, counts it
+ * again as an error unless METRO_METRIC_SUCCEED is reached, and times one call in
+ * metrics::SampleEvery into a log-linear histogram. Every thread records into its own
+ * block without locks; snapshot() sums the blocks of live and finished threads. With
+ * the METRO_METRICS CMake option off the scopes compile to nothing and snapshots are
+ * empty.
+ */
+
+namespace mgm {
+
+/**
+ * @brief Operations with metrics.
+ */
+enum class MetricOp : uint8_t {
+    FindStationOnLine,
+    FindTransitionStation,
+    ValidateSystem,
+    AddLine,
+    RemoveLine,
+    AddStation,
+    RemoveStation,
+    ModifyStation,
+    AddTransfer,
+    ApplyBatch
+};
+
+/// Number of MetricOp values.
+inline constexpr size_t MetricOpCount = 10;
+
+/**
+ * @brief Gets the name of an operation as it appears in snapshots.
+ * @param op The operation.
+ * @return The name of the MetroSystem method.
+ */
+std::string_view metricOpName(MetricOp op) noexcept;
+
+namespace metrics {
+
+/// One call in this many is timed, per thread and operation.
+inline constexpr uint64_t SampleEvery = 64;
+/// Linear steps per power of two in the histograms: 2^3, so buckets are at most 12.5% wide.
+inline constexpr unsigned SubBucketBits = 3;
+inline constexpr size_t SubBuckets = size_t{1} << SubBucketBits;
+/// Buckets covering every 64-bit tick count.
+inline constexpr size_t BucketCount = (64 - SubBucketBits + 1) * SubBuckets;
+
+/**
+ * @brief Gets the histogram bucket of a duration.
+ * @param ticks The duration in clock ticks.
+ * @return The bucket index.
+ */
+constexpr size_t bucketOf(uint64_t ticks) noexcept {
+    if (ticks < SubBuckets)
+        return static_cast<size_t>(ticks);
+    unsigned shift = static_cast<unsigned>(std::bit_width(ticks)) - 1 - SubBucketBits;
+    return (shift + 1) * SubBuckets + static_cast<size_t>((ticks >> shift) & (SubBuckets - 1));
+}
+
+/**
+ * @brief Gets the smallest duration of a histogram bucket.
+ * @param bucket The bucket index.
+ * @return The duration in clock ticks.
+ */
+constexpr uint64_t bucketFloor(size_t bucket) noexcept {
+    if (bucket < SubBuckets)
+        return bucket;
+    size_t shift = bucket / SubBuckets - 1;
+    return (SubBuckets + bucket % SubBuckets) << shift;
+}
+
+/**
+ * @brief Reads the timestamp counter, or the steady clock in nanoseconds where there is none.
+ * @return The current tick count.
+ */
+inline uint64_t ticks() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+/**
+ * @brief The counters one thread records into.
+ *
+ * Only the owning thread writes, so counters are bumped with a relaxed load and
+ * store rather than an atomic read-modify-write; they are atomic only so that
+ * snapshots may read them meanwhile.
+ */
+struct ThreadMetrics {
+    struct Op {
+        std::atomic<uint64_t> calls{0};
+        std::atomic<uint64_t> errors{0};
+        std::atomic<uint64_t> samples{0};
+        std::atomic<uint64_t> sampledTicks{0};
+        std::array<std::atomic<uint64_t>, BucketCount> buckets{};
+    };
+    std::array<Op, MetricOpCount> ops;
+};
+
+/// The block of the calling thread, or nullptr before its first recorded call.
+inline thread_local ThreadMetrics *current = nullptr;
+
+/// Block recorded into by threads that could not register one; never read.
+inline ThreadMetrics discarded;
+
+/**
+ * @brief Creates and registers the block of the calling thread.
+ *
+ * Metered calls must not fail because of their metrics, so when the block cannot
+ * be allocated or registered the call records into @c discarded instead, and the
+ * next call tries again.
+ *
+ * @return The block, which is folded into the totals when the thread exits.
+ */
+ThreadMetrics *registerThread() noexcept;
+
+inline void bump(std::atomic<uint64_t> &counter, uint64_t by = 1) noexcept {
+    counter.store(counter.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Records one call of an operation for as long as it is in scope.
+ *
+ * Success is marked explicitly rather than detected with std::uncaught_exceptions(),
+ * which costs two calls through the TLS of the shared C++ runtime.
+ */
+class ScopedOp {
+public:
+    explicit ScopedOp(MetricOp op) noexcept
+        : metrics((current ? current : registerThread())->ops[static_cast<size_t>(op)]) {
+        uint64_t calls = metrics.calls.load(std::memory_order_relaxed);
+        metrics.calls.store(calls + 1, std::memory_order_relaxed);
+        if (calls % SampleEvery == 0)
+            start = ticks();
+    }
+
+    ScopedOp(const ScopedOp &) = delete;
+    ScopedOp &operator=(const ScopedOp &) = delete;
+
+    ~ScopedOp() {
+        if (start) {
+            uint64_t elapsed = ticks() - start;
+            bump(metrics.samples);
+            bump(metrics.sampledTicks, elapsed);
+            bump(metrics.buckets[bucketOf(elapsed)]);
+        }
+        if (!succeeded)
+            bump(metrics.errors);
+    }
+
+    /// Marks the call as successful; calls that leave the scope without it count as errors.
+    void succeed() noexcept { succeeded = true; }
+
+private:
+    ThreadMetrics::Op &metrics;
+    bool succeeded = false;
+    uint64_t start = 0; ///< Tick count at entry of a timed call, 0 otherwise.
+};
+
+} // namespace metrics
+
+/**
+ * @brief Totals of one operation.
+ */
+struct OperationMetrics {
+    uint64_t calls = 0;        ///< Calls, including failed ones.
+    uint64_t errors = 0;       ///< Calls that threw.
+    uint64_t samples = 0;      ///< Timed calls.
+    double sampledNs = 0;      ///< Total time of the timed calls.
+    std::array<uint64_t, metrics::BucketCount> buckets{}; ///< Timed calls per histogram bucket.
+
+    /**
+     * @brief Gets the mean latency of the timed calls.
+     * @return Nanoseconds, or 0 without samples.
+     */
+    double meanNs() const noexcept;
+
+    /**
+     * @brief Gets a latency percentile of the timed calls.
+     * @param fraction The percentile as a fraction, e.g. 0.99.
+     * @param nsPerTick Length of a clock tick.
+     * @return The upper end of the bucket holding the percentile, in nanoseconds; 0 without samples.
+     */
+    double percentileNs(double fraction, double nsPerTick) const noexcept;
+};
+
+/**
+ * @brief Operation metrics of all MetroSystem instances at one point in time.
+ */
+struct MetricsSnapshot {
+    bool enabled = false;   ///< Whether metrics were compiled in.
+    double nsPerTick = 1.0; ///< Length of a histogram clock tick.
+    std::array<OperationMetrics, MetricOpCount> operations; ///< Indexed by MetricOp.
+
+    /**
+     * @brief Gets the totals of an operation.
+     * @param op The operation.
+     * @return The totals.
+     */
+    const OperationMetrics &operator[](MetricOp op) const noexcept { return operations[static_cast<size_t>(op)]; }
+
+    /**
+     * @brief Writes one row per operation: calls, errors, samples and latencies in nanoseconds.
+     * @param out The destination.
+     */
+    void writeText(mgc::TextSink &out) const;
+
+    /**
+     * @brief Writes the snapshot as a JSON object, with the non-empty histogram buckets
+     *        as [lower bound in nanoseconds, count] pairs.
+     * @param out The destination.
+     */
+    void writeJson(mgc::TextSink &out) const;
+
+    /**
+     * @brief Gets the text form of the snapshot.
+     * @return The text written by writeText().
+     */
+    std::string getText() const;
+
+    /**
+     * @brief Gets the JSON form of the snapshot.
+     * @return The text written by writeJson().
+     */
+    std::string getJson() const;
+};
+
+namespace metrics {
+
+/**
+ * @brief Sums the metrics recorded so far by every thread.
+ * @return The snapshot.
+ */
+MetricsSnapshot snapshot();
+
+} // namespace metrics
+
+} // namespace mgm
+
+#if METRO_METRICS
+#define METRO_METRIC_SCOPE(op) ::mgm::metrics::ScopedOp metroMetricScope(::mgm::MetricOp::op)
+#define METRO_METRIC_SUCCEED() metroMetricScope.succeed()
+#else
+#define METRO_METRIC_SCOPE(op) static_cast<void>(0)
+#define METRO_METRIC_SUCCEED() static_cast<void>(0)
+#endif
+
+#endif
@@ -2,110 +2,801 @@
 #include "../Stations/transitionstation.hpp"
 #include <stdexcept>
 #include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
 namespace mgm {
 
-void MetroSystem::addLine(const string &lineName) {
-    if (lines.find(lineName) != lines.end())
-        throw std::invalid_argument("Error: A line with this name already exists.");
-    lines.emplace(lineName, Line(lineName));
+MetroSystem::MetroSystem(const MetroSystem &other)
+    : lines(other.lines), stationIndex(other.stationIndex), validation(other.validation), storage(other.storage),
+      stationCopyOnWrite(other.stationCopyOnWrite), routeGraph(other.routeGraph), routeCache(other.routeCache),
+      routePreprocessing(other.routePreprocessing), hierarchies(other.hierarchies) {}
+
+MetroSystem &MetroSystem::operator=(const MetroSystem &other) {
+    if (this != &other) {
+        lines = other.lines;
+        stationIndex = other.stationIndex;
+        validation = other.validation;
+        storage = other.storage;
+        stationCopyOnWrite = other.stationCopyOnWrite;
+        routeGraph = other.routeGraph;
+        routeCache = other.routeCache;
+        routePreprocessing = other.routePreprocessing;
+        hierarchies = other.hierarchies;
+    }
+    return *this;
 }
 
-void MetroSystem::removeLine(const string &lineName) {
-    auto it = lines.find(lineName);
-    if (it == lines.end())
+Line &MetroSystem::editableLine(std::string_view lineName) {
+    auto key = mgc::Symbol::find(lineName);
+    if (!key || !lines->contains(*key))
         throw std::invalid_argument("Error: Line not found.");
-    lines.erase(it);
+    return lines.edit().find(*key)->second;
 }
 
-void MetroSystem::addStationToLine(const string &lineName, station &&st) {
-    auto it = lines.find(lineName);
-    if (it == lines.end())
+const Line &MetroSystem::findLine(std::string_view lineName) const {
+    const Line *line = tryFindLine(lineName);
+    if (!line)
         throw std::invalid_argument("Error: Line not found.");
-    it->second.addElement(std::move(st));
+    return *line;
 }
 
-void MetroSystem::removeStationFromLine(const string &lineName, const string &stationName) {
-    auto it = lines.find(lineName);
-    if (it == lines.end())
-        throw std::invalid_argument("Error: Line not found.");
-    it->second.removeElement(stationName);
+const Line *MetroSystem::tryFindLine(std::string_view lineName) const noexcept {
+    auto key = mgc::Symbol::find(lineName);
+    if (!key)
+        return nullptr;
+    auto it = lines->find(*key);
+    return it == lines->end() ? nullptr : &it->second;
 }
 
-void MetroSystem::modifyStationInLine(const string &lineName,
-                                      const string &stationName,
-                                      const string &newName,
-                                      const string &newType) {
-    auto it = lines.find(lineName);
-    if (it == lines.end())
-        throw std::invalid_argument("Error: Line not found.");
-    it->second.removeElement(stationName);
-    if (newType == "transition") {
-        transition_station ts(newName);
-        it->second.addElement(std::move(ts));
+void MetroSystem::indexStation(const Line &line, const shared_ptr<station> &st) {
+    stationIndex.edit(st->getNameSymbol()).push_back(StationLocation{line.getNameSymbol(), st});
+}
+
+void MetroSystem::unindexStation(const Line &line, mgc::Symbol stationName) {
+    auto *locations = stationIndex.findForEdit(stationName);
+    if (!locations)
+        return;
+    std::erase_if(*locations, [&line](const StationLocation &loc) { return loc.line == line.getNameSymbol(); });
+    if (locations->empty())
+        stationIndex.erase(stationName);
+}
+
+shared_ptr<station> MetroSystem::detachStation(Line &line, const shared_ptr<station> &st) {
+    if (auto *ts = dynamic_cast<transition_station *>(st.get()))
+        line.replaceElement(st->getName(), *ts);
+    else
+        line.replaceElement(st->getName(), *st);
+    unindexStation(line, st->getNameSymbol());
+    auto copy = line.tryFind(st->getNameSymbol());
+    indexStation(line, copy);
+    return copy;
+}
+
+bool MetroSystem::isTransferTarget(mgc::Symbol lineName, mgc::Symbol stationName) const {
+    if (const auto *targets = validation.referrers.find(lineName)) {
+        auto it = targets->find(stationName);
+        if (it != targets->end() && !it->second.empty())
+            return true;
+    }
+    // Connections added since the last validation are not in the reverse index yet.
+    for (const auto &hub : *validation.dirtyHubs) {
+        auto hubLine = lines->find(hub.line);
+        auto st = hubLine == lines->end() ? nullptr : hubLine->second.tryFind(hub.station);
+        auto *ts = dynamic_cast<const transition_station *>(st.get());
+        if (!ts)
+            continue;
+        for (const auto &conn : ts->get_station_list()) {
+            if (conn.first == stationName && conn.second == lineName)
+                return true;
+        }
+    }
+    return false;
+}
+
+void MetroSystem::stationAdded(const Line &line, const shared_ptr<station> &st) {
+    if (routeCache.size() == 0)
+        return;
+    // A station that no transfer leads to or from is a dead end of its line:
+    // it cannot shorten any cached route, only add origins to queries by its name.
+    bool connects = isTransferTarget(line.getNameSymbol(), st->getNameSymbol());
+    if (auto *ts = dynamic_cast<const transition_station *>(st.get())) {
+        for (const auto &conn : ts->get_station_list())
+            connects = connects || hasStation(conn.second, conn.first);
+    }
+    if (connects)
+        routeCache.clear();
+    else
+        routeCache.invalidateEndpoint(st->getNameSymbol());
+}
+
+void MetroSystem::addLine(std::string_view lineName) {
+    METRO_METRIC_SCOPE(AddLine);
+    mgc::Symbol key(lineName);
+    if (lines->contains(key))
+        throw std::invalid_argument("Error: A line with this name already exists.");
+    lines.edit().emplace(key, Line(lineName, storage));
+    routeGraph.reset();
+    METRO_METRIC_SUCCEED();
+}
+
+void MetroSystem::removeLine(std::string_view lineName) {
+    METRO_METRIC_SCOPE(RemoveLine);
+    Line &line = editableLine(lineName);
+    mgc::Symbol key = line.getNameSymbol();
+    std::vector<mgc::Symbol> names;
+    names.reserve(line.getStations().size());
+    for (const auto &stationPair : line.getStations()) {
+        unindexStation(line, stationPair.first);
+        names.push_back(stationPair.first);
+    }
+    lines.edit().erase(key);
+    validation.dirtyLines.edit().insert(key);
+    routeGraph.reset();
+    routeCache.invalidateRemovedLine(key, std::move(names));
+    METRO_METRIC_SUCCEED();
+}
+
+void MetroSystem::addStation(Line &line, station &&st) {
+    if (st.getKind() == StationKind::Transition) {
+        addStation(line, transition_station(st.getName()));
+        return;
+    }
+    line.addElement(std::move(st));
+    indexStation(line, line.getStations().back().second);
+    stationAdded(line, line.getStations().back().second);
+}
+
+void MetroSystem::addStation(Line &line, transition_station &&st) {
+    line.addElement(std::move(st));
+    indexStation(line, line.getStations().back().second);
+    validation.dirtyHubs.edit().insert(StationKey{line.getNameSymbol(), line.getStations().back().first});
+    stationAdded(line, line.getStations().back().second);
+}
+
+void MetroSystem::addStationToLine(std::string_view lineName, station &&st) {
+    METRO_METRIC_SCOPE(AddStation);
+    addStation(editableLine(lineName), std::move(st));
+    routeGraph.reset();
+    METRO_METRIC_SUCCEED();
+}
+
+void MetroSystem::addStationToLine(std::string_view lineName, transition_station &&st) {
+    METRO_METRIC_SCOPE(AddStation);
+    addStation(editableLine(lineName), std::move(st));
+    routeGraph.reset();
+    METRO_METRIC_SUCCEED();
+}
+
+void MetroSystem::addStationsToLine(std::string_view lineName, std::span<const StationSpec> stations) {
+    METRO_METRIC_SCOPE(AddStation);
+    Line &line = editableLine(lineName);
+    size_t first = line.getStations().size();
+    line.reserve(first + stations.size());
+    stationIndex.reserve(stationIndex.size() + stations.size());
+    size_t added = 0;
+    try {
+        for (const auto &spec : stations) {
+            if (spec.type == "transition")
+                line.addElement(transition_station(spec.name));
+            else
+                line.addElement(station(spec.name, spec.type));
+            ++added;
+        }
+    } catch (...) {
+        for (size_t i = added; i > 0; --i)
+            line.removeElement(stations[i - 1].name);
+        throw;
+    }
+    const auto &table = line.getStations();
+    for (size_t slot = first; slot < table.size(); ++slot) {
+        indexStation(line, table[slot].second);
+        if (table[slot].second->getKind() == StationKind::Transition)
+            validation.dirtyHubs.edit().insert(StationKey{line.getNameSymbol(), table[slot].first});
+        stationAdded(line, table[slot].second);
+    }
+    routeGraph.reset();
+    METRO_METRIC_SUCCEED();
+}
+
+void MetroSystem::removeStationFromLine(std::string_view lineName, std::string_view stationName) {
+    METRO_METRIC_SCOPE(RemoveStation);
+    Line &line = editableLine(lineName);
+    auto known = mgc::Symbol::find(stationName);
+    size_t slot = known ? line.getStations().find(*known) : line.getStations().size();
+    bool inner = slot > 0 && slot + 1 < line.getStations().size();
+    line.removeElement(stationName);
+    mgc::Symbol key = *known;
+    unindexStation(line, key);
+    validation.dirtyTargets.edit().insert(StationKey{line.getNameSymbol(), key});
+    routeGraph.reset();
+    // Its neighbours become adjacent, which shortens rides along the line.
+    if (inner) {
+        routeCache.clear();
     } else {
-        station s(newName, newType);
-        it->second.addElement(std::move(s));
+        routeCache.invalidateLine(line.getNameSymbol());
+        routeCache.invalidateEndpoint(key);
     }
+    METRO_METRIC_SUCCEED();
 }
 
-std::shared_ptr<station> MetroSystem::findStationOnLine(const string &lineName,
-                                                        const string &stationName) const {
-    auto it = lines.find(lineName);
-    if (it == lines.end())
-        throw std::invalid_argument("Error: Line not found.");
-    return it->second.find(stationName);
+void MetroSystem::modifyStation(Line &line, std::string_view stationName,
+                                std::string_view newName, std::string_view newType) {
+    if (newType == "transition")
+        line.replaceElement(stationName, transition_station(newName));
+    else
+        line.replaceElement(stationName, station(newName, newType));
+    mgc::Symbol key = *mgc::Symbol::find(stationName);
+    unindexStation(line, key);
+    validation.dirtyTargets.edit().insert(StationKey{line.getNameSymbol(), key});
+    auto st = line.find(newName);
+    indexStation(line, st);
+    if (st->getKind() == StationKind::Transition)
+        validation.dirtyHubs.edit().insert(StationKey{line.getNameSymbol(), st->getNameSymbol()});
+    if (st->getNameSymbol() != key && isTransferTarget(line.getNameSymbol(), st->getNameSymbol())) {
+        routeCache.clear();
+    } else {
+        routeCache.invalidateLine(line.getNameSymbol());
+        routeCache.invalidateEndpoint(st->getNameSymbol());
+        if (st->getNameSymbol() != key)
+            routeCache.invalidateEndpoint(key);
+    }
 }
 
-std::shared_ptr<station> MetroSystem::findTransitionStationByName(const string &transitionStationName) const {
-    for (const auto &linePair : lines) {
-        try {
-            auto st = linePair.second.find(transitionStationName);
-            if (st->getType() == "transition")
-                return st;
+void MetroSystem::modifyStationInLine(std::string_view lineName,
+                                      std::string_view stationName,
+                                      std::string_view newName,
+                                      std::string_view newType) {
+    METRO_METRIC_SCOPE(ModifyStation);
+    modifyStation(editableLine(lineName), stationName, newName, newType);
+    routeGraph.reset();
+    METRO_METRIC_SUCCEED();
+}
+
+std::shared_ptr<station> MetroSystem::findStationOnLine(std::string_view lineName,
+                                                        std::string_view stationName) const {
+    METRO_METRIC_SCOPE(FindStationOnLine);
+    auto st = findLine(lineName).find(stationName);
+    METRO_METRIC_SUCCEED();
+    return st;
+}
+
+std::shared_ptr<station> MetroSystem::tryFindStationOnLine(std::string_view lineName,
+                                                           std::string_view stationName) const noexcept {
+    const Line *line = tryFindLine(lineName);
+    if (!line)
+        return nullptr;
+    return line->tryFind(stationName);
+}
+
+std::shared_ptr<station> MetroSystem::findTransitionStationByName(std::string_view transitionStationName) const {
+    METRO_METRIC_SCOPE(FindTransitionStation);
+    auto st = tryFindTransitionStationByName(transitionStationName);
+    if (!st)
+        throw std::invalid_argument("Error: Transition station not found.");
+    METRO_METRIC_SUCCEED();
+    return st;
+}
+
+std::shared_ptr<station> MetroSystem::tryFindTransitionStationByName(std::string_view transitionStationName) const noexcept {
+    auto key = mgc::Symbol::find(transitionStationName);
+    if (!key)
+        return nullptr;
+    const auto *locations = stationIndex.find(*key);
+    if (!locations)
+        return nullptr;
+    for (const auto &loc : *locations) {
+        if (loc.st->getKind() == StationKind::Transition)
+            return loc.st;
+    }
+    return nullptr;
+}
+
+std::vector<string> MetroSystem::findLinesOfStation(std::string_view stationName) const {
+    std::vector<string> result;
+    auto key = mgc::Symbol::find(stationName);
+    if (!key)
+        return result;
+    if (const auto *locations = stationIndex.find(*key)) {
+        result.reserve(locations->size());
+        for (const auto &loc : *locations)
+            result.push_back(loc.line.str());
+    }
+    return result;
+}
+
+void MetroSystem::addTransfer(Line &line, std::string_view stationName,
+                              std::string_view targetStation, std::string_view targetLine) {
+    auto st = line.find(stationName);
+    if (!dynamic_cast<transition_station *>(st.get()))
+        throw std::invalid_argument("Error: Station is not a transition station.");
+    if (stationCopyOnWrite)
+        st = detachStation(line, st);
+    static_cast<transition_station &>(*st).add_station(targetStation, targetLine);
+    validation.dirtyHubs.edit().insert(StationKey{line.getNameSymbol(), st->getNameSymbol()});
+    auto targetLineKey = mgc::Symbol::find(targetLine);
+    auto targetKey = mgc::Symbol::find(targetStation);
+    if (targetLineKey && targetKey && hasStation(*targetLineKey, *targetKey))
+        routeCache.clear();
+}
+
+void MetroSystem::addTransfer(std::string_view lineName, std::string_view stationName,
+                              std::string_view targetStation, std::string_view targetLine) {
+    METRO_METRIC_SCOPE(AddTransfer);
+    addTransfer(editableLine(lineName), stationName, targetStation, targetLine);
+    routeGraph.reset();
+    METRO_METRIC_SUCCEED();
+}
+
+namespace {
+
+/// What a batch edit needs to know about a station as the edits before it left it.
+struct DraftStation {
+    bool present;
+    bool transition;
+    size_t connections;
+};
+
+/// A line as the edits of a batch checked so far leave it.
+struct DraftLine {
+    const Line *base;  ///< The line as it is now; nullptr if it was absent or removed by the batch.
+    bool exists;
+    std::unordered_map<std::string_view, DraftStation> stations; ///< Stations the batch touched.
+
+    DraftStation station(std::string_view name) const {
+        auto it = stations.find(name);
+        if (it != stations.end())
+            return it->second;
+        auto st = base ? base->tryFind(name) : nullptr;
+        if (!st)
+            return {false, false, 0};
+        auto *ts = dynamic_cast<const transition_station *>(st.get());
+        return {true, st->getKind() == StationKind::Transition, ts ? ts->get_station_list().size() : 0};
+    }
+};
+
+} // namespace
+
+void MetroSystem::checkBatch(std::span<const SystemEdit> edits) const {
+    // Keyed by the names of the edits, so that a rejected batch interns nothing.
+    std::unordered_map<std::string_view, DraftLine> drafts;
+    for (size_t i = 0; i < edits.size(); ++i) {
+        const SystemEdit &edit = edits[i];
+        auto fail = [i](const char *reason) {
+            throw std::invalid_argument("Error: Batch edit " + std::to_string(i) + ": " + reason);
+        };
+        auto [it, fresh] = drafts.try_emplace(edit.line);
+        DraftLine &draft = it->second;
+        if (fresh) {
+            draft.base = tryFindLine(edit.line);
+            draft.exists = draft.base != nullptr;
+        }
+        if (edit.kind == EditKind::AddLine) {
+            if (draft.exists)
+                fail("A line with this name already exists.");
+            draft.exists = true;
+            continue;
+        }
+        if (!draft.exists)
+            fail("Line not found.");
+        std::string_view stationKey = edit.station;
+        switch (edit.kind) {
+        case EditKind::RemoveLine:
+            draft = DraftLine{nullptr, false, {}};
+            break;
+        case EditKind::AddStation:
+            if (draft.station(stationKey).present)
+                fail("Station already exists on this line.");
+            draft.stations[stationKey] = {true, edit.type == "transition", 0};
+            break;
+        case EditKind::RemoveStation:
+            if (!draft.station(stationKey).present)
+                fail("Station not found in line.");
+            draft.stations[stationKey] = {false, false, 0};
+            break;
+        case EditKind::ModifyStation: {
+            if (!draft.station(stationKey).present)
+                fail("Station not found in line.");
+            std::string_view newKey = edit.name;
+            if (newKey != stationKey && draft.station(newKey).present)
+                fail("Station already exists on this line.");
+            draft.stations[stationKey] = {false, false, 0};
+            draft.stations[newKey] = {true, edit.type == "transition", 0};
+            break;
         }
-        catch (...) {
+        case EditKind::AddTransfer: {
+            DraftStation hub = draft.station(stationKey);
+            if (!hub.present)
+                fail("Station not found in line.");
+            if (!hub.transition)
+                fail("Station is not a transition station.");
+            if (hub.connections >= transfer_hub::capacity)
+                fail("The capacity of the transfer_hub cannot exceed 3.");
+            ++hub.connections;
+            draft.stations[stationKey] = hub;
+            break;
+        }
+        case EditKind::AddLine:
+            break;
         }
     }
-    throw std::invalid_argument("Error: Transition station not found.");
-}
-
-void MetroSystem::validateSystem() {
-    std::for_each(lines.begin(), lines.end(), [this](auto &linePair) {
-        Line &line = linePair.second;
-        std::for_each(line.getStations().begin(), line.getStations().end(), [this](const auto &stationPair) {
-            if (stationPair.second->getType() == "transition") {
-                transition_station* ts = dynamic_cast<transition_station*>(stationPair.second.get());
-                if (ts) {
-                    auto &connections = ts->get_station_list();
-                    auto new_end = std::remove_if(connections.begin(), connections.end(),
-                        [this](const std::pair<string, string>& conn) -> bool {
-                            const string &targetStation = conn.first;
-                            const string &targetLine = conn.second;
-                            auto targetLineIt = lines.find(targetLine);
-                            if (targetLineIt == lines.end())
-                                return true;
-                            try {
-                                targetLineIt->second.find(targetStation);
-                                return false;
-                            } catch (...) {
-                                return true;
-                            }
-                        });
-                    connections.erase(new_end, connections.end());
-                }
+}
+
+size_t MetroSystem::applyBatch(std::span<const SystemEdit> edits) {
+    METRO_METRIC_SCOPE(ApplyBatch);
+    checkBatch(edits);
+    routeCache.clear();
+    // Edits of different lines do not interact, so each line's edits run in one go.
+    std::vector<mgc::Symbol> order;
+    std::unordered_map<mgc::Symbol, std::vector<const SystemEdit *>> byLine;
+    for (const auto &edit : edits) {
+        auto &group = byLine[mgc::Symbol(edit.line)];
+        if (group.empty())
+            order.push_back(mgc::Symbol(edit.line));
+        group.push_back(&edit);
+    }
+    auto &editable = lines.edit();
+    for (mgc::Symbol lineKey : order) {
+        auto lineIt = editable.find(lineKey);
+        Line *line = lineIt == editable.end() ? nullptr : &lineIt->second;
+        std::unordered_set<mgc::Symbol> pending; ///< Removals not yet compacted out of the line.
+        auto flush = [&] {
+            line->removeElements(pending);
+            for (mgc::Symbol name : pending) {
+                unindexStation(*line, name);
+                validation.dirtyTargets.edit().insert(StationKey{lineKey, name});
             }
+            pending.clear();
+        };
+        const auto &group = byLine[lineKey];
+        size_t adds = std::count_if(group.begin(), group.end(), [](const SystemEdit *edit) {
+            return edit->kind == EditKind::AddStation;
         });
-    });
+        if (line)
+            line->reserve(line->getStations().size() + adds);
+        for (const SystemEdit *edit : group) {
+            switch (edit->kind) {
+            case EditKind::AddLine:
+                line = &editable.emplace(lineKey, Line(edit->line, storage)).first->second;
+                line->reserve(adds);
+                break;
+            case EditKind::RemoveLine:
+                pending.clear();
+                for (const auto &stationPair : line->getStations())
+                    unindexStation(*line, stationPair.first);
+                editable.erase(lineKey);
+                validation.dirtyLines.edit().insert(lineKey);
+                line = nullptr;
+                break;
+            case EditKind::AddStation:
+                if (pending.contains(mgc::Symbol(edit->station)))
+                    flush();
+                addStation(*line, station(edit->station, edit->type));
+                break;
+            case EditKind::RemoveStation:
+                pending.insert(mgc::Symbol(edit->station));
+                break;
+            case EditKind::ModifyStation:
+                if (pending.contains(mgc::Symbol(edit->name)))
+                    flush();
+                modifyStation(*line, edit->station, edit->name, edit->type);
+                break;
+            case EditKind::AddTransfer:
+                addTransfer(*line, edit->station, edit->name, edit->targetLine);
+                break;
+            }
+        }
+        if (line && !pending.empty())
+            flush();
+    }
+    routeGraph.reset();
+    size_t removed = validateSystem(ValidationMode::Incremental);
+    METRO_METRIC_SUCCEED();
+    return removed;
+}
+
+bool MetroSystem::hasStation(mgc::Symbol lineName, mgc::Symbol stationName) const noexcept {
+    auto it = lines->find(lineName);
+    if (it == lines->end())
+        return false;
+    const auto &table = it->second.getStations();
+    return table.find(stationName) != table.size();
+}
+
+template<typename Stale>
+size_t MetroSystem::pruneHub(shared_ptr<station> st, const StationKey &hub, bool anyStale, Stale stale) {
+    // Only a station about to be detached needs its line, and so the line map, to itself.
+    if (anyStale && stationCopyOnWrite)
+        st = detachStation(lines.edit().find(hub.line)->second, st);
+    auto &connections = static_cast<transition_station &>(*st).get_station_list();
+    size_t before = connections.size();
+    if (anyStale) {
+        connections.remove_if(stale);
+        routeCache.invalidateLine(hub.line);
+    }
+    for (const auto &conn : connections) {
+        auto &sources = validation.referrers.edit(conn.second)[conn.first];
+        if (std::find(sources.begin(), sources.end(), hub) == sources.end())
+            sources.push_back(hub);
+    }
+    return before - connections.size();
+}
+
+size_t MetroSystem::validateHub(const StationKey &hub) {
+    auto lineIt = lines->find(hub.line);
+    if (lineIt == lines->end())
+        return 0;
+    auto st = lineIt->second.tryFind(hub.station);
+    if (!st || st->getKind() != StationKind::Transition)
+        return 0;
+    auto *ts = dynamic_cast<transition_station *>(st.get());
+    if (!ts)
+        return 0;
+    auto stale = [this](const transfer_hub::connection &conn) {
+        return !hasStation(conn.second, conn.first);
+    };
+    bool anyStale = std::ranges::any_of(ts->get_station_list(), stale);
+    return pruneHub(std::move(st), hub, anyStale, stale);
+}
+
+size_t MetroSystem::validateAll() {
+    validation = ValidationState{};
+    // Listed first: pruning may give a line shared with a copy its own columns.
+    std::vector<StationKey> hubs;
+    for (const auto &linePair : *lines) {
+        auto kinds = linePair.second.getKindColumn();
+        auto names = linePair.second.getNameColumn();
+        for (size_t slot = 0; slot < kinds.size(); ++slot) {
+            if (kinds[slot] == StationKind::Transition)
+                hubs.push_back(StationKey{linePair.first, names[slot]});
+        }
+    }
+    size_t removed = 0;
+    for (const auto &hub : hubs)
+        removed += validateHub(hub);
+    return removed;
+}
+
+size_t MetroSystem::validateAllParallel(unsigned threads) {
+    /// A transition station and the connections found stale, one bit each in list order.
+    struct HubCheck {
+        size_t slot;
+        uint64_t stale;
+        bool recheck; ///< More connections than bits; checked again by validateHub().
+    };
+    // Scanned through the shared map; pruneHub() takes a line for itself only to prune it.
+    std::vector<const Line *> lineRefs;
+    lineRefs.reserve(lines->size());
+    for (const auto &linePair : *lines)
+        lineRefs.push_back(&linePair.second);
+    threads = static_cast<unsigned>(std::min<size_t>(threads, std::max<size_t>(lineRefs.size(), 1)));
+    std::vector<std::vector<HubCheck>> checks(lineRefs.size());
+    std::atomic<size_t> nextLine{0};
+    std::vector<std::exception_ptr> errors(threads);
+    auto worker = [&](unsigned id) {
+        try {
+            for (size_t i; (i = nextLine.fetch_add(1, std::memory_order_relaxed)) < lineRefs.size();) {
+                const Line &line = *lineRefs[i];
+                auto kinds = line.getKindColumn();
+                auto &found = checks[i];
+                found.reserve(line.countOfKind(StationKind::Transition));
+                for (size_t slot = 0; slot < kinds.size(); ++slot) {
+                    if (kinds[slot] != StationKind::Transition)
+                        continue;
+                    auto *ts = dynamic_cast<const transition_station *>(line.getStations()[slot].second.get());
+                    if (!ts)
+                        continue;
+                    const auto &connections = ts->get_station_list();
+                    HubCheck check{slot, 0, connections.size() > 64};
+                    unsigned bit = 0;
+                    for (auto it = connections.begin(); !check.recheck && it != connections.end(); ++it, ++bit) {
+                        if (!hasStation(it->second, it->first))
+                            check.stale |= uint64_t{1} << bit;
+                    }
+                    found.push_back(check);
+                }
+            }
+        } catch (...) {
+            errors[id] = std::current_exception();
+        }
+    };
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (unsigned id = 1; id < threads; ++id)
+        pool.emplace_back(worker, id);
+    worker(0);
+    for (auto &thread : pool)
+        thread.join();
+    for (const auto &error : errors) {
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+    validation = ValidationState{};
+    std::vector<mgc::Symbol> lineNames;
+    lineNames.reserve(lineRefs.size());
+    for (const Line *line : lineRefs)
+        lineNames.push_back(line->getNameSymbol());
+    size_t removed = 0;
+    for (size_t i = 0; i < lineNames.size(); ++i) {
+        for (const HubCheck &check : checks[i]) {
+            // Looked up again: pruning may have given this system a map of its own.
+            const Line &line = lines->find(lineNames[i])->second;
+            StationKey hub{lineNames[i], line.getNameColumn()[check.slot]};
+            if (check.recheck) {
+                removed += validateHub(hub);
+                continue;
+            }
+            auto stale = [mask = check.stale, bit = 0u](const transfer_hub::connection &) mutable {
+                return (mask >> bit++) & 1;
+            };
+            removed += pruneHub(line.getStations()[check.slot].second, hub, check.stale != 0, stale);
+        }
+    }
+    return removed;
 }
 
+size_t MetroSystem::validateSystem(ValidationMode mode, unsigned threads) {
+    METRO_METRIC_SCOPE(ValidateSystem);
+    size_t removed = 0;
+    if (mode == ValidationMode::Full) {
+        removed = validateAll();
+    } else if (mode == ValidationMode::Parallel) {
+        if (threads == 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        removed = validateAllParallel(threads);
+    } else {
+        auto &referrers = validation.referrers;
+        for (const auto &hub : *validation.dirtyHubs)
+            removed += validateHub(hub);
+        // Sources are taken out of the reverse index before re-checking them;
+        // validateHub() registers the ones whose connection is still valid.
+        for (const auto &target : *validation.dirtyTargets) {
+            const auto *lineTargets = referrers.find(target.line);
+            if (!lineTargets || !lineTargets->contains(target.station))
+                continue;
+            auto &editable = *referrers.findForEdit(target.line);
+            auto stationIt = editable.find(target.station);
+            auto sources = std::move(stationIt->second);
+            editable.erase(stationIt);
+            for (const auto &source : sources)
+                removed += validateHub(source);
+        }
+        for (const auto &lineName : *validation.dirtyLines) {
+            auto *lineTargets = referrers.findForEdit(lineName);
+            if (!lineTargets)
+                continue;
+            auto targets = std::move(*lineTargets);
+            referrers.erase(lineName);
+            for (const auto &target : targets) {
+                for (const auto &source : target.second)
+                    removed += validateHub(source);
+            }
+        }
+        validation.dirtyHubs = {};
+        validation.dirtyTargets = {};
+        validation.dirtyLines = {};
+    }
+    // Full validation is how connections added behind the system's back are picked up.
+    if (mode != ValidationMode::Incremental)
+        routeCache.clear();
+    routeGraph.reset();
+    METRO_METRIC_SUCCEED();
+    return removed;
+}
 
 std::string MetroSystem::getSystemDescription() const {
     string oss;
-    for (const auto &linePair : lines) {
-        oss += "Line: " + linePair.first + "\n";
-        oss += linePair.second.getTableStr() + "\n";
-    }
+    mgc::TextSink out(oss);
+    writeSystemDescription(out);
     return oss;
 }
 
+size_t MetroSystem::getSystemDescriptionSize() const noexcept {
+    size_t total = 0;
+    for (const auto &linePair : *lines)
+        total += 8 + linePair.first.str().size() + linePair.second.getTableSize();
+    return total;
+}
+
+void MetroSystem::writeSystemDescription(mgc::TextSink &out) const {
+    if (out.appendsToString())
+        out.reserve(getSystemDescriptionSize());
+    for (const auto &linePair : *lines) {
+        out.append("Line: ");
+        out.append(linePair.first.str());
+        out.put('\n');
+        linePair.second.writeTable(out);
+        out.put('\n');
+    }
+}
+
+std::ostream &MetroSystem::writeSystemDescription(std::ostream &ost) const {
+    mgc::TextSink out(ost);
+    writeSystemDescription(out);
+    return ost;
+}
+
+void MetroSystem::writeSystemDescription(int fd) const {
+    mgc::TextSink out(fd);
+    writeSystemDescription(out);
+    out.flush();
+}
+
+const RouteGraph &MetroSystem::currentRouteGraph() const {
+    if (!routeGraph) {
+        std::vector<const Line *> lineRefs;
+        lineRefs.reserve(lines->size());
+        for (const auto &linePair : *lines)
+            lineRefs.push_back(&linePair.second);
+        routeGraph = std::make_shared<const RouteGraph>(RouteGraph::build(lineRefs));
+        hierarchies = {};
+    }
+    return *routeGraph;
+}
+
+const ContractionHierarchy &MetroSystem::currentHierarchy(RouteCost cost) const {
+    const RouteGraph &graph = currentRouteGraph();
+    auto &hierarchy = hierarchies[static_cast<size_t>(cost)];
+    if (!hierarchy)
+        hierarchy = std::make_shared<const ContractionHierarchy>(ContractionHierarchy::build(graph.view(), cost));
+    return *hierarchy;
+}
+
+std::optional<RoutePath> MetroSystem::searchRoute(std::span<const uint32_t> from, std::span<const uint32_t> to,
+                                                  RouteCost cost) const {
+    if (routePreprocessing)
+        return hierarchyFinder.search(currentHierarchy(cost), from, to);
+    return routeFinder.search(currentRouteGraph().view(), from, to, cost);
+}
+
+std::optional<Route> MetroSystem::findRoute(std::string_view fromLine, std::string_view fromStation,
+                                            std::string_view toLine, std::string_view toStation,
+                                            RouteCost cost) const {
+    auto fromLineKey = mgc::Symbol::find(fromLine);
+    auto fromKey = mgc::Symbol::find(fromStation);
+    auto toLineKey = mgc::Symbol::find(toLine);
+    auto toKey = mgc::Symbol::find(toStation);
+    std::optional<RouteKey> key;
+    if (fromLineKey && fromKey && toLineKey && toKey) {
+        key = RouteKey{*fromLineKey, *fromKey, *toLineKey, *toKey, cost};
+        if (const auto *cached = routeCache.find(*key))
+            return *cached;
+    }
+    const RouteGraph &graph = currentRouteGraph();
+    auto from = graph.node(fromLine, fromStation);
+    auto to = graph.node(toLine, toStation);
+    if (!from || !to)
+        throw std::invalid_argument("Error: Station not found on this line.");
+    auto path = searchRoute(std::span(&*from, 1), std::span(&*to, 1), cost);
+    std::optional<Route> route;
+    if (path)
+        route = graph.toRoute(*path);
+    routeCache.insert(*key, route);
+    return route;
+}
+
+std::optional<Route> MetroSystem::findRoute(std::string_view fromStation, std::string_view toStation,
+                                            RouteCost cost) const {
+    auto fromKey = mgc::Symbol::find(fromStation);
+    auto toKey = mgc::Symbol::find(toStation);
+    std::optional<RouteKey> key;
+    if (fromKey && toKey) {
+        key = RouteKey{mgc::Symbol(), *fromKey, mgc::Symbol(), *toKey, cost, true};
+        if (const auto *cached = routeCache.find(*key))
+            return *cached;
+    }
+    const RouteGraph &graph = currentRouteGraph();
+    auto from = graph.nodesNamed(fromStation);
+    auto to = graph.nodesNamed(toStation);
+    if (from.empty() || to.empty())
+        throw std::invalid_argument("Error: Station not found.");
+    auto path = searchRoute(from, to, cost);
+    std::optional<Route> route;
+    if (path)
+        route = graph.toRoute(*path);
+    routeCache.insert(*key, route);
+    return route;
+}
+
 } // namespace mgm
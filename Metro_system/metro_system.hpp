@@ -2,13 +2,100 @@
 #define METRO_SYSTEM_HPP_
 
 #include "../line/metro_line.hpp"
+#include "metrics.hpp"
 #include "../Stations/station.hpp"
+#include "../Stations/transitionstation.hpp"
+#include "../routing/route_graph.hpp"
+#include "../routing/route_cache.hpp"
+#include "../routing/contraction_hierarchy.hpp"
+#include "../container/cowPtr.hpp"
+#include "../container/persistentMap.hpp"
+#include <array>
 #include <unordered_map>
+#include <unordered_set>
 #include <string>
+#include <string_view>
 #include <memory>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
 
 namespace mgm {
 
+/**
+ * @brief How much of the system validateSystem() checks.
+ */
+enum class ValidationMode {
+    Incremental, ///< Only connections that changed or reference something changed.
+    Full,        ///< Every connection of every transition station.
+    Parallel     ///< Like Full, with the lines checked by several threads.
+};
+
+/**
+ * @brief Description of a station to add in bulk.
+ */
+struct StationSpec {
+    string name;            ///< The name of the station.
+    string type = "Direct"; ///< The type of the station; "transition" makes a transition_station.
+};
+
+/**
+ * @brief Kinds of edit accepted by MetroSystem::applyBatch().
+ */
+enum class EditKind : uint8_t {
+    AddLine,       ///< Add the line @c line.
+    RemoveLine,    ///< Remove the line @c line.
+    AddStation,    ///< Append @c station of type @c type to @c line.
+    RemoveStation, ///< Remove @c station from @c line.
+    ModifyStation, ///< Replace @c station on @c line by @c name of type @c type, in place.
+    AddTransfer    ///< Connect transition station @c station on @c line to @c name on @c targetLine.
+};
+
+/**
+ * @brief One edit of a batch; build it with the named constructors.
+ */
+struct SystemEdit {
+    EditKind kind = EditKind::AddLine; ///< What the edit does.
+    string line;            ///< The line edited, or the line of the station edited.
+    string station;         ///< The station added, removed, modified or given a transfer.
+    string name;            ///< The new name of a modified station, or the target station of a transfer.
+    string type = "Direct"; ///< The type of an added or modified station.
+    string targetLine;      ///< The line of the target station of a transfer.
+
+    static SystemEdit addLine(string line) { return make(EditKind::AddLine, std::move(line), {}); }
+    static SystemEdit removeLine(string line) { return make(EditKind::RemoveLine, std::move(line), {}); }
+    static SystemEdit addStation(string line, string station, string type = "Direct") {
+        SystemEdit edit = make(EditKind::AddStation, std::move(line), std::move(station));
+        edit.type = std::move(type);
+        return edit;
+    }
+    static SystemEdit removeStation(string line, string station) {
+        return make(EditKind::RemoveStation, std::move(line), std::move(station));
+    }
+    static SystemEdit modifyStation(string line, string station, string newName, string newType) {
+        SystemEdit edit = make(EditKind::ModifyStation, std::move(line), std::move(station));
+        edit.name = std::move(newName);
+        edit.type = std::move(newType);
+        return edit;
+    }
+    static SystemEdit addTransfer(string line, string station, string targetStation, string targetLine) {
+        SystemEdit edit = make(EditKind::AddTransfer, std::move(line), std::move(station));
+        edit.name = std::move(targetStation);
+        edit.targetLine = std::move(targetLine);
+        return edit;
+    }
+
+private:
+    static SystemEdit make(EditKind kind, string line, string station) {
+        SystemEdit edit;
+        edit.kind = kind;
+        edit.line = std::move(line);
+        edit.station = std::move(station);
+        return edit;
+    }
+};
+
 /**
  * @brief Represents the metro system, managing lines and stations.
  *
@@ -16,56 +103,210 @@ namespace mgm {
  * as well as search for stations and validate the system configuration.
  */
 class MetroSystem {
-    std::unordered_map<string, Line> lines;
+    /**
+     * @brief An occurrence of a station name on a line.
+     */
+    struct StationLocation {
+        mgc::Symbol line;             ///< The name of the line the station is on.
+        shared_ptr<station> st;       ///< The station object stored in that line.
+    };
+
+    /**
+     * @brief A station on a line, by interned names.
+     */
+    struct StationKey {
+        mgc::Symbol line;    ///< The name of the line.
+        mgc::Symbol station; ///< The name of the station.
+        bool operator==(const StationKey &) const noexcept = default;
+    };
+
+    struct StationKeyHash {
+        size_t operator()(const StationKey &key) const noexcept {
+            return (static_cast<size_t>(key.line.id()) << 32) | key.station.id();
+        }
+    };
+
+    /**
+     * @brief Bookkeeping for incremental validation.
+     *
+     * The mutation methods record what changed since the last validateSystem() call;
+     * referrers remembers which transition stations point at which station, so that
+     * a removed station or line leads straight to the connections to re-check. Like
+     * the lines, all of it is shared with copies of the system until edited.
+     */
+    struct ValidationState {
+        mgc::CowPtr<std::unordered_set<StationKey, StationKeyHash>> dirtyHubs;    ///< Transition stations with new connections.
+        mgc::CowPtr<std::unordered_set<StationKey, StationKeyHash>> dirtyTargets; ///< Stations removed or renamed.
+        mgc::CowPtr<std::unordered_set<mgc::Symbol>> dirtyLines;                  ///< Lines removed.
+        /// Target line -> target station -> transition stations connected to it.
+        mgc::PersistentMap<mgc::Symbol, std::unordered_map<mgc::Symbol, std::vector<StationKey>>> referrers;
+    };
+
+    /// Shared with copies of the system; each line shares its stations with its copies as well.
+    mgc::CowPtr<std::unordered_map<mgc::Symbol, Line>> lines;
+    /// Station name -> every line it is on; kept current by the mutation methods. Removing
+    /// a line touches names in most shards, so they are small: about 25 names each at 100k.
+    mgc::PersistentMap<mgc::Symbol, std::vector<StationLocation>, std::hash<mgc::Symbol>, 12> stationIndex;
+    ValidationState validation;
+    StationStorage storage = StationStorage::Heap; ///< Storage mode of the lines this system creates.
+    bool stationCopyOnWrite = false; ///< Copy station objects instead of editing them in place.
+    /// Built on the first route query after a change; shared with copies made before the next one.
+    mutable std::shared_ptr<const RouteGraph> routeGraph;
+    mutable RouteFinder routeFinder;              ///< Search state reused by route queries.
+    mutable RouteCache routeCache;                ///< Results of recent route queries.
+    bool routePreprocessing = false;              ///< Answer route queries from contraction hierarchies.
+    /// Per RouteCost, built on the first query after the routing graph was.
+    mutable std::array<std::shared_ptr<const ContractionHierarchy>, 2> hierarchies;
+    mutable HierarchyFinder hierarchyFinder;      ///< Search state reused by hierarchy queries.
+
+    const RouteGraph &currentRouteGraph() const;
+    const ContractionHierarchy &currentHierarchy(RouteCost cost) const;
+    std::optional<RoutePath> searchRoute(std::span<const uint32_t> from, std::span<const uint32_t> to,
+                                         RouteCost cost) const;
+    Line &editableLine(std::string_view lineName);
+    void indexStation(const Line &line, const shared_ptr<station> &st);
+    void unindexStation(const Line &line, mgc::Symbol stationName);
+    bool isTransferTarget(mgc::Symbol lineName, mgc::Symbol stationName) const;
+    void stationAdded(const Line &line, const shared_ptr<station> &st);
+    shared_ptr<station> detachStation(Line &line, const shared_ptr<station> &st);
+    void addStation(Line &line, station &&st);
+    void addStation(Line &line, transition_station &&st);
+    void modifyStation(Line &line, std::string_view stationName, std::string_view newName, std::string_view newType);
+    void addTransfer(Line &line, std::string_view stationName, std::string_view targetStation, std::string_view targetLine);
+    void checkBatch(std::span<const SystemEdit> edits) const;
+    bool hasStation(mgc::Symbol lineName, mgc::Symbol stationName) const noexcept;
+    template<typename Stale>
+    size_t pruneHub(shared_ptr<station> st, const StationKey &hub, bool anyStale, Stale stale);
+    size_t validateHub(const StationKey &hub);
+    size_t validateAll();
+    size_t validateAllParallel(unsigned threads);
 public:
     /**
      * @brief Default constructor.
      */
     MetroSystem() = default;
+
+    /**
+     * @brief Constructs an empty system whose lines allocate stations as given.
+     *
+     * With StationStorage::Arena every line packs its stations into its own arena,
+     * and removeLine() or the destruction of the system frees them in bulk.
+     * Station pointers handed out stay valid as long as they are held.
+     *
+     * @param stationStorage Where lines added to this system allocate station objects.
+     */
+    explicit MetroSystem(StationStorage stationStorage) : storage(stationStorage) {}
+
+    /**
+     * @brief Copy constructor, O(1) in the size of the network.
+     *
+     * The copy shares the lines, the station objects, the indexes and the built routing
+     * structures with @p other. Either system copies a line, and the index shards it
+     * touches, on its first edit of them. Only the route cache is copied, and the route
+     * search state starts empty. To try out a scenario on a copy that validates or adds
+     * transfers without touching the original's stations, enable setStationCopyOnWrite().
+     *
+     * @param other The system to copy.
+     */
+    MetroSystem(const MetroSystem &other);
+
+    /**
+     * @brief Copy assignment operator; shares the network with @p other as the copy constructor does.
+     * @param other The system to copy.
+     * @return Reference to this system.
+     */
+    MetroSystem &operator=(const MetroSystem &other);
+
+    MetroSystem(MetroSystem &&) noexcept = default;
+    MetroSystem &operator=(MetroSystem &&) noexcept = default;
     
     /**
      * @brief Adds a new metro line.
      * @param lineName The name of the metro line to add.
      * @throws std::invalid_argument if a line with the same name already exists.
      */
-    void addLine(const string &lineName);
+    void addLine(std::string_view lineName);
 
     /**
      * @brief Removes a metro line.
      * @param lineName The name of the metro line to remove.
      * @throws std::invalid_argument if the line is not found.
      */
-    void removeLine(const string &lineName);
+    void removeLine(std::string_view lineName);
     
     /**
      * @brief Adds a station to a specified line.
+     *
+     * A station of type "transition" is stored as a transition_station, as in modifyStationInLine().
+     *
      * @param lineName The name of the metro line.
      * @param st The station to add.
      * @throws std::invalid_argument if the line is not found.
      */
-    void addStationToLine(const string &lineName, station &&st);
+    void addStationToLine(std::string_view lineName, station &&st);
+
+    /**
+     * @brief Adds a transition station, with its transfer connections, to a specified line.
+     * @param lineName The name of the metro line.
+     * @param st The transition station to add.
+     * @throws std::invalid_argument if the line is not found.
+     */
+    void addStationToLine(std::string_view lineName, transition_station &&st);
     
+    /**
+     * @brief Appends several stations to a specified line in one call.
+     *
+     * Capacity of the line and of the station name index is reserved once for the
+     * whole batch. Either all stations are added or, if one of them already exists
+     * on the line, none is.
+     *
+     * @param lineName The name of the metro line.
+     * @param stations The stations to append, in line order.
+     * @throws std::invalid_argument if the line is not found or a station already exists on it.
+     */
+    void addStationsToLine(std::string_view lineName, std::span<const StationSpec> stations);
+
     /**
      * @brief Removes a station from a specified line.
      * @param lineName The name of the metro line.
      * @param stationName The name of the station to remove.
      * @throws std::invalid_argument if the line is not found.
      */
-    void removeStationFromLine(const string &lineName, const string &stationName);
+    void removeStationFromLine(std::string_view lineName, std::string_view stationName);
     
     /**
      * @brief Modifies a station in a specified line.
+     *
+     * The station is replaced in place and keeps its position on the line.
+     *
      * @param lineName The name of the metro line.
      * @param stationName The name of the station to modify.
      * @param newName The new name for the station.
      * @param newType The new type for the station.
-     * @throws std::invalid_argument if the line is not found.
+     * @throws std::invalid_argument if the line or station is not found, or the new name is
+     *         already taken by another station of the line; the line is then left unchanged.
      */
-    void modifyStationInLine(const string &lineName,
-                             const string &stationName,
-                             const string &newName,
-                             const string &newType);
+    void modifyStationInLine(std::string_view lineName,
+                             std::string_view stationName,
+                             std::string_view newName,
+                             std::string_view newType);
     
+    /**
+     * @brief Applies a batch of edits as one unit and validates the result once.
+     *
+     * The whole batch is checked against the state it would produce before anything
+     * is changed: if any edit would fail, as the matching single call would, nothing is
+     * applied. Edits then run in order, grouped by line; removals from a line are
+     * compacted in one pass and the routing graph is invalidated once. Finally one
+     * incremental validateSystem() pass prunes connections the batch made dangling.
+     * Only an allocation failure while applying can leave the batch partly applied.
+     *
+     * @param edits The edits, in the order they would be made one by one.
+     * @return The number of connections removed by the validation pass.
+     * @throws std::invalid_argument naming the first edit that cannot be applied.
+     */
+    size_t applyBatch(std::span<const SystemEdit> edits);
+
     /**
      * @brief Finds a station by name on a specified line.
      * @param lineName The name of the metro line.
@@ -73,29 +314,270 @@ public:
      * @return A shared pointer to the station.
      * @throws std::invalid_argument if the line or station is not found.
      */
-    std::shared_ptr<station> findStationOnLine(const string &lineName,
-                                               const string &stationName) const;
+    std::shared_ptr<station> findStationOnLine(std::string_view lineName,
+                                               std::string_view stationName) const;
+
+    /**
+     * @brief Finds a station by name on a specified line without throwing.
+     * @param lineName The name of the metro line.
+     * @param stationName The name of the station.
+     * @return A shared pointer to the station, or an empty pointer if the line or station is not found.
+     */
+    std::shared_ptr<station> tryFindStationOnLine(std::string_view lineName,
+                                                  std::string_view stationName) const noexcept;
+
     /**
      * @brief Finds a transition station by name across all lines.
      * @param transitionStationName The name of the transition station.
      * @return A shared pointer to the transition station.
      * @throws std::invalid_argument if the transition station is not found.
      */
-    std::shared_ptr<station> findTransitionStationByName(const string &transitionStationName) const;
+    std::shared_ptr<station> findTransitionStationByName(std::string_view transitionStationName) const;
+
+    /**
+     * @brief Finds a transition station by name across all lines without throwing.
+     *
+     * Answered from the system-wide station name index, without visiting the lines.
+     *
+     * @param transitionStationName The name of the transition station.
+     * @return A shared pointer to the transition station, or an empty pointer if there is none.
+     */
+    std::shared_ptr<station> tryFindTransitionStationByName(std::string_view transitionStationName) const noexcept;
+
+    /**
+     * @brief Gets the names of all lines a station name is on.
+     * @param stationName The name of the station.
+     * @return The line names; empty if the station is on no line.
+     */
+    std::vector<string> findLinesOfStation(std::string_view stationName) const;
     
+    /**
+     * @brief Adds a transfer connection to a transition station.
+     * @param lineName The line of the transition station.
+     * @param stationName The name of the transition station.
+     * @param targetStation The station the connection leads to.
+     * @param targetLine The line of the station the connection leads to.
+     * @throws std::invalid_argument if the line or station is not found, the station is not
+     *         a transition station, or its transfer_hub is full.
+     */
+    void addTransfer(std::string_view lineName, std::string_view stationName,
+                     std::string_view targetStation, std::string_view targetLine);
+
     /**
      * @brief Validates the metro system configuration.
      *
      * For each transition station, checks all connections and removes those that refer
-     * to non-existent lines or stations.
+     * to non-existent lines or stations. The incremental mode only re-checks transition
+     * stations added or given connections through this class, and connections leading to
+     * stations or lines removed since the last validation; connections added directly
+     * through a station's transfer_hub need a full validation.
+     *
+     * The parallel mode does the work of the full one. Worker threads take lines one at a
+     * time and check the connections of their transition stations against the unchanged
+     * system; the calling thread then removes the stale connections found, so stations
+     * are only ever modified by one thread.
+     *
+     * @param mode Whether to check only what changed or the whole system.
+     * @param threads Number of threads for ValidationMode::Parallel, counting the calling
+     *        thread; 0 uses std::thread::hardware_concurrency().
+     * @return The number of connections removed.
      */
-    void validateSystem();
+    size_t validateSystem(ValidationMode mode = ValidationMode::Incremental, unsigned threads = 0);
     
     /**
      * @brief Gets a string description of the entire metro system.
      * @return A string containing the description of all lines and their stations.
      */
     std::string getSystemDescription() const;
+
+    /**
+     * @brief Gets the length of the system description.
+     * @return The number of bytes writeSystemDescription() produces.
+     */
+    size_t getSystemDescriptionSize() const noexcept;
+
+    /**
+     * @brief Writes the description of getSystemDescription() to a sink.
+     *
+     * Nothing is built in between, so with a reused string, a stream or a descriptor
+     * as the sink the description costs no allocations.
+     *
+     * @param out The sink; a string sink is grown once to the size of the description.
+     */
+    void writeSystemDescription(mgc::TextSink &out) const;
+
+    /**
+     * @brief Writes the system description to an output stream.
+     * @param ost The output stream.
+     * @return The output stream.
+     */
+    std::ostream &writeSystemDescription(std::ostream &ost) const;
+
+    /**
+     * @brief Writes the system description to a file descriptor.
+     * @param fd The descriptor, which stays open.
+     * @throws std::invalid_argument If the descriptor cannot be written.
+     */
+    void writeSystemDescription(int fd) const;
+
+    /**
+     * @brief Gets where the lines of this system allocate station objects.
+     * @return The storage mode.
+     */
+    StationStorage getStationStorage() const noexcept { return storage; }
+
+    /**
+     * @brief Sets whether station objects are copied before they are edited.
+     *
+     * Copies of a system share station objects, so by default adding a transfer or pruning
+     * connections during validation is seen through every copy and every pointer handed out.
+     * With copy-on-write enabled, addTransfer() and validateSystem() first replace the
+     * station with a private copy and edit that; older copies of the system and pointers
+     * obtained before keep seeing the station unchanged. The setting is copied along with
+     * the system.
+     *
+     * @param enabled true to copy stations before editing them.
+     */
+    void setStationCopyOnWrite(bool enabled) noexcept { stationCopyOnWrite = enabled; }
+
+    /**
+     * @brief Gets whether station objects are copied before they are edited.
+     * @return true if copy-on-write is enabled.
+     */
+    bool getStationCopyOnWrite() const noexcept { return stationCopyOnWrite; }
+
+    /**
+     * @brief Finds a line by name.
+     * @param lineName The name of the metro line.
+     * @return A constant reference to the line.
+     * @throws std::invalid_argument if the line is not found.
+     */
+    const Line &findLine(std::string_view lineName) const;
+
+    /**
+     * @brief Finds a line by name without throwing.
+     * @param lineName The name of the metro line.
+     * @return A pointer to the line, or nullptr if it is not found.
+     */
+    const Line *tryFindLine(std::string_view lineName) const noexcept;
+
+    /**
+     * @brief Provides access to the lines of the system.
+     * @return A constant reference to the map from interned line names to lines.
+     */
+    const std::unordered_map<mgc::Symbol, Line> &getLines() const { return *lines; }
+
+    /**
+     * @brief Finds the cheapest route between two stations on given lines.
+     *
+     * The routing graph is rebuilt lazily after the system changed, and results are kept
+     * in a route cache (see setRouteCacheCapacity()). Connections added directly to a
+     * station's transfer_hub, rather than through addTransfer(), are picked up after the
+     * next validateSystem() in ValidationMode::Full or ValidationMode::Parallel, or after
+     * clearRouteCache().
+     *
+     * @param fromLine The line of the origin station.
+     * @param fromStation The origin station.
+     * @param toLine The line of the destination station.
+     * @param toStation The destination station.
+     * @param cost The cost model.
+     * @return The route, or std::nullopt if the destination is unreachable.
+     * @throws std::invalid_argument if a line or station is not found.
+     */
+    std::optional<Route> findRoute(std::string_view fromLine, std::string_view fromStation,
+                                   std::string_view toLine, std::string_view toStation,
+                                   RouteCost cost = RouteCost::FewestStops) const;
+
+    /**
+     * @brief Finds the cheapest route between two stations on any of their lines.
+     * @param fromStation The origin station.
+     * @param toStation The destination station.
+     * @param cost The cost model.
+     * @return The route, or std::nullopt if the destination is unreachable.
+     * @throws std::invalid_argument if a station is not found on any line.
+     */
+    std::optional<Route> findRoute(std::string_view fromStation, std::string_view toStation,
+                                   RouteCost cost = RouteCost::FewestStops) const;
+
+    /**
+     * @brief Sets how many route query results are cached.
+     *
+     * findRoute() keeps its results, unreachable ones included, in a least-recently-used
+     * cache keyed by the interned names and the cost model. The mutation methods drop only
+     * the results they can change: an edit that can only remove or lengthen routes, such as
+     * removing a line, removing the first or last station of a line, renaming a station or
+     * pruning connections in validateSystem(), drops the routes that use the lines it
+     * touched. An edit that can open a new or shorter route anywhere, such as adding a
+     * transfer to an existing station, adding or renaming to a station some transfer
+     * already points at, or
+     * removing a station from the middle of a line, drops every result; so do
+     * applyBatch() and full validation. Appending a station nothing points at only drops
+     * the queries naming it.
+     *
+     * @param capacity Maximum number of cached results; 0 disables the cache.
+     */
+    void setRouteCacheCapacity(size_t capacity) { routeCache.setCapacity(capacity); }
+
+    /**
+     * @brief Gets the route cache counters.
+     * @return Hits, misses, evictions and invalidations since the last clearRouteCache().
+     */
+    const RouteCacheStats &getRouteCacheStats() const noexcept { return routeCache.stats(); }
+
+    /**
+     * @brief Drops every cached route and resets the route cache counters.
+     */
+    void clearRouteCache() {
+        routeCache.clear();
+        routeCache.resetStats();
+    }
+
+    /**
+     * @brief Sets whether route queries are answered from contraction hierarchies.
+     *
+     * With preprocessing enabled, the first findRoute() after the network changed
+     * contracts the routing graph for its cost model (see ContractionHierarchy), and
+     * later queries search only the few nodes above their endpoints in the hierarchy.
+     * Routes found have the same cost as without preprocessing. Worth it when many
+     * queries run between changes; the setting is copied along with the system.
+     *
+     * @param enabled true to preprocess the routing graph.
+     */
+    void setRoutePreprocessing(bool enabled) {
+        routePreprocessing = enabled;
+        if (!enabled)
+            hierarchies = {};
+    }
+
+    /**
+     * @brief Gets whether route queries are answered from contraction hierarchies.
+     * @return true if preprocessing is enabled.
+     */
+    bool getRoutePreprocessing() const noexcept { return routePreprocessing; }
+
+    /**
+     * @brief Gets the contraction hierarchy of the current network, building it if needed.
+     * @param cost The cost model.
+     * @return The hierarchy, valid until the next change of the system.
+     */
+    const ContractionHierarchy &getRouteHierarchy(RouteCost cost) const { return currentHierarchy(cost); }
+
+    /**
+     * @brief Takes a snapshot of the operation metrics of every MetroSystem in the process.
+     *
+     * Counts calls and failures of the lookups, validateSystem() and the mutation
+     * methods, with sampled latency histograms; see metrics.hpp. Empty unless built
+     * with the METRO_METRICS option.
+     *
+     * @return The snapshot; MetricsSnapshot::getText() and getJson() format it.
+     */
+    static MetricsSnapshot getMetrics() { return metrics::snapshot(); }
+
+    /**
+     * @brief Gets the routing graph of the current network, building it if needed.
+     * @return The routing graph, valid until the next change of the system.
+     */
+    const RouteGraph &getRouteGraph() const { return currentRouteGraph(); }
 };
 
 } // namespace mgm
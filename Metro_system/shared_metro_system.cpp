@@ -0,0 +1,18 @@
+#include "shared_metro_system.hpp"
+
+namespace mgm {
+
+SharedMetroSystem::SharedMetroSystem(MetroSystem initial) {
+    publish(std::make_shared<MetroSystem>(std::move(initial)));
+}
+
+uint64_t SharedMetroSystem::publish(std::shared_ptr<MetroSystem> next) {
+    next->setStationCopyOnWrite(true);
+    next->getRouteGraph();
+    current.store(std::move(next), std::memory_order_release);
+    uint64_t number = published.load(std::memory_order_relaxed) + 1;
+    published.store(number, std::memory_order_release);
+    return number;
+}
+
+} // namespace mgm
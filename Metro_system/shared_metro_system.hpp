@@ -0,0 +1,124 @@
+#ifndef SHARED_METRO_SYSTEM_HPP_
+#define SHARED_METRO_SYSTEM_HPP_
+
+#include "metro_system.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace mgm {
+
+/**
+ * @brief A MetroSystem shared between reader threads and occasional writers.
+ *
+ * The system is published as a chain of immutable versions. A writer copies the
+ * current version, edits the copy and publishes it atomically (copy-on-write, RCU
+ * style); writers are serialised among themselves, readers never wait for them.
+ * The copy is O(1) and shares the network with its version, so an update costs
+ * the lines and index shards it edits rather than the whole system.
+ * A reader pins a version by holding its shared pointer and can keep using it,
+ * and every station pointer it got from it, for as long as it likes; a version
+ * is freed when the last reader lets go of it.
+ *
+ * Published versions have station copy-on-write enabled, so a writer never edits
+ * a station object that an older version still holds, and their routing graph is
+ * built before publishing. All const queries of a pinned version are safe to call
+ * from any number of threads except findRoute(), which reuses per-system search
+ * state; concurrent route queries should run a RouteFinder of their own over
+ * getRouteGraph(). Station objects reached through a version must not be modified.
+ */
+class SharedMetroSystem {
+public:
+    /**
+     * @brief Pinned, immutable version of the system.
+     */
+    using Snapshot = std::shared_ptr<const MetroSystem>;
+
+    /**
+     * @brief Per-thread handle that pins the current version without touching shared reference counts.
+     *
+     * pin() compares the published version number with the one it holds and only
+     * reloads the snapshot pointer when a writer has published since, so readers on
+     * different cores do not contend on a reference count while nothing changes.
+     * The handle keeps its last version alive until the next pin() or its destruction.
+     * One Reader must not be used by several threads at once.
+     */
+    class Reader {
+    public:
+        /**
+         * @brief Creates a reader of a shared system.
+         * @param shared The system to read; must outlive the reader.
+         */
+        explicit Reader(const SharedMetroSystem &shared) : shared(&shared) {}
+
+        /**
+         * @brief Gets the latest published version.
+         * @return The version, valid until the next call of pin() on this reader.
+         */
+        const MetroSystem &pin() {
+            uint64_t latest = shared->version();
+            if (!pinned || latest != pinnedVersion) {
+                pinned = shared->snapshot();
+                pinnedVersion = latest;
+            }
+            return *pinned;
+        }
+
+    private:
+        const SharedMetroSystem *shared;
+        Snapshot pinned;
+        uint64_t pinnedVersion = 0;
+    };
+
+    /**
+     * @brief Publishes an initial system as version 1.
+     * @param initial The system to start from.
+     */
+    explicit SharedMetroSystem(MetroSystem initial = MetroSystem());
+
+    SharedMetroSystem(const SharedMetroSystem &) = delete;
+    SharedMetroSystem &operator=(const SharedMetroSystem &) = delete;
+
+    /**
+     * @brief Pins the latest published version.
+     * @return The version; it stays valid as long as the pointer is held.
+     */
+    Snapshot snapshot() const noexcept { return current.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Gets the number of the latest published version.
+     * @return The version number; it grows by one with each successful update().
+     */
+    uint64_t version() const noexcept { return published.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Edits a copy of the latest version and publishes it.
+     *
+     * The edit runs on a private copy, so it may make any number of calls and is
+     * seen by readers all at once. If it throws, nothing is published and the
+     * exception propagates.
+     *
+     * @param edit Callable taking MetroSystem &.
+     * @return The number of the published version.
+     */
+    template<typename Edit>
+    uint64_t update(Edit &&edit) {
+        std::lock_guard lock(writer);
+        auto next = std::make_shared<MetroSystem>(*current.load(std::memory_order_relaxed));
+        std::forward<Edit>(edit)(*next);
+        return publish(std::move(next));
+    }
+
+private:
+    uint64_t publish(std::shared_ptr<MetroSystem> next);
+
+    std::atomic<Snapshot> current;       ///< Latest published version.
+    std::atomic<uint64_t> published{0};  ///< Number of the latest published version.
+    std::mutex writer;                   ///< Serialises update().
+};
+
+} // namespace mgm
+
+#endif
@@ -1,7 +1,10 @@
 #ifndef STATION_HPP_
 #define STATION_HPP_
 
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include "../container/symbolTable.hpp"
 using std::string;
 
 /**
@@ -16,6 +19,17 @@ namespace mgm {
  */
 class station;
 
+/**
+ * @brief Kind of a station, derived from its type string.
+ *
+ * Lets hot paths classify stations with one byte compare instead of a string compare.
+ */
+enum class StationKind : uint8_t {
+    Direct,     ///< Type "Direct".
+    Transition, ///< Type "transition".
+    Other       ///< Any other type string.
+};
+
 /**
  * @brief Concept that checks if a type is derived from station.
  *
@@ -32,8 +46,30 @@ concept DerivedFromStation = std::is_base_of_v<station, T>;
  */
 class station {
 private:
-    string name; /**< The name of the station. */
-    string type; /**< The type of the station (e.g., "Direct", "transition"). */
+    mgc::Symbol name; /**< The interned name of the station. */
+    mgc::Symbol type; /**< The interned type of the station (e.g., "Direct", "transition"). */
+    StationKind kind; /**< The kind matching @c type. */
+
+    static StationKind kindOf(std::string_view tp) noexcept {
+        if (tp == "Direct")
+            return StationKind::Direct;
+        if (tp == "transition")
+            return StationKind::Transition;
+        return StationKind::Other;
+    }
+
+    static mgc::Symbol typeOf(std::string_view tp, StationKind kind) {
+        static const mgc::Symbol direct("Direct");
+        static const mgc::Symbol transition("transition");
+        switch (kind) {
+        case StationKind::Direct:
+            return direct;
+        case StationKind::Transition:
+            return transition;
+        default:
+            return mgc::Symbol(tp);
+        }
+    }
 public:
     /**
      * @brief Constructs a station with an optional name and type.
@@ -41,42 +77,50 @@ public:
      * @param n The name of the station. Defaults to an empty string.
      * @param tp The type of the station. Defaults to "Direct".
      */
-    station(string n = "", string tp = "Direct") noexcept : name(n), type(tp) {}
+    station(std::string_view n = "", std::string_view tp = "Direct")
+        : name(n), kind(kindOf(tp)) { type = typeOf(tp, kind); }
 
     /**
-     * @brief Gets a reference to the station's name.
+     * @brief Gets a constant reference to the station's name.
      *
-     * @return A non-const reference to the station's name.
+     * @return A const reference to the interned name.
      */
-    string& getName() noexcept { return name; }
-    
+    const string& getName() const noexcept { return name.str(); }
+
     /**
-     * @brief Gets a constant reference to the station's name.
+     * @brief Gets the interned name of the station.
      *
-     * @return A const reference to the station's name.
+     * @return The name symbol.
      */
-    const string& getName() const noexcept { return name; }
+    mgc::Symbol getNameSymbol() const noexcept { return name; }
     
     /**
      * @brief Sets the station's name.
      *
      * @param new_name The new name for the station.
      */
-    void setName(const string &new_name) { name = new_name; }
+    void setName(std::string_view new_name) { name = mgc::Symbol(new_name); }
 
     /**
      * @brief Gets a constant reference to the station's type.
      *
-     * @return A const reference to the station's type.
+     * @return A const reference to the interned type.
      */
-    const string& getType() const { return type; }
-    
+    const string& getType() const noexcept { return type.str(); }
+
+    /**
+     * @brief Gets the interned type of the station.
+     *
+     * @return The type symbol.
+     */
+    mgc::Symbol getTypeSymbol() const noexcept { return type; }
+
     /**
-     * @brief Gets the station's type.
+     * @brief Gets the kind of the station.
      *
-     * @return The station's type as a string.
+     * @return The kind matching the station's type.
      */
-    string getType() { return type; }
+    StationKind getKind() const noexcept { return kind; }
     
     /**
      * @brief Converts this station to another station type.
@@ -87,7 +131,7 @@ public:
      * @return A new object of type T constructed with the station's name.
      */
     template<DerivedFromStation T>
-    T convert_station() { return T(name); }
+    T convert_station() { return T(name.str()); }
     
     /**
      * @brief Virtual destructor.
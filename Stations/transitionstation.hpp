@@ -26,7 +26,7 @@ public:
      *
      * @param name The name of the transition station.
      */
-    transition_station(string name) : station(name, "transition") {}
+    transition_station(std::string_view name) : station(name, "transition") {}
 };
 
 } // namespace mgm
@@ -92,7 +92,7 @@ void UI::handleCommand(int choice) {
                 cout << "System validated.\n";
                 break;
             case 9:
-                cout << metroSystem.getSystemDescription() << "\n";
+                metroSystem.writeSystemDescription(cout) << "\n";
                 break;
             case 0:
                 cout << "Exiting.\n";
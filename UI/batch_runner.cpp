@@ -0,0 +1,154 @@
+#include "batch_runner.hpp"
+#include <array>
+#include <exception>
+
+namespace mgm {
+
+namespace {
+
+constexpr size_t MaxFields = 6;
+
+enum class Command { AddLine, RemoveLine, AddStation, RemoveStation, Modify, Find, FindTransfer, Validate, Describe, Metrics, Quit };
+
+struct Verb {
+    std::string_view name;
+    std::string_view alias; ///< Number of the command in the UI menu, if it has one.
+    Command command;
+    size_t minFields, maxFields;
+    std::string_view usage;
+};
+
+constexpr std::array<Verb, 11> verbs{{
+    {"addline", "1", Command::AddLine, 2, 2, "addline <line>"},
+    {"rmline", "2", Command::RemoveLine, 2, 2, "rmline <line>"},
+    {"add", "3", Command::AddStation, 3, 4, "add <line> <station> [<type>]"},
+    {"rm", "4", Command::RemoveStation, 3, 3, "rm <line> <station>"},
+    {"modify", "5", Command::Modify, 5, 5, "modify <line> <station> <new name> <new type>"},
+    {"find", "6", Command::Find, 3, 3, "find <line> <station>"},
+    {"findtransfer", "7", Command::FindTransfer, 2, 2, "findtransfer <station>"},
+    {"validate", "8", Command::Validate, 1, 1, "validate"},
+    {"describe", "9", Command::Describe, 1, 1, "describe"},
+    {"metrics", "", Command::Metrics, 1, 2, "metrics [json]"},
+    {"quit", "0", Command::Quit, 1, 1, "quit"},
+}};
+
+} // namespace
+
+BatchStats BatchRunner::run(std::istream &in, mgc::TextSink &out) {
+    stats = BatchStats{};
+    inputLine = 0;
+    stopped = false;
+    reader.read(in, [this, &out](std::string_view record) {
+        execute(record, out);
+        return !stopped;
+    });
+    return stats;
+}
+
+void BatchRunner::answerError(std::string_view message, mgc::TextSink &out) {
+    ++stats.errors;
+    out.append("error ");
+    mgc::appendNumber(out, inputLine);
+    out.put(' ');
+    out.append(mgc::withoutErrorPrefix(message));
+    out.put('\n');
+}
+
+void BatchRunner::execute(std::string_view record, mgc::TextSink &out) {
+    ++inputLine;
+    std::array<std::string_view, MaxFields> fields;
+    size_t count = mgc::splitFields(record, fields);
+    if (count == 0 || fields[0].front() == '#')
+        return;
+
+    ++stats.commands;
+    const Verb *verb = nullptr;
+    for (const Verb &v : verbs) {
+        if (fields[0] == v.name || fields[0] == v.alias) {
+            verb = &v;
+            break;
+        }
+    }
+    if (!verb) {
+        answerError("unknown command '" + string(fields[0]) + "'.", out);
+        return;
+    }
+    if (count < verb->minFields || count > verb->maxFields) {
+        answerError("expected: " + string(verb->usage) + ".", out);
+        return;
+    }
+
+    try {
+        switch (verb->command) {
+        case Command::AddLine:
+            metroSystem.addLine(fields[1]);
+            out.append("ok\n");
+            break;
+        case Command::RemoveLine:
+            metroSystem.removeLine(fields[1]);
+            out.append("ok\n");
+            break;
+        case Command::AddStation:
+            metroSystem.addStationToLine(fields[1], station(fields[2], count == 4 ? fields[3] : "Direct"));
+            out.append("ok\n");
+            break;
+        case Command::RemoveStation:
+            metroSystem.removeStationFromLine(fields[1], fields[2]);
+            out.append("ok\n");
+            break;
+        case Command::Modify:
+            metroSystem.modifyStationInLine(fields[1], fields[2], fields[3], fields[4]);
+            out.append("ok\n");
+            break;
+        case Command::Find: {
+            auto st = metroSystem.findStationOnLine(fields[1], fields[2]);
+            out.append("ok ");
+            out.append(st->getName());
+            out.put(' ');
+            out.append(st->getType());
+            out.put('\n');
+            break;
+        }
+        case Command::FindTransfer: {
+            auto st = metroSystem.findTransitionStationByName(fields[1]);
+            out.append("ok ");
+            out.append(st->getName());
+            out.put('\n');
+            break;
+        }
+        case Command::Validate: {
+            size_t removed = metroSystem.validateSystem();
+            out.append("ok ");
+            mgc::appendNumber(out, removed);
+            out.put('\n');
+            break;
+        }
+        case Command::Describe:
+            out.append("ok ");
+            mgc::appendNumber(out, metroSystem.getSystemDescriptionSize());
+            out.put('\n');
+            metroSystem.writeSystemDescription(out);
+            break;
+        case Command::Metrics: {
+            if (count == 2 && fields[1] != "json") {
+                answerError("expected: " + string(verb->usage) + ".", out);
+                break;
+            }
+            auto snapshot = MetroSystem::getMetrics();
+            string text = count == 2 ? snapshot.getJson() : snapshot.getText();
+            out.append("ok ");
+            mgc::appendNumber(out, text.size());
+            out.put('\n');
+            out.append(text);
+            break;
+        }
+        case Command::Quit:
+            stopped = true;
+            break;
+        }
+    } catch (const std::exception &ex) {
+        answerError(ex.what(), out);
+    }
+}
+
+} // namespace mgm
@@ -0,0 +1,86 @@
+#ifndef BATCH_RUNNER_HPP_
+#define BATCH_RUNNER_HPP_
+
+#include "../Metro_system/metro_system.hpp"
+#include "../container/recordReader.hpp"
+#include "../container/textSink.hpp"
+#include <istream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @file batch_runner.hpp
+ * @brief Non-interactive execution of UI commands read from a script.
+ *
+ * One command per line, fields separated by spaces or tabs. The verbs cover the
+ * menu of UI, whose numbers are accepted as aliases:
+ * @code
+ * # comment
+ * addline <line>                                   (1)
+ * rmline <line>                                    (2)
+ * add <line> <station> [<type>]                    (3)
+ * rm <line> <station>                              (4)
+ * modify <line> <station> <new name> <new type>    (5)
+ * find <line> <station>                            (6)
+ * findtransfer <station>                           (7)
+ * validate                                         (8)
+ * describe                                         (9)
+ * metrics [json]
+ * quit                                             (0)
+ * @endcode
+ * Each command answers with one line: "ok" followed by its result, if any, or
+ * "error <input line> <message>". @c find answers "ok <name> <type>",
+ * @c findtransfer "ok <name>" and @c validate "ok <connections removed>".
+ * @c describe answers "ok <size>" followed by exactly that many bytes of
+ * MetroSystem::getSystemDescription() text, and @c metrics likewise with the text or
+ * JSON form of MetroSystem::getMetrics(). @c quit ends the script without an answer.
+ */
+
+namespace mgm {
+
+/**
+ * @brief Counts of a script run.
+ */
+struct BatchStats {
+    size_t commands = 0; ///< Commands executed, failed ones included.
+    size_t errors = 0;   ///< Commands that answered with an error.
+};
+
+/**
+ * @brief Executes command scripts against a MetroSystem.
+ *
+ * The script is read in one pass through an mgc::RecordReader and answers go to
+ * a TextSink, so neither side is flushed per command. A failing command does not
+ * stop the script.
+ */
+class BatchRunner {
+public:
+    /**
+     * @brief Constructs a runner that edits the given system.
+     * @param system The system the commands apply to.
+     */
+    explicit BatchRunner(MetroSystem &system) : metroSystem(system) {}
+
+    /**
+     * @brief Executes every command of a script.
+     * @param in The script.
+     * @param out Where the answers go.
+     * @return Counts of what ran.
+     */
+    BatchStats run(std::istream &in, mgc::TextSink &out);
+
+private:
+    void execute(std::string_view record, mgc::TextSink &out);
+    void answerError(std::string_view message, mgc::TextSink &out);
+
+    MetroSystem &metroSystem;
+    BatchStats stats;
+    size_t inputLine = 0;
+    bool stopped = false;
+    mgc::RecordReader reader;
+};
+
+} // namespace mgm
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef ALLOC_COUNTER_HPP_
+#define ALLOC_COUNTER_HPP_
+
+#include <cstdint>
+
+/**
+ * @file alloc_counter.hpp
+ * @brief Heap allocation counters of the benchmark binary.
+ *
+ * alloc_counter.cpp replaces the global operator new and delete of metro_bench
+ * and counts every allocation, so benchmarks can report allocations and bytes
+ * per operation next to the time.
+ */
+
+namespace mgm::bench {
+
+/**
+ * @brief Totals of the heap allocations made so far by the process.
+ */
+struct AllocStats {
+    uint64_t allocations = 0; ///< Number of calls to operator new.
+    uint64_t bytes = 0;       ///< Bytes requested from operator new.
+
+    AllocStats operator-(const AllocStats &other) const noexcept {
+        return AllocStats{allocations - other.allocations, bytes - other.bytes};
+    }
+};
+
+/**
+ * @brief Reads the allocation counters.
+ * @return The totals since the start of the process.
+ */
+AllocStats allocStats() noexcept;
+
+} // namespace mgm::bench
+
+#endif
@@ -0,0 +1,84 @@
+#include <benchmark/benchmark.h>
+#include "alloc_counter.hpp"
+#include "bench_network.hpp"
+#include <string>
+#include <vector>
+
+using namespace mgm;
+
+/**
+ * @file arena_bench.cpp
+ * @brief Heap and arena station storage: allocations, build time and iteration throughput.
+ *
+ * The network has 100 lines of 1000 stations. Stations are added round-robin
+ * over the lines, like an edit session touching many lines does, so with
+ * per-station heap allocations the stations of one line end up interleaved
+ * with those of the others.
+ */
+
+namespace {
+
+constexpr size_t lineCount = 100;
+constexpr size_t stationsPerLine = 1000;
+
+MetroSystem buildInterleaved(StationStorage storage) {
+    MetroSystem system(storage);
+    std::vector<string> lineNames;
+    for (size_t i = 0; i < lineCount; ++i) {
+        lineNames.push_back("L" + std::to_string(i));
+        system.addLine(lineNames.back());
+    }
+    for (size_t j = 0; j < stationsPerLine; ++j) {
+        for (size_t i = 0; i < lineCount; ++i)
+            system.addStationToLine(lineNames[i], station(bench::stationName(i, j), j % 8 ? "Direct" : "transition"));
+    }
+    return system;
+}
+
+void BM_BuildStations(benchmark::State &state) {
+    auto storage = static_cast<StationStorage>(state.range(0));
+    bench::AllocStats used;
+    for (auto _ : state) {
+        auto before = bench::allocStats();
+        MetroSystem system = buildInterleaved(storage);
+        used = bench::allocStats() - before;
+        benchmark::DoNotOptimize(system.getLines().size());
+    }
+    state.SetLabel(storage == StationStorage::Arena ? "arena" : "heap");
+    state.counters["allocs_per_station"] = static_cast<double>(used.allocations) / (lineCount * stationsPerLine);
+    state.SetItemsProcessed(state.iterations() * lineCount * stationsPerLine);
+}
+BENCHMARK(BM_BuildStations)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+/// Visits every station line by line and reads its kind and name, as validation does.
+void BM_IterateStations(benchmark::State &state) {
+    auto storage = static_cast<StationStorage>(state.range(0));
+    MetroSystem system = buildInterleaved(storage);
+    for (auto _ : state) {
+        uint64_t sum = 0;
+        for (const auto &linePair : system.getLines()) {
+            for (const auto &stationPair : linePair.second.getStations())
+                sum += static_cast<uint64_t>(stationPair.second->getKind()) + stationPair.second->getNameSymbol().id();
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetLabel(storage == StationStorage::Arena ? "arena" : "heap");
+    state.SetItemsProcessed(state.iterations() * lineCount * stationsPerLine);
+}
+BENCHMARK(BM_IterateStations)->Arg(0)->Arg(1);
+
+/// Destroys a network; the arena frees a line's stations chunk by chunk.
+void BM_Teardown(benchmark::State &state) {
+    auto storage = static_cast<StationStorage>(state.range(0));
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto system = std::make_unique<MetroSystem>(buildInterleaved(storage));
+        state.ResumeTiming();
+        system.reset();
+    }
+    state.SetLabel(storage == StationStorage::Arena ? "arena" : "heap");
+    state.SetItemsProcessed(state.iterations() * lineCount * stationsPerLine);
+}
+BENCHMARK(BM_Teardown)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+} // namespace
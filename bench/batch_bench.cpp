@@ -0,0 +1,85 @@
+#include <benchmark/benchmark.h>
+#include "bench_network.hpp"
+#include <vector>
+
+using namespace mgm;
+
+/**
+ * @file batch_bench.cpp
+ * @brief A timetable import applied as one batch versus one call per edit.
+ *
+ * The network has 50 lines of 1000 stations. The import removes 2000 stations,
+ * adds 2000 and renames 1000, spread over all lines, and is followed by one
+ * incremental validation in both variants.
+ */
+
+namespace {
+
+constexpr size_t lineCount = 50;
+constexpr size_t stationsPerLine = 1000;
+
+const MetroSystem &network() {
+    static const MetroSystem system = bench::makeGridNetwork(lineCount, stationsPerLine, 8);
+    return system;
+}
+
+const std::vector<SystemEdit> &import() {
+    static const std::vector<SystemEdit> edits = [] {
+        std::vector<SystemEdit> result;
+        for (size_t i = 0; i < lineCount; ++i) {
+            string line = "L" + std::to_string(i);
+            for (size_t k = 0; k < 40; ++k)
+                result.push_back(SystemEdit::removeStation(line, bench::stationName(i, k * 25 + 1)));
+            for (size_t k = 0; k < 20; ++k)
+                result.push_back(SystemEdit::modifyStation(line, bench::stationName(i, k * 50 + 2),
+                                                           bench::stationName(i, k * 50 + 2) + "r", "Direct"));
+            for (size_t k = 0; k < 40; ++k)
+                result.push_back(SystemEdit::addStation(line, bench::stationName(i, stationsPerLine + k)));
+        }
+        return result;
+    }();
+    return edits;
+}
+
+void BM_ImportOneByOne(benchmark::State &state) {
+    for (auto _ : state) {
+        state.PauseTiming();
+        MetroSystem system = network();
+        state.ResumeTiming();
+        for (const auto &edit : import()) {
+            switch (edit.kind) {
+            case EditKind::RemoveStation:
+                system.removeStationFromLine(edit.line, edit.station);
+                break;
+            case EditKind::ModifyStation:
+                system.modifyStationInLine(edit.line, edit.station, edit.name, edit.type);
+                break;
+            default:
+                system.addStationToLine(edit.line, station(edit.station, edit.type));
+                break;
+            }
+        }
+        benchmark::DoNotOptimize(system.validateSystem());
+        state.PauseTiming();
+        system = MetroSystem();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * import().size());
+}
+BENCHMARK(BM_ImportOneByOne)->Unit(benchmark::kMillisecond);
+
+void BM_ImportBatch(benchmark::State &state) {
+    for (auto _ : state) {
+        state.PauseTiming();
+        MetroSystem system = network();
+        state.ResumeTiming();
+        benchmark::DoNotOptimize(system.applyBatch(import()));
+        state.PauseTiming();
+        system = MetroSystem();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * import().size());
+}
+BENCHMARK(BM_ImportBatch)->Unit(benchmark::kMillisecond);
+
+} // namespace
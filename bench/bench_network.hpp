@@ -0,0 +1,59 @@
+#ifndef BENCH_NETWORK_HPP_
+#define BENCH_NETWORK_HPP_
+
+#include "../Metro_system/metro_system.hpp"
+#include "../Stations/transitionstation.hpp"
+#include <string>
+
+/**
+ * @file bench_network.hpp
+ * @brief Synthetic networks shared by the benchmarks.
+ */
+
+namespace mgm::bench {
+
+/**
+ * @brief Gets the name of a station of a synthetic network.
+ * @param line The line number.
+ * @param slot The position of the station on the line.
+ * @return The station name.
+ */
+inline string stationName(size_t line, size_t slot) {
+    return "L" + std::to_string(line) + "_S" + std::to_string(slot);
+}
+
+/**
+ * @brief Builds a grid-like network of equally long lines.
+ *
+ * Lines are named "L<i>" and stations "L<i>_S<j>". Every @p transferEvery-th
+ * station of line i is a transition station connected to the station in the
+ * same position on lines i+1 and i+7 (modulo the line count).
+ *
+ * @param lineCount Number of lines.
+ * @param stationsPerLine Number of stations on each line.
+ * @param transferEvery Distance between transition stations on a line.
+ * @return The network.
+ */
+inline MetroSystem makeGridNetwork(size_t lineCount, size_t stationsPerLine, size_t transferEvery) {
+    MetroSystem system;
+    for (size_t i = 0; i < lineCount; ++i)
+        system.addLine("L" + std::to_string(i));
+    for (size_t i = 0; i < lineCount; ++i) {
+        string line = "L" + std::to_string(i);
+        for (size_t j = 0; j < stationsPerLine; ++j) {
+            if (lineCount > 1 && j % transferEvery == transferEvery / 2) {
+                transition_station ts(stationName(i, j));
+                ts.add_station(stationName((i + 1) % lineCount, j), "L" + std::to_string((i + 1) % lineCount));
+                ts.add_station(stationName((i + 7) % lineCount, j), "L" + std::to_string((i + 7) % lineCount));
+                system.addStationToLine(line, std::move(ts));
+            } else {
+                system.addStationToLine(line, station(stationName(i, j)));
+            }
+        }
+    }
+    return system;
+}
+
+} // namespace mgm::bench
+
+#endif
@@ -0,0 +1,141 @@
+#include <benchmark/benchmark.h>
+#include "bench_network.hpp"
+#include "../Metro_system/shared_metro_system.hpp"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <thread>
+
+using namespace mgm;
+
+/**
+ * @file concurrency_bench.cpp
+ * @brief Read throughput of a shared system with 1 to 32 reader threads and a background writer.
+ *
+ * Each read looks up a station on a line and a transition station by name on a
+ * 50x40 network. While the readers run, a writer thread renames a station every
+ * millisecond. SharedMetroSystem readers are compared with readers that load the
+ * snapshot pointer for every query and with a MetroSystem behind a std::shared_mutex.
+ */
+
+namespace {
+
+/// Starts and stops the background writer around a run; only thread 0 of a run touches it.
+class Writer {
+public:
+    template<typename Edit>
+    void start(Edit edit) {
+        stop = false;
+        thread = std::thread([this, edit] {
+            for (bool flip = false; !stop.load(std::memory_order_relaxed); flip = !flip) {
+                edit(flip);
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+    }
+
+    void join() {
+        stop = true;
+        thread.join();
+    }
+
+private:
+    std::atomic<bool> stop{false};
+    std::thread thread;
+};
+
+const string &lineName() {
+    static const string name = "L3";
+    return name;
+}
+
+const string &stationName() {
+    static const string name = bench::stationName(3, 10);
+    return name;
+}
+
+const string &hubName() {
+    static const string name = bench::stationName(17, 4);
+    return name;
+}
+
+void rename(MetroSystem &system, bool flip) {
+    const string renamed = stationName() + "'";
+    if (flip)
+        system.modifyStationInLine(lineName(), renamed, stationName(), "Direct");
+    else
+        system.modifyStationInLine(lineName(), stationName(), renamed, "Direct");
+}
+
+size_t query(const MetroSystem &system) {
+    auto st = system.tryFindStationOnLine(lineName(), stationName());
+    auto hub = system.tryFindTransitionStationByName(hubName());
+    return (st ? 1 : 0) + (hub ? 2 : 0);
+}
+
+SharedMetroSystem *shared;
+Writer writer;
+
+void startSharedWriter() {
+    shared = new SharedMetroSystem(bench::makeGridNetwork(50, 40, 8));
+    writer.start([](bool flip) { shared->update([flip](MetroSystem &system) { rename(system, flip); }); });
+}
+
+void stopSharedWriter() {
+    writer.join();
+    delete shared;
+    shared = nullptr;
+}
+
+void BM_ReadPinned(benchmark::State &state) {
+    if (state.thread_index() == 0)
+        startSharedWriter();
+    std::optional<SharedMetroSystem::Reader> reader;
+    for (auto _ : state) {
+        if (!reader)
+            reader.emplace(*shared);
+        benchmark::DoNotOptimize(query(reader->pin()));
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0)
+        stopSharedWriter();
+}
+BENCHMARK(BM_ReadPinned)->ThreadRange(1, 32)->UseRealTime();
+
+void BM_ReadSnapshot(benchmark::State &state) {
+    if (state.thread_index() == 0)
+        startSharedWriter();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(query(*shared->snapshot()));
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0)
+        stopSharedWriter();
+}
+BENCHMARK(BM_ReadSnapshot)->ThreadRange(1, 32)->UseRealTime();
+
+std::unique_ptr<MetroSystem> locked;
+std::shared_mutex lock;
+
+void BM_ReadSharedMutex(benchmark::State &state) {
+    if (state.thread_index() == 0) {
+        locked = std::make_unique<MetroSystem>(bench::makeGridNetwork(50, 40, 8));
+        writer.start([](bool flip) {
+            std::unique_lock guard(lock);
+            rename(*locked, flip);
+        });
+    }
+    for (auto _ : state) {
+        std::shared_lock guard(lock);
+        benchmark::DoNotOptimize(query(*locked));
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0) {
+        writer.join();
+        locked.reset();
+    }
+}
+BENCHMARK(BM_ReadSharedMutex)->ThreadRange(1, 32)->UseRealTime();
+
+} // namespace
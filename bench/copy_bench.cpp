@@ -0,0 +1,69 @@
+#include <benchmark/benchmark.h>
+#include "alloc_counter.hpp"
+#include "bench_network.hpp"
+
+using namespace mgm;
+
+/**
+ * @file copy_bench.cpp
+ * @brief What-if copies of a 100k-station system: the copy alone, and the copy
+ * followed by a closure and the validation that prunes the transfers into it.
+ *
+ * The network is validated once up front and has station copy-on-write enabled,
+ * so the original is left untouched by every scenario. Every benchmark reports
+ * the heap allocations and bytes of one iteration, destruction of the copy included.
+ */
+
+namespace {
+
+const MetroSystem &network() {
+    static const MetroSystem system = [] {
+        MetroSystem result = bench::makeGridNetwork(100, 1000, 10);
+        result.validateSystem(ValidationMode::Full);
+        result.setStationCopyOnWrite(true);
+        return result;
+    }();
+    return system;
+}
+
+template<typename Scenario>
+void runScenario(benchmark::State &state, Scenario scenario) {
+    const MetroSystem &system = network();
+    bench::AllocStats used;
+    for (auto _ : state) {
+        auto before = bench::allocStats();
+        {
+            MetroSystem copy(system);
+            scenario(copy);
+            benchmark::DoNotOptimize(&copy);
+        }
+        used = bench::allocStats() - before;
+    }
+    state.counters["allocs"] = static_cast<double>(used.allocations);
+    state.counters["alloc_bytes"] = static_cast<double>(used.bytes);
+}
+
+void BM_CopySystem(benchmark::State &state) {
+    runScenario(state, [](MetroSystem &) {});
+}
+BENCHMARK(BM_CopySystem)->Unit(benchmark::kMicrosecond);
+
+/// Closes a station that a transfer on the neighbouring line leads to.
+void BM_CopyAndCloseStation(benchmark::State &state) {
+    runScenario(state, [](MetroSystem &copy) {
+        copy.removeStationFromLine("L43", bench::stationName(43, 505));
+        benchmark::DoNotOptimize(copy.validateSystem());
+    });
+}
+BENCHMARK(BM_CopyAndCloseStation)->Unit(benchmark::kMicrosecond);
+
+/// Closes a whole line; the transfers of two other lines into it are pruned.
+void BM_CopyAndCloseLine(benchmark::State &state) {
+    runScenario(state, [](MetroSystem &copy) {
+        copy.removeLine("L42");
+        benchmark::DoNotOptimize(copy.validateSystem());
+    });
+}
+BENCHMARK(BM_CopyAndCloseLine)->Unit(benchmark::kMicrosecond);
+
+} // namespace
@@ -0,0 +1,106 @@
+#include <benchmark/benchmark.h>
+#include "alloc_counter.hpp"
+#include "bench_network.hpp"
+#include <fcntl.h>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+using namespace mgm;
+
+/**
+ * @file describe_bench.cpp
+ * @brief System description: concatenated strings against the TextSink writers.
+ *
+ * The network has 100 lines of 1000 stations. Every benchmark reports the heap
+ * allocations and bytes of one description; stream and descriptor output go to
+ * /dev/null, so only the cost of producing the text is measured.
+ */
+
+namespace {
+
+constexpr size_t lineCount = 100;
+constexpr size_t stationsPerLine = 1000;
+
+const MetroSystem &bigSystem() {
+    static const MetroSystem system = bench::makeGridNetwork(lineCount, stationsPerLine, 10);
+    return system;
+}
+
+/// getSystemDescription as it was before the writers: a temporary per station and per line.
+string concatenatedDescription(const MetroSystem &system) {
+    string oss;
+    for (const auto &linePair : system.getLines()) {
+        string table;
+        for (size_t slot = 0; slot < linePair.second.getNameColumn().size(); ++slot)
+            table += linePair.second.getNameColumn()[slot].str() + '-' + linePair.second.getTypeColumn()[slot].str() + '\n';
+        oss += "Line: " + linePair.first.str() + "\n";
+        oss += table + "\n";
+    }
+    return oss;
+}
+
+template<typename Describe>
+void runDescribe(benchmark::State &state, Describe describe) {
+    const MetroSystem &system = bigSystem();
+    bench::AllocStats used;
+    for (auto _ : state) {
+        auto before = bench::allocStats();
+        describe(system);
+        used = bench::allocStats() - before;
+    }
+    state.counters["allocs"] = static_cast<double>(used.allocations);
+    state.counters["alloc_bytes"] = static_cast<double>(used.bytes);
+    state.SetBytesProcessed(state.iterations() * system.getSystemDescriptionSize());
+}
+
+void BM_DescribeConcatenated(benchmark::State &state) {
+    runDescribe(state, [](const MetroSystem &system) {
+        string text = concatenatedDescription(system);
+        benchmark::DoNotOptimize(text.data());
+    });
+}
+BENCHMARK(BM_DescribeConcatenated)->Unit(benchmark::kMillisecond);
+
+/// getSystemDescription: one exactly sized string.
+void BM_DescribeString(benchmark::State &state) {
+    runDescribe(state, [](const MetroSystem &system) {
+        string text = system.getSystemDescription();
+        benchmark::DoNotOptimize(text.data());
+    });
+}
+BENCHMARK(BM_DescribeString)->Unit(benchmark::kMillisecond);
+
+/// A string reused across calls, as a server answering many requests would keep one.
+void BM_DescribeReusedBuffer(benchmark::State &state) {
+    string buffer;
+    runDescribe(state, [&buffer](const MetroSystem &system) {
+        buffer.clear();
+        mgc::TextSink out(buffer);
+        system.writeSystemDescription(out);
+        benchmark::DoNotOptimize(buffer.data());
+    });
+}
+BENCHMARK(BM_DescribeReusedBuffer)->Unit(benchmark::kMillisecond);
+
+/// The old way to print the description: build the string, then stream it.
+void BM_DescribeStreamViaString(benchmark::State &state) {
+    std::ofstream sink("/dev/null");
+    runDescribe(state, [&sink](const MetroSystem &system) { sink << system.getSystemDescription(); });
+}
+BENCHMARK(BM_DescribeStreamViaString)->Unit(benchmark::kMillisecond);
+
+void BM_DescribeStream(benchmark::State &state) {
+    std::ofstream sink("/dev/null");
+    runDescribe(state, [&sink](const MetroSystem &system) { system.writeSystemDescription(sink); });
+}
+BENCHMARK(BM_DescribeStream)->Unit(benchmark::kMillisecond);
+
+void BM_DescribeFd(benchmark::State &state) {
+    int fd = ::open("/dev/null", O_WRONLY);
+    runDescribe(state, [fd](const MetroSystem &system) { system.writeSystemDescription(fd); });
+    ::close(fd);
+}
+BENCHMARK(BM_DescribeFd)->Unit(benchmark::kMillisecond);
+
+} // namespace
@@ -0,0 +1,80 @@
+#include <benchmark/benchmark.h>
+#include "bench_network.hpp"
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace mgm;
+
+/**
+ * @file erase_bench.cpp
+ * @brief Ordered and unordered erase in LookupTable, and in-place station edits.
+ *
+ * The mixed workload keeps a table at 10k elements and, per step, erases a random
+ * key and inserts a new one, so every erase lands on average in the middle of the table.
+ */
+
+namespace {
+
+constexpr size_t tableSize = 10000;
+
+template <class Table>
+void BM_MixedInsertErase(benchmark::State &state) {
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < tableSize; ++i)
+        keys.push_back("key" + std::to_string(i));
+    Table table;
+    for (size_t i = 0; i < tableSize; ++i)
+        table.insert(keys[i], static_cast<int>(i));
+    std::mt19937 rng(7);
+    size_t next = tableSize;
+    for (auto _ : state) {
+        size_t victim = rng() % keys.size();
+        benchmark::DoNotOptimize(table.erase(keys[victim]));
+        keys[victim] = "key" + std::to_string(next++);
+        table.insert(keys[victim], static_cast<int>(next));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_MixedInsertErase, mgc::HashedLookupTable<std::string, int>);
+BENCHMARK_TEMPLATE(BM_MixedInsertErase, mgc::UnorderedHashedLookupTable<std::string, int>);
+
+/// Drains a 10k table from the front, the worst case for the ordered shift.
+template <class Table>
+void BM_EraseFront(benchmark::State &state) {
+    for (auto _ : state) {
+        state.PauseTiming();
+        Table table;
+        for (size_t i = 0; i < tableSize; ++i)
+            table.insert(static_cast<int>(i), static_cast<int>(i));
+        state.ResumeTiming();
+        for (size_t i = 0; i < tableSize; ++i)
+            table.erase(static_cast<int>(i));
+        benchmark::DoNotOptimize(table.size());
+    }
+    state.SetItemsProcessed(state.iterations() * tableSize);
+}
+BENCHMARK_TEMPLATE(BM_EraseFront, mgc::HashedLookupTable<int, int>)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_EraseFront, mgc::UnorderedHashedLookupTable<int, int>)->Unit(benchmark::kMillisecond);
+
+/// Renames a station in the middle of a 10k-station line back and forth.
+void BM_ModifyStation(benchmark::State &state) {
+    MetroSystem system;
+    system.addLine("L");
+    for (size_t j = 0; j < tableSize; ++j)
+        system.addStationToLine("L", station(bench::stationName(0, j)));
+    const string original = bench::stationName(0, tableSize / 2);
+    const string renamed = original + "'";
+    bool flip = false;
+    for (auto _ : state) {
+        if (flip)
+            system.modifyStationInLine("L", renamed, original, "Direct");
+        else
+            system.modifyStationInLine("L", original, renamed, "Direct");
+        flip = !flip;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ModifyStation);
+
+} // namespace
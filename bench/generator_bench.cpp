@@ -0,0 +1,67 @@
+#include <benchmark/benchmark.h>
+#include "../loader/network_generator.hpp"
+#include <ostream>
+#include <streambuf>
+
+using namespace mgm;
+
+/**
+ * @file generator_bench.cpp
+ * @brief Generation of 1M-station networks, in memory and as an import file.
+ */
+
+namespace {
+
+/// Counts what is written and drops it.
+class NullBuffer : public std::streambuf {
+public:
+    size_t written = 0;
+
+protected:
+    std::streamsize xsputn(const char *, std::streamsize n) override {
+        written += static_cast<size_t>(n);
+        return n;
+    }
+    int_type overflow(int_type c) override {
+        ++written;
+        return c;
+    }
+};
+
+GeneratorOptions millionStations(NetworkProfile profile) {
+    GeneratorOptions options;
+    options.lines = 1000;
+    options.stationsPerLine = 1000;
+    options.hubDensity = 0.1;
+    options.hubFanOut = 2;
+    options.profile = profile;
+    return options;
+}
+
+void BM_GenerateSystem(benchmark::State &state) {
+    NetworkGenerator generator(millionStations(static_cast<NetworkProfile>(state.range(0))));
+    LoadStats stats;
+    for (auto _ : state) {
+        MetroSystem system;
+        stats = generator.populate(system);
+        benchmark::DoNotOptimize(system.getLines().size());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * stats.stations));
+    state.counters["transfers"] = static_cast<double>(stats.transfers);
+}
+
+void BM_GenerateFile(benchmark::State &state) {
+    NetworkGenerator generator(millionStations(static_cast<NetworkProfile>(state.range(0))));
+    LoadStats stats;
+    NullBuffer buffer;
+    std::ostream out(&buffer);
+    for (auto _ : state)
+        stats = generator.write(out);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * stats.stations));
+    state.SetBytesProcessed(static_cast<int64_t>(buffer.written));
+}
+
+} // namespace
+
+BENCHMARK(BM_GenerateSystem)->ArgName("city")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_GenerateFile)->ArgName("city")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
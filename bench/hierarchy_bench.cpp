@@ -0,0 +1,85 @@
+#include <benchmark/benchmark.h>
+#include "bench_network.hpp"
+#include "../routing/contraction_hierarchy.hpp"
+#include <random>
+#include <vector>
+
+using namespace mgm;
+
+/**
+ * @file hierarchy_bench.cpp
+ * @brief Contraction hierarchy preprocessing, size and query latency against plain search.
+ *
+ * The 5k network has 20 lines of 250 stations, the 50k one 50 lines of 1000, both
+ * with an interchange every 10 stations. Queries run between random node pairs
+ * on integer IDs, so only the search itself is measured.
+ */
+
+namespace {
+
+const MetroSystem &network(size_t stations) {
+    static const MetroSystem small = bench::makeGridNetwork(20, 250, 10);
+    static const MetroSystem large = bench::makeGridNetwork(50, 1000, 10);
+    return stations <= 5000 ? small : large;
+}
+
+std::vector<std::pair<uint32_t, uint32_t>> randomPairs(uint32_t nodeCount) {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<uint32_t> pick(0, nodeCount - 1);
+    std::vector<std::pair<uint32_t, uint32_t>> pairs(1024);
+    for (auto &p : pairs)
+        p = {pick(rng), pick(rng)};
+    return pairs;
+}
+
+/// Arguments: network size in stations.
+void BM_HierarchyBuild(benchmark::State &state) {
+    const RouteGraph &graph = network(static_cast<size_t>(state.range(0))).getRouteGraph();
+    for (auto _ : state) {
+        ContractionHierarchy hierarchy = ContractionHierarchy::build(graph.view(), RouteCost::FewestStops);
+        benchmark::DoNotOptimize(hierarchy.edgeCount());
+    }
+    const ContractionHierarchy &hierarchy = network(static_cast<size_t>(state.range(0))).getRouteHierarchy(RouteCost::FewestStops);
+    state.counters["shortcuts"] = hierarchy.shortcutCount();
+    state.counters["index_KiB"] = static_cast<double>(hierarchy.byteSize()) / 1024.0;
+    state.counters["graph_edges"] = graph.edgeCount();
+}
+BENCHMARK(BM_HierarchyBuild)->Arg(5000)->Arg(50000)->Unit(benchmark::kMillisecond);
+
+/// Arguments: network size in stations, cost model.
+void BM_PlainQuery(benchmark::State &state) {
+    const RouteGraph &graph = network(static_cast<size_t>(state.range(0))).getRouteGraph();
+    auto cost = static_cast<RouteCost>(state.range(1));
+    auto pairs = randomPairs(graph.nodeCount());
+    RouteFinder finder;
+    size_t i = 0;
+    for (auto _ : state) {
+        auto [from, to] = pairs[i++ & 1023];
+        auto path = finder.search(graph.view(), std::span(&from, 1), std::span(&to, 1), cost);
+        benchmark::DoNotOptimize(path);
+    }
+    state.SetLabel(cost == RouteCost::FewestStops ? "fewest stops" : "fewest transfers");
+}
+BENCHMARK(BM_PlainQuery)->ArgsProduct({{5000, 50000}, {0, 1}})->Unit(benchmark::kMicrosecond);
+
+/// Arguments: network size in stations, cost model.
+void BM_HierarchyQuery(benchmark::State &state) {
+    const MetroSystem &system = network(static_cast<size_t>(state.range(0)));
+    auto cost = static_cast<RouteCost>(state.range(1));
+    const ContractionHierarchy &hierarchy = system.getRouteHierarchy(cost);
+    auto pairs = randomPairs(hierarchy.nodeCount());
+    HierarchyFinder finder;
+    size_t i = 0;
+    uint64_t settled = 0;
+    for (auto _ : state) {
+        auto [from, to] = pairs[i++ & 1023];
+        auto path = finder.search(hierarchy, std::span(&from, 1), std::span(&to, 1));
+        benchmark::DoNotOptimize(path);
+        settled += finder.settledCount();
+    }
+    state.counters["settled"] = benchmark::Counter(static_cast<double>(settled), benchmark::Counter::kAvgIterations);
+    state.SetLabel(cost == RouteCost::FewestStops ? "fewest stops" : "fewest transfers");
+}
+BENCHMARK(BM_HierarchyQuery)->ArgsProduct({{5000, 50000}, {0, 1}})->Unit(benchmark::kMicrosecond);
+
+} // namespace
@@ -0,0 +1,109 @@
+#include <benchmark/benchmark.h>
+#include "alloc_counter.hpp"
+#include "bench_network.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace mgm;
+
+/**
+ * @file intern_bench.cpp
+ * @brief Memory and classification cost of interned station names and kind tags.
+ *
+ * The footprint benchmarks allocate 100k stations the way Line::addElement does
+ * and compare the interned station with a copy of the previous layout, which held
+ * its name and type as two std::string members. Names of 8 characters fit the
+ * small-string buffer; names of 24 characters need a heap block per copy.
+ */
+
+namespace {
+
+/// The station layout before interning.
+struct StringStation {
+    StringStation(string n, string tp) : name(std::move(n)), type(std::move(tp)) {}
+    virtual ~StringStation() = default;
+    string name;
+    string type;
+};
+
+std::vector<string> makeNames(size_t count, size_t length) {
+    std::vector<string> names;
+    names.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        string name = "S" + std::to_string(i);
+        name.resize(length, '_');
+        names.push_back(std::move(name));
+    }
+    return names;
+}
+
+template <typename Station>
+void BM_StationFootprint(benchmark::State &state) {
+    constexpr size_t count = 100'000;
+    auto names = makeNames(count, static_cast<size_t>(state.range(0)));
+    bench::AllocStats used;
+    for (auto _ : state) {
+        std::vector<std::shared_ptr<Station>> stations;
+        stations.reserve(count);
+        auto before = bench::allocStats();
+        for (const auto &name : names)
+            stations.push_back(std::make_shared<Station>(name, "Direct"));
+        used = bench::allocStats() - before;
+        benchmark::DoNotOptimize(stations.data());
+    }
+    state.counters["bytes_per_station"] = static_cast<double>(used.bytes) / count;
+    state.counters["allocs_per_station"] = static_cast<double>(used.allocations) / count;
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK_TEMPLATE(BM_StationFootprint, StringStation)->Arg(8)->Arg(24)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_StationFootprint, station)->Arg(8)->Arg(24)->Unit(benchmark::kMillisecond);
+
+const MetroSystem &network() {
+    static const MetroSystem system = bench::makeGridNetwork(50, 400, 8);
+    return system;
+}
+
+/// Counts transition stations by comparing the type string, as before the kind tag.
+void BM_CountTransitions_TypeString(benchmark::State &state) {
+    for (auto _ : state) {
+        size_t count = 0;
+        for (const auto &linePair : network().getLines()) {
+            for (const auto &stationPair : linePair.second.getStations())
+                count += stationPair.second->getType() == "transition";
+        }
+        benchmark::DoNotOptimize(count);
+    }
+    state.SetItemsProcessed(state.iterations() * 50 * 400);
+}
+BENCHMARK(BM_CountTransitions_TypeString);
+
+void BM_CountTransitions_Kind(benchmark::State &state) {
+    for (auto _ : state) {
+        size_t count = 0;
+        for (const auto &linePair : network().getLines()) {
+            for (const auto &stationPair : linePair.second.getStations())
+                count += stationPair.second->getKind() == StationKind::Transition;
+        }
+        benchmark::DoNotOptimize(count);
+    }
+    state.SetItemsProcessed(state.iterations() * 50 * 400);
+}
+BENCHMARK(BM_CountTransitions_Kind);
+
+/// Whole-network build: 50 lines of 400 stations, with transfers.
+void BM_BuildNetwork(benchmark::State &state) {
+    bench::AllocStats used;
+    for (auto _ : state) {
+        auto before = bench::allocStats();
+        MetroSystem system = bench::makeGridNetwork(50, 400, 8);
+        used = bench::allocStats() - before;
+        benchmark::DoNotOptimize(system.getLines().size());
+    }
+    state.counters["bytes_per_station"] = static_cast<double>(used.bytes) / (50 * 400);
+    state.counters["allocs_per_station"] = static_cast<double>(used.allocations) / (50 * 400);
+    state.SetItemsProcessed(state.iterations() * 50 * 400);
+}
+BENCHMARK(BM_BuildNetwork)->Unit(benchmark::kMillisecond);
+
+} // namespace
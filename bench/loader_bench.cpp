@@ -0,0 +1,40 @@
+#include <benchmark/benchmark.h>
+#include "bench_network.hpp"
+#include "../loader/network_loader.hpp"
+#include <sstream>
+
+using namespace mgm;
+
+/**
+ * @file loader_bench.cpp
+ * @brief Bulk load of a 100k-station network definition.
+ */
+
+namespace {
+
+const string &networkText() {
+    static const string text = [] {
+        std::ostringstream out;
+        saveNetwork(bench::makeGridNetwork(100, 1000, 10), out);
+        return out.str();
+    }();
+    return text;
+}
+
+void BM_LoadNetwork(benchmark::State &state) {
+    const string &text = networkText();
+    LoadStats stats;
+    for (auto _ : state) {
+        MetroSystem system;
+        std::istringstream in(text);
+        stats = NetworkLoader(system).load(in);
+        benchmark::DoNotOptimize(system.getLines().size());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * text.size()));
+    state.counters["stations"] = static_cast<double>(stats.stations);
+    state.counters["transfers"] = static_cast<double>(stats.transfers);
+}
+
+} // namespace
+
+BENCHMARK(BM_LoadNetwork)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,110 @@
+#include <benchmark/benchmark.h>
+#include "../container/lookUpTable.hpp"
+#include <string>
+#include <vector>
+
+using namespace mgc;
+
+/**
+ * @file lookup_table_bench.cpp
+ * @brief Build and lookup cost of the linear and hashed LookupTable.
+ *
+ * The build and find benchmarks run at 10, 100, 1k and 10k keys shaped like
+ * station names. The fingerprint sweep compares the three index policies at
+ * 8 to 4096 keys, and the byte-scan sweep times each findByte() implementation
+ * over the same sizes.
+ */
+
+namespace {
+
+std::vector<std::string> makeKeys(size_t n) {
+    std::vector<std::string> keys;
+    keys.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        keys.push_back("Station_" + std::to_string(i * 7919 % 100003));
+    }
+    return keys;
+}
+
+/// Builds a table the way Line::addElement does: duplicate check, then insert.
+template <typename Table>
+void BM_Build(benchmark::State &state) {
+    auto keys = makeKeys(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        Table table;
+        for (const auto &key : keys) {
+            if (table.find(key) == table.size()) {
+                table.insert(key, 0);
+            }
+        }
+        benchmark::DoNotOptimize(table.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <typename Table>
+void BM_FindHit(benchmark::State &state) {
+    auto keys = makeKeys(static_cast<size_t>(state.range(0)));
+    Table table;
+    for (const auto &key : keys) {
+        table.insert(key, 0);
+    }
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(table.find(keys[i]));
+        if (++i == keys.size()) {
+            i = 0;
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+template <typename Table>
+void BM_FindMiss(benchmark::State &state) {
+    auto keys = makeKeys(static_cast<size_t>(state.range(0)));
+    Table table;
+    for (const auto &key : keys) {
+        table.insert(key, 0);
+    }
+    const std::string missing = "Station_missing";
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(table.find(missing));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+/// Scans a fingerprint-sized array for an absent byte with a forced implementation.
+void BM_FindByte(benchmark::State &state) {
+    auto scan = static_cast<ByteScan>(state.range(0));
+    if (!byteScanSupported(scan)) {
+        state.SkipWithError("not supported by this CPU");
+        return;
+    }
+    std::vector<uint8_t> bytes(static_cast<size_t>(state.range(1)), 0);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(findByte(scan, bytes.data(), 0, bytes.size(), 1));
+    }
+    state.SetLabel(scan == ByteScan::AVX2 ? "avx2" : scan == ByteScan::SSE2 ? "sse2" : "scalar");
+    state.SetBytesProcessed(state.iterations() * state.range(1));
+}
+
+using Linear = LookupTable<std::string, int>;
+using Fingerprint = FingerprintLookupTable<std::string, int>;
+using Hashed = HashedLookupTable<std::string, int>;
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_Build, Linear)->RangeMultiplier(10)->Range(10, 10000);
+BENCHMARK_TEMPLATE(BM_Build, Hashed)->RangeMultiplier(10)->Range(10, 10000);
+BENCHMARK_TEMPLATE(BM_FindHit, Linear)->RangeMultiplier(10)->Range(10, 10000);
+BENCHMARK_TEMPLATE(BM_FindHit, Hashed)->RangeMultiplier(10)->Range(10, 10000);
+BENCHMARK_TEMPLATE(BM_FindMiss, Linear)->RangeMultiplier(10)->Range(10, 10000);
+BENCHMARK_TEMPLATE(BM_FindMiss, Hashed)->RangeMultiplier(10)->Range(10, 10000);
+
+BENCHMARK_TEMPLATE(BM_FindHit, Linear)->Name("Sweep/FindHit<Linear>")->RangeMultiplier(2)->Range(8, 4096);
+BENCHMARK_TEMPLATE(BM_FindHit, Fingerprint)->Name("Sweep/FindHit<Fingerprint>")->RangeMultiplier(2)->Range(8, 4096);
+BENCHMARK_TEMPLATE(BM_FindHit, Hashed)->Name("Sweep/FindHit<Hashed>")->RangeMultiplier(2)->Range(8, 4096);
+BENCHMARK_TEMPLATE(BM_FindMiss, Linear)->Name("Sweep/FindMiss<Linear>")->RangeMultiplier(2)->Range(8, 4096);
+BENCHMARK_TEMPLATE(BM_FindMiss, Fingerprint)->Name("Sweep/FindMiss<Fingerprint>")->RangeMultiplier(2)->Range(8, 4096);
+BENCHMARK_TEMPLATE(BM_FindMiss, Hashed)->Name("Sweep/FindMiss<Hashed>")->RangeMultiplier(2)->Range(8, 4096);
+BENCHMARK(BM_FindByte)->ArgsProduct({{0, 1, 2}, {8, 64, 512, 4096}});
@@ -0,0 +1,138 @@
+#include <benchmark/benchmark.h>
+#include "alloc_counter.hpp"
+#include "../Metro_system/metro_system.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace mgm;
+
+/**
+ * @file lookup_view_bench.cpp
+ * @brief Lookups by names parsed out of a text buffer: std::string_view passed
+ * through against names copied into temporary std::strings first.
+ *
+ * Names are longer than the small-string buffer of std::string, so every copy
+ * allocates, as it would for real station names. Every benchmark reports the
+ * heap allocations per query next to the time.
+ */
+
+namespace {
+
+constexpr size_t lineCount = 20;
+constexpr size_t stationsPerLine = 500;
+constexpr size_t queryCount = 1000;
+
+string longLineName(size_t line) {
+    return "Northbound_Line_" + std::to_string(line);
+}
+
+string longStationName(size_t line, size_t slot) {
+    return "Central_Station_" + std::to_string(line) + "_Platform_" + std::to_string(slot);
+}
+
+const MetroSystem &network() {
+    static const MetroSystem system = [] {
+        MetroSystem result;
+        std::vector<StationSpec> specs(stationsPerLine);
+        for (size_t i = 0; i < lineCount; ++i) {
+            result.addLine(longLineName(i));
+            for (size_t j = 0; j < stationsPerLine; ++j)
+                specs[j] = StationSpec{longStationName(i, j), "Direct"};
+            result.addStationsToLine(longLineName(i), specs);
+        }
+        return result;
+    }();
+    return system;
+}
+
+/// "<line> <station>\n" records, as a batch file or request buffer holds them.
+const string &queryText() {
+    static const string text = [] {
+        string result;
+        for (size_t k = 0; k < queryCount; ++k) {
+            size_t line = k * 7 % lineCount, slot = k * 13 % stationsPerLine;
+            result += longLineName(line) + ' ' + longStationName(line, slot) + '\n';
+        }
+        return result;
+    }();
+    return text;
+}
+
+/// Calls @p query with the two fields of every record of the buffer.
+template<typename Query>
+void forEachQuery(std::string_view text, Query query) {
+    while (!text.empty()) {
+        size_t space = text.find(' ');
+        size_t end = text.find('\n', space);
+        query(text.substr(0, space), text.substr(space + 1, end - space - 1));
+        text.remove_prefix(end + 1);
+    }
+}
+
+template<typename Query>
+void runQueries(benchmark::State &state, Query query) {
+    const string &text = queryText();
+    bench::AllocStats used;
+    for (auto _ : state) {
+        auto before = bench::allocStats();
+        forEachQuery(text, query);
+        used = bench::allocStats() - before;
+    }
+    state.counters["allocs_per_query"] = static_cast<double>(used.allocations) / queryCount;
+    state.SetItemsProcessed(state.iterations() * queryCount);
+}
+
+/// The fields copied into std::strings, as the const std::string & signatures required.
+void BM_FindStationCopiedNames(benchmark::State &state) {
+    const MetroSystem &system = network();
+    runQueries(state, [&system](std::string_view line, std::string_view name) {
+        benchmark::DoNotOptimize(system.tryFindStationOnLine(string(line), string(name)).get());
+    });
+}
+BENCHMARK(BM_FindStationCopiedNames)->Unit(benchmark::kMicrosecond);
+
+/// The fields passed as views into the buffer.
+void BM_FindStationViewedNames(benchmark::State &state) {
+    const MetroSystem &system = network();
+    runQueries(state, [&system](std::string_view line, std::string_view name) {
+        benchmark::DoNotOptimize(system.tryFindStationOnLine(line, name).get());
+    });
+}
+BENCHMARK(BM_FindStationViewedNames)->Unit(benchmark::kMicrosecond);
+
+using PlainTable = mgc::HashedLookupTable<string, size_t>;
+using TransparentTable = mgc::HashedLookupTable<string, size_t, mgc::StringHash, std::equal_to<>>;
+
+template<typename Table>
+const Table &stationTable() {
+    static const Table table = [] {
+        Table result;
+        for (size_t i = 0; i < lineCount; ++i) {
+            for (size_t j = 0; j < stationsPerLine; ++j)
+                result.insert(longStationName(i, j), i * stationsPerLine + j);
+        }
+        return result;
+    }();
+    return table;
+}
+
+/// A string-keyed table with std::hash<string>: every lookup converts the view to a key.
+void BM_LookupTableCopiedKey(benchmark::State &state) {
+    const PlainTable &table = stationTable<PlainTable>();
+    runQueries(state, [&table](std::string_view, std::string_view name) {
+        benchmark::DoNotOptimize(table.find(string(name)));
+    });
+}
+BENCHMARK(BM_LookupTableCopiedKey)->Unit(benchmark::kMicrosecond);
+
+/// The same table with the transparent StringHash, searched by the view itself.
+void BM_LookupTableViewedKey(benchmark::State &state) {
+    const TransparentTable &table = stationTable<TransparentTable>();
+    runQueries(state, [&table](std::string_view, std::string_view name) {
+        benchmark::DoNotOptimize(table.find(name));
+    });
+}
+BENCHMARK(BM_LookupTableViewedKey)->Unit(benchmark::kMicrosecond);
+
+} // namespace
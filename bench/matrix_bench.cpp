@@ -0,0 +1,55 @@
+#include <benchmark/benchmark.h>
+#include "bench_network.hpp"
+#include "../routing/travel_matrix.hpp"
+#include <cstdio>
+#include <string>
+
+using namespace mgm;
+
+/**
+ * @file matrix_bench.cpp
+ * @brief All-pairs hop and transfer matrices on 2k and 10k station networks.
+ *
+ * The 2k network has 20 lines of 100 stations, the 10k one 50 lines of 200.
+ * The in-memory runs vary the thread count; the file runs write the same
+ * matrix through a shared mapping of a file in the temporary directory.
+ */
+
+namespace {
+
+const MetroSystem &network(size_t stations) {
+    static const MetroSystem small = bench::makeGridNetwork(20, 100, 8);
+    static const MetroSystem large = bench::makeGridNetwork(50, 200, 8);
+    return stations <= 2000 ? small : large;
+}
+
+/// Arguments: network size in stations, number of threads.
+void BM_TravelMatrixAll(benchmark::State &state) {
+    const RouteGraph &graph = network(static_cast<size_t>(state.range(0))).getRouteGraph();
+    auto threads = static_cast<unsigned>(state.range(1));
+    for (auto _ : state) {
+        TravelMatrix matrix = TravelMatrix::computeAll(graph.view(), threads);
+        benchmark::DoNotOptimize(matrix.hops(0, matrix.cols() - 1));
+    }
+    state.SetItemsProcessed(state.iterations() * graph.nodeCount());
+    state.counters["pairs"] = static_cast<double>(graph.nodeCount()) * graph.nodeCount();
+}
+BENCHMARK(BM_TravelMatrixAll)->ArgsProduct({{2000, 10000}, {1, 2, 4}})->Unit(benchmark::kMillisecond)->UseRealTime();
+
+/// Arguments: network size in stations.
+void BM_TravelMatrixToFile(benchmark::State &state) {
+    const RouteGraph &graph = network(static_cast<size_t>(state.range(0))).getRouteGraph();
+    std::vector<uint32_t> nodes(graph.nodeCount());
+    for (uint32_t i = 0; i < graph.nodeCount(); ++i)
+        nodes[i] = i;
+    const string path = "/tmp/metro_bench_matrix.bin";
+    for (auto _ : state) {
+        TravelMatrix matrix = TravelMatrix::computeToFile(graph.view(), nodes, nodes, path, 1);
+        benchmark::DoNotOptimize(matrix.hops(0, matrix.cols() - 1));
+    }
+    std::remove(path.c_str());
+    state.SetItemsProcessed(state.iterations() * graph.nodeCount());
+}
+BENCHMARK(BM_TravelMatrixToFile)->Arg(2000)->Arg(10000)->Unit(benchmark::kMillisecond);
+
+} // namespace
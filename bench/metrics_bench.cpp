@@ -0,0 +1,62 @@
+#include <benchmark/benchmark.h>
+#include "bench_network.hpp"
+#include <string>
+#include <vector>
+
+using namespace mgm;
+
+/**
+ * @file metrics_bench.cpp
+ * @brief Cost of the operation metrics: an empty scope, and an instrumented lookup
+ * next to its uninstrumented twin tryFindStationOnLine().
+ */
+
+namespace {
+
+const MetroSystem &network() {
+    static const MetroSystem system = bench::makeGridNetwork(10, 100, 10);
+    return system;
+}
+
+std::vector<std::pair<string, string>> queries() {
+    std::vector<std::pair<string, string>> result;
+    for (size_t k = 0; k < 1000; ++k) {
+        size_t line = k * 7 % 10, slot = k * 13 % 100;
+        result.emplace_back("L" + std::to_string(line), bench::stationName(line, slot));
+    }
+    return result;
+}
+
+void BM_MetricsScope(benchmark::State &state) {
+    for (auto _ : state) {
+        METRO_METRIC_SCOPE(FindStationOnLine);
+        benchmark::ClobberMemory();
+    }
+    state.SetLabel(MetroSystem::getMetrics().enabled ? "enabled" : "compiled out");
+}
+
+void BM_MetricsFindStation(benchmark::State &state) {
+    const MetroSystem &system = network();
+    auto list = queries();
+    for (auto _ : state) {
+        for (const auto &[line, name] : list)
+            benchmark::DoNotOptimize(system.findStationOnLine(line, name).get());
+    }
+    state.SetItemsProcessed(state.iterations() * list.size());
+}
+
+void BM_MetricsTryFindStation(benchmark::State &state) {
+    const MetroSystem &system = network();
+    auto list = queries();
+    for (auto _ : state) {
+        for (const auto &[line, name] : list)
+            benchmark::DoNotOptimize(system.tryFindStationOnLine(line, name).get());
+    }
+    state.SetItemsProcessed(state.iterations() * list.size());
+}
+
+} // namespace
+
+BENCHMARK(BM_MetricsScope);
+BENCHMARK(BM_MetricsFindStation)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_MetricsTryFindStation)->Unit(benchmark::kMicrosecond);
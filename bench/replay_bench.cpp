@@ -0,0 +1,107 @@
+#include <benchmark/benchmark.h>
+#include "bench_network.hpp"
+#include "../UI/UI.hpp"
+#include "../UI/batch_runner.hpp"
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+
+using namespace mgm;
+
+/**
+ * @file replay_bench.cpp
+ * @brief Replaying a command trace in batch mode and through the interactive menu.
+ *
+ * The network has 20 lines of 250 stations. The trace repeats a block of eight
+ * commands: a station is added, looked up, renamed and removed again, an existing
+ * station and a transition station are looked up, and the system is validated.
+ * Answers go to /dev/null; the copy of the network each run starts from is not timed.
+ */
+
+namespace {
+
+constexpr size_t lineCount = 20;
+constexpr size_t stationsPerLine = 250;
+
+const MetroSystem &network() {
+    static const MetroSystem system = bench::makeGridNetwork(lineCount, stationsPerLine, 10);
+    return system;
+}
+
+/// Builds a trace of about @p commands commands; the menu form puts the menu number on a line of its own.
+string makeTrace(size_t commands, bool menuForm) {
+    string trace;
+    auto emit = [&](std::string_view verb, std::string_view number, const string &args) {
+        trace += menuForm ? number : verb;
+        trace += menuForm ? "\n" : " ";
+        trace += args;
+        trace += '\n';
+    };
+    for (size_t k = 0; k * 8 < commands; ++k) {
+        size_t i = k % lineCount;
+        string line = "L" + std::to_string(i);
+        string added = "T" + std::to_string(k), renamed = "U" + std::to_string(k);
+        emit("add", "3", line + ' ' + added + " Direct");
+        emit("find", "6", line + ' ' + added);
+        emit("modify", "5", line + ' ' + added + ' ' + renamed + " Direct");
+        emit("find", "6", line + ' ' + bench::stationName(i, k % stationsPerLine));
+        emit("findtransfer", "7", bench::stationName(i, (k % (stationsPerLine / 10)) * 10 + 5));
+        emit("find", "6", line + ' ' + renamed);
+        emit("rm", "4", line + ' ' + renamed);
+        if (menuForm)
+            trace += "8\n";
+        else
+            trace += "validate\n";
+    }
+    return trace;
+}
+
+void BM_BatchReplay(benchmark::State &state) {
+    size_t commands = static_cast<size_t>(state.range(0));
+    string trace = makeTrace(commands, false);
+    int fd = ::open("/dev/null", O_WRONLY);
+    BatchStats stats;
+    for (auto _ : state) {
+        state.PauseTiming();
+        MetroSystem system = network();
+        std::istringstream in(trace);
+        state.ResumeTiming();
+        mgc::TextSink out(fd);
+        stats = BatchRunner(system).run(in, out);
+        out.flush();
+    }
+    ::close(fd);
+    if (stats.errors)
+        state.SkipWithError("trace commands failed");
+    state.SetItemsProcessed(state.iterations() * stats.commands);
+}
+BENCHMARK(BM_BatchReplay)->Arg(100'000)->Arg(1'000'000)->Unit(benchmark::kMillisecond);
+
+/// The same trace typed into UI::update, with std::cin and std::cout redirected.
+void BM_MenuReplay(benchmark::State &state) {
+    size_t commands = static_cast<size_t>(state.range(0));
+    string trace = makeTrace(commands, true);
+    std::ofstream devNull("/dev/null");
+    for (auto _ : state) {
+        state.PauseTiming();
+        MetroSystem system = network();
+        std::istringstream in(trace);
+        auto *oldIn = std::cin.rdbuf(in.rdbuf());
+        auto *oldOut = std::cout.rdbuf(devNull.rdbuf());
+        state.ResumeTiming();
+        UI(system).update();
+        devNull.flush();
+        state.PauseTiming();
+        std::cin.rdbuf(oldIn);
+        std::cout.rdbuf(oldOut);
+        std::cin.clear();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * commands);
+}
+BENCHMARK(BM_MenuReplay)->Arg(100'000)->Unit(benchmark::kMillisecond);
+
+} // namespace
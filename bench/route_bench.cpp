@@ -0,0 +1,138 @@
+#include <benchmark/benchmark.h>
+#include "bench_network.hpp"
+#include <random>
+#include <vector>
+
+using namespace mgm;
+
+/**
+ * @file route_bench.cpp
+ * @brief Latency of point-to-point route queries on a 20-line, 5k-station network.
+ *
+ * The cached variants repeat a fixed set of pairs, as a journey planner front end
+ * would; with 4096 pairs the 1024-entry cache mostly misses and evicts.
+ */
+
+namespace {
+
+constexpr size_t Lines = 20;
+constexpr size_t StationsPerLine = 250;
+constexpr size_t TransferEvery = 10;
+
+const MetroSystem &network() {
+    static const MetroSystem system = bench::makeGridNetwork(Lines, StationsPerLine, TransferEvery);
+    return system;
+}
+
+std::vector<std::pair<uint32_t, uint32_t>> randomPairs(uint32_t nodeCount, size_t n) {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<uint32_t> pick(0, nodeCount - 1);
+    std::vector<std::pair<uint32_t, uint32_t>> pairs(n);
+    for (auto &p : pairs)
+        p = {pick(rng), pick(rng)};
+    return pairs;
+}
+
+void BM_RouteGraphBuild(benchmark::State &state) {
+    std::vector<const Line *> lines;
+    for (const auto &linePair : network().getLines())
+        lines.push_back(&linePair.second);
+    for (auto _ : state) {
+        RouteGraph graph = RouteGraph::build(lines);
+        benchmark::DoNotOptimize(graph.edgeCount());
+    }
+    state.counters["nodes"] = network().getRouteGraph().nodeCount();
+    state.counters["edges"] = network().getRouteGraph().edgeCount();
+}
+
+/// Engine latency: integer node IDs straight on the CSR view.
+void BM_RouteQuery(benchmark::State &state) {
+    const RouteGraph &graph = network().getRouteGraph();
+    auto cost = static_cast<RouteCost>(state.range(0));
+    auto pairs = randomPairs(graph.nodeCount(), 1024);
+    RouteFinder finder;
+    size_t i = 0;
+    for (auto _ : state) {
+        auto [from, to] = pairs[i++ & 1023];
+        auto path = finder.search(graph.view(), std::span(&from, 1), std::span(&to, 1), cost);
+        benchmark::DoNotOptimize(path);
+    }
+    state.SetLabel(cost == RouteCost::FewestStops ? "fewest stops" : "fewest transfers");
+}
+
+/// End-to-end latency through MetroSystem, with names in and names out, route cache off.
+void BM_MetroSystemFindRoute(benchmark::State &state) {
+    MetroSystem system = network();
+    system.setRouteCacheCapacity(0);
+    const RouteGraph &graph = system.getRouteGraph();
+    auto cost = static_cast<RouteCost>(state.range(0));
+    auto pairs = randomPairs(graph.nodeCount(), 1024);
+    std::vector<std::pair<string, string>> names;
+    for (auto [from, to] : pairs)
+        names.emplace_back(graph.stationName(from), graph.stationName(to));
+    size_t i = 0;
+    for (auto _ : state) {
+        const auto &[from, to] = names[i++ & 1023];
+        auto route = system.findRoute(from, to, cost);
+        benchmark::DoNotOptimize(route);
+    }
+    state.SetLabel(cost == RouteCost::FewestStops ? "fewest stops" : "fewest transfers");
+}
+
+/// The same queries repeated over a few hundred hot pairs, answered by the route cache.
+/// Arguments: cost model, number of distinct pairs.
+void BM_MetroSystemFindRouteCached(benchmark::State &state) {
+    MetroSystem system = network();
+    const RouteGraph &graph = system.getRouteGraph();
+    auto cost = static_cast<RouteCost>(state.range(0));
+    auto distinct = static_cast<size_t>(state.range(1));
+    auto pairs = randomPairs(graph.nodeCount(), distinct);
+    std::vector<std::pair<string, string>> names;
+    for (auto [from, to] : pairs)
+        names.emplace_back(graph.stationName(from), graph.stationName(to));
+    std::mt19937 rng(7);
+    std::vector<uint32_t> order(4096);
+    for (auto &i : order)
+        i = static_cast<uint32_t>(rng() % distinct);
+    size_t i = 0;
+    for (auto _ : state) {
+        const auto &[from, to] = names[order[i++ & 4095]];
+        auto route = system.findRoute(from, to, cost);
+        benchmark::DoNotOptimize(route);
+    }
+    const RouteCacheStats &stats = system.getRouteCacheStats();
+    state.counters["hit_rate"] = static_cast<double>(stats.hits) / static_cast<double>(stats.hits + stats.misses);
+    state.SetLabel(cost == RouteCost::FewestStops ? "fewest stops" : "fewest transfers");
+}
+
+/// An edit that drops the routes through one of 20 lines, with the cache full.
+void BM_RouteCacheInvalidateLine(benchmark::State &state) {
+    MetroSystem system = network();
+    const RouteGraph &graph = system.getRouteGraph();
+    auto pairs = randomPairs(graph.nodeCount(), RouteCache::DefaultCapacity);
+    std::vector<std::pair<string, string>> names;
+    for (auto [from, to] : pairs)
+        names.emplace_back(graph.stationName(from), graph.stationName(to));
+    size_t dropped = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        for (const auto &[from, to] : names)
+            system.findRoute(from, to);
+        uint64_t before = system.getRouteCacheStats().invalidations;
+        state.ResumeTiming();
+        system.removeStationFromLine("L3", bench::stationName(3, StationsPerLine - 1));
+        state.PauseTiming();
+        dropped += system.getRouteCacheStats().invalidations - before;
+        system.addStationToLine("L3", station(bench::stationName(3, StationsPerLine - 1)));
+        state.ResumeTiming();
+    }
+    state.counters["dropped"] = benchmark::Counter(static_cast<double>(dropped), benchmark::Counter::kAvgIterations);
+}
+
+} // namespace
+
+BENCHMARK(BM_RouteGraphBuild)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_RouteQuery)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_MetroSystemFindRoute)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_MetroSystemFindRouteCached)->ArgsProduct({{0, 1}, {256, 4096}})->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_RouteCacheInvalidateLine)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,69 @@
+#include <benchmark/benchmark.h>
+#include "bench_network.hpp"
+#include "../snapshot/snapshot.hpp"
+#include <filesystem>
+
+using namespace mgm;
+
+/**
+ * @file snapshot_bench.cpp
+ * @brief Cold start and query cost of a mapped 100k-station snapshot.
+ *
+ * The file stays in the page cache between iterations, so the cold start figure
+ * is the cost of mapping and checking the snapshot, not of reading the disk.
+ */
+
+namespace {
+
+const MetroSystem &network() {
+    static const MetroSystem system = bench::makeGridNetwork(100, 1000, 10);
+    return system;
+}
+
+const string &snapshotPath() {
+    static const string path = [] {
+        string p = (std::filesystem::temp_directory_path() / "metro_bench_snapshot.bin").string();
+        saveSnapshot(network(), p);
+        return p;
+    }();
+    return path;
+}
+
+void BM_SnapshotSave(benchmark::State &state) {
+    const MetroSystem &system = network();
+    const string &path = snapshotPath();
+    for (auto _ : state)
+        saveSnapshot(system, path);
+    state.counters["bytes"] = static_cast<double>(std::filesystem::file_size(path));
+}
+
+/// Time from nothing to the first answered query.
+void BM_SnapshotColdStart(benchmark::State &state) {
+    const string &path = snapshotPath();
+    const string line = "L42", name = bench::stationName(42, 512);
+    for (auto _ : state) {
+        SnapshotView view(path);
+        benchmark::DoNotOptimize(view.findStationOnLine(line, name));
+    }
+}
+
+void BM_SnapshotFindStation(benchmark::State &state) {
+    SnapshotView view(snapshotPath());
+    const string line = "L42", name = bench::stationName(42, 512);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(view.findStationOnLine(line, name));
+}
+
+void BM_SnapshotRoute(benchmark::State &state) {
+    SnapshotView view(snapshotPath());
+    const string from = bench::stationName(3, 17), to = bench::stationName(88, 901);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(view.findRoute("L3", from, "L88", to));
+}
+
+} // namespace
+
+BENCHMARK(BM_SnapshotSave)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SnapshotColdStart)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_SnapshotFindStation);
+BENCHMARK(BM_SnapshotRoute)->Unit(benchmark::kMicrosecond);
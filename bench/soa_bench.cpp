@@ -0,0 +1,95 @@
+#include <benchmark/benchmark.h>
+#include "../line/metro_line.hpp"
+#include "../Stations/transitionstation.hpp"
+#include <string>
+
+using namespace mgm;
+
+/**
+ * @file soa_bench.cpp
+ * @brief Scans over the station objects of a line versus its packed columns.
+ *
+ * The line holds 1M stations, every eighth a transition station, allocated
+ * on the heap as in the default storage mode.
+ */
+
+namespace {
+
+constexpr size_t stationCount = 1'000'000;
+
+const Line &bigLine() {
+    static const Line line = [] {
+        Line l("Big");
+        l.reserve(stationCount);
+        for (size_t i = 0; i < stationCount; ++i) {
+            string name = "S" + std::to_string(i);
+            if (i % 8 == 4)
+                l.addElement(transition_station(name));
+            else
+                l.addElement(station(name));
+        }
+        return l;
+    }();
+    return line;
+}
+
+/// Filter by type through the objects: one pointer chase per station.
+void BM_CountTransitions_Objects(benchmark::State &state) {
+    const Line &line = bigLine();
+    for (auto _ : state) {
+        size_t count = 0;
+        for (const auto &stationPair : line.getStations())
+            count += stationPair.second->getKind() == StationKind::Transition;
+        benchmark::DoNotOptimize(count);
+    }
+    state.SetItemsProcessed(state.iterations() * stationCount);
+}
+BENCHMARK(BM_CountTransitions_Objects)->Unit(benchmark::kMicrosecond);
+
+/// Filter by type over the kind column: one byte per station.
+void BM_CountTransitions_Column(benchmark::State &state) {
+    const Line &line = bigLine();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(line.countOfKind(StationKind::Transition));
+    state.SetItemsProcessed(state.iterations() * stationCount);
+}
+BENCHMARK(BM_CountTransitions_Column)->Unit(benchmark::kMicrosecond);
+
+/// Collecting the transition stations through the objects.
+void BM_TransitionSlots_Objects(benchmark::State &state) {
+    const Line &line = bigLine();
+    for (auto _ : state) {
+        std::vector<size_t> slots;
+        const auto &table = line.getStations();
+        for (size_t slot = 0; slot < table.size(); ++slot) {
+            if (table[slot].second->getKind() == StationKind::Transition)
+                slots.push_back(slot);
+        }
+        benchmark::DoNotOptimize(slots.data());
+    }
+    state.SetItemsProcessed(state.iterations() * stationCount);
+}
+BENCHMARK(BM_TransitionSlots_Objects)->Unit(benchmark::kMicrosecond);
+
+void BM_TransitionSlots_Column(benchmark::State &state) {
+    const Line &line = bigLine();
+    for (auto _ : state) {
+        auto slots = line.slotsOfKind(StationKind::Transition);
+        benchmark::DoNotOptimize(slots.data());
+    }
+    state.SetItemsProcessed(state.iterations() * stationCount);
+}
+BENCHMARK(BM_TransitionSlots_Column)->Unit(benchmark::kMicrosecond);
+
+/// Line::getTableStr, now built from the name and type columns.
+void BM_TableStr(benchmark::State &state) {
+    const Line &line = bigLine();
+    for (auto _ : state) {
+        string text = line.getTableStr();
+        benchmark::DoNotOptimize(text.data());
+    }
+    state.SetItemsProcessed(state.iterations() * stationCount);
+}
+BENCHMARK(BM_TableStr)->Unit(benchmark::kMillisecond);
+
+} // namespace
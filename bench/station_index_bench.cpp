@@ -0,0 +1,76 @@
+#include <benchmark/benchmark.h>
+#include "bench_network.hpp"
+
+using namespace mgm;
+
+/**
+ * @file station_index_bench.cpp
+ * @brief Transition station lookup by name on a 50-line system.
+ *
+ * Compares the system-wide name index against the per-line scan that catches
+ * one std::invalid_argument for every line the station is not on.
+ */
+
+namespace {
+
+const MetroSystem &network() {
+    static const MetroSystem system = bench::makeGridNetwork(50, 40, 8);
+    return system;
+}
+
+/// The lookup as it was done before the index: one Line::find per line.
+std::shared_ptr<station> scanLines(const MetroSystem &system, const string &name) {
+    for (const auto &linePair : system.getLines()) {
+        try {
+            auto st = linePair.second.find(name);
+            if (st->getType() == "transition")
+                return st;
+        } catch (...) {
+        }
+    }
+    return nullptr;
+}
+
+/// A transition station on the line the scan visits last.
+const string &queryName() {
+    static const string name = [] {
+        string last;
+        for (const auto &linePair : network().getLines())
+            last = linePair.first.str();
+        return bench::stationName(std::stoul(last.substr(1)), 4);
+    }();
+    return name;
+}
+
+void BM_TransitionLookup_LineScan(benchmark::State &state) {
+    const MetroSystem &system = network();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(scanLines(system, queryName()));
+}
+
+void BM_TransitionLookup_Index(benchmark::State &state) {
+    const MetroSystem &system = network();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(system.findTransitionStationByName(queryName()));
+}
+
+void BM_TransitionLookup_IndexMiss(benchmark::State &state) {
+    const MetroSystem &system = network();
+    const string missing = "Nowhere";
+    for (auto _ : state)
+        benchmark::DoNotOptimize(system.tryFindTransitionStationByName(missing));
+}
+
+void BM_StationOnLine_TryFind(benchmark::State &state) {
+    const MetroSystem &system = network();
+    const string line = system.findLinesOfStation(queryName()).front();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(system.tryFindStationOnLine(line, queryName()));
+}
+
+} // namespace
+
+BENCHMARK(BM_TransitionLookup_LineScan);
+BENCHMARK(BM_TransitionLookup_Index);
+BENCHMARK(BM_TransitionLookup_IndexMiss);
+BENCHMARK(BM_StationOnLine_TryFind);
@@ -0,0 +1,264 @@
+#include <benchmark/benchmark.h>
+#include "bench_network.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace mgm;
+
+/**
+ * @file suite_bench.cpp
+ * @brief Release-comparison suite: LookupTable, Line and MetroSystem hot paths per network size.
+ *
+ * Every benchmark takes the network size as two arguments, lines and stations per
+ * line. METRO_BENCH_SIZES overrides the default sizes with a comma-separated list
+ * like "10x100,100x1000"; the sizes used are recorded in the context of the output.
+ * The table benchmarks work on a HashedLookupTable<Symbol, int> holding one key per
+ * station of the network, the Line benchmarks on one line of the network's length,
+ * and the system benchmarks on bench::makeGridNetwork() with a transfer every 10
+ * stations. The bench_json target runs the suite with JSON output for diffing
+ * between releases.
+ */
+
+namespace {
+
+using Table = mgc::HashedLookupTable<mgc::Symbol, int>;
+
+std::vector<std::pair<int64_t, int64_t>> suiteSizes() {
+    std::vector<std::pair<int64_t, int64_t>> sizes;
+    const char *spec = std::getenv("METRO_BENCH_SIZES");
+    string text = spec ? spec : "10x100,100x1000";
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t end = text.find(',', pos);
+        if (end == string::npos)
+            end = text.size();
+        string item = text.substr(pos, end - pos);
+        size_t x = item.find('x');
+        if (x != string::npos) {
+            int64_t lines = std::atoll(item.c_str());
+            int64_t perLine = std::atoll(item.c_str() + x + 1);
+            if (lines > 0 && perLine > 0)
+                sizes.emplace_back(lines, perLine);
+        }
+        pos = end + 1;
+    }
+    string recorded;
+    for (const auto &[lines, perLine] : sizes)
+        recorded += (recorded.empty() ? "" : ",") + std::to_string(lines) + "x" + std::to_string(perLine);
+    benchmark::AddCustomContext("metro_network_sizes", recorded);
+    return sizes;
+}
+
+void networkSizes(benchmark::internal::Benchmark *b) {
+    static const auto sizes = suiteSizes();
+    b->ArgNames({"lines", "per_line"});
+    for (const auto &[lines, perLine] : sizes)
+        b->Args({lines, perLine});
+}
+
+size_t linesOf(const benchmark::State &state) { return static_cast<size_t>(state.range(0)); }
+size_t perLineOf(const benchmark::State &state) { return static_cast<size_t>(state.range(1)); }
+
+const MetroSystem &network(size_t lines, size_t perLine) {
+    static std::map<std::pair<size_t, size_t>, MetroSystem> built;
+    auto it = built.find({lines, perLine});
+    if (it == built.end())
+        it = built.emplace(std::pair{lines, perLine}, bench::makeGridNetwork(lines, perLine, 10)).first;
+    return it->second;
+}
+
+/// The station names of the network, line by line, interned.
+std::vector<mgc::Symbol> stationKeys(size_t lines, size_t perLine) {
+    std::vector<mgc::Symbol> keys;
+    keys.reserve(lines * perLine);
+    for (size_t i = 0; i < lines; ++i) {
+        for (size_t j = 0; j < perLine; ++j)
+            keys.emplace_back(bench::stationName(i, j));
+    }
+    return keys;
+}
+
+/// A fixed order that visits every index below @p n once, scattered over the range.
+std::vector<size_t> scattered(size_t n) {
+    std::vector<size_t> order(n);
+    size_t stride = 7919 % n ? 7919 : 7907;
+    for (size_t i = 0; i < n; ++i)
+        order[i] = i * stride % n;
+    return order;
+}
+
+Table buildTable(const std::vector<mgc::Symbol> &keys) {
+    Table table;
+    table.reserve(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i)
+        table.insert(keys[i], static_cast<int>(i));
+    return table;
+}
+
+void BM_SuiteTableInsert(benchmark::State &state) {
+    auto keys = stationKeys(linesOf(state), perLineOf(state));
+    for (auto _ : state) {
+        Table table;
+        for (size_t i = 0; i < keys.size(); ++i)
+            table.insert(keys[i], static_cast<int>(i));
+        benchmark::DoNotOptimize(table.data());
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+BENCHMARK(BM_SuiteTableInsert)->Apply(networkSizes)->Unit(benchmark::kMicrosecond);
+
+void BM_SuiteTableFind(benchmark::State &state) {
+    auto keys = stationKeys(linesOf(state), perLineOf(state));
+    Table table = buildTable(keys);
+    auto order = scattered(keys.size());
+    for (auto _ : state) {
+        size_t sum = 0;
+        for (size_t i : order)
+            sum += table.find(keys[i]);
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+BENCHMARK(BM_SuiteTableFind)->Apply(networkSizes)->Unit(benchmark::kMicrosecond);
+
+/// Erases 1% of the keys, scattered, from a fresh copy; the copy is not timed.
+void BM_SuiteTableErase(benchmark::State &state) {
+    auto keys = stationKeys(linesOf(state), perLineOf(state));
+    Table table = buildTable(keys);
+    auto order = scattered(keys.size());
+    order.resize(std::max<size_t>(1, keys.size() / 100));
+    for (auto _ : state) {
+        state.PauseTiming();
+        Table copy = table;
+        state.ResumeTiming();
+        for (size_t i : order)
+            copy.erase(keys[i]);
+        benchmark::DoNotOptimize(copy.data());
+    }
+    state.SetItemsProcessed(state.iterations() * order.size());
+}
+BENCHMARK(BM_SuiteTableErase)->Apply(networkSizes)->Unit(benchmark::kMicrosecond);
+
+void BM_SuiteTableCopy(benchmark::State &state) {
+    Table table = buildTable(stationKeys(linesOf(state), perLineOf(state)));
+    for (auto _ : state) {
+        Table copy = table;
+        benchmark::DoNotOptimize(copy.data());
+    }
+    state.SetItemsProcessed(state.iterations() * table.size());
+}
+BENCHMARK(BM_SuiteTableCopy)->Apply(networkSizes)->Unit(benchmark::kMicrosecond);
+
+std::vector<string> lineStationNames(size_t perLine) {
+    std::vector<string> names;
+    names.reserve(perLine);
+    for (size_t j = 0; j < perLine; ++j)
+        names.push_back(bench::stationName(0, j));
+    return names;
+}
+
+void BM_SuiteLineAdd(benchmark::State &state) {
+    auto names = lineStationNames(perLineOf(state));
+    for (auto _ : state) {
+        Line line("L0");
+        for (const auto &name : names)
+            line.addElement(station(name));
+        benchmark::DoNotOptimize(line.getStations().size());
+    }
+    state.SetItemsProcessed(state.iterations() * names.size());
+}
+BENCHMARK(BM_SuiteLineAdd)->Apply(networkSizes)->Unit(benchmark::kMicrosecond);
+
+void BM_SuiteLineFind(benchmark::State &state) {
+    const Line &line = network(linesOf(state), perLineOf(state)).findLine("L0");
+    auto names = lineStationNames(perLineOf(state));
+    auto order = scattered(names.size());
+    for (auto _ : state) {
+        for (size_t i : order)
+            benchmark::DoNotOptimize(line.find(names[i]).get());
+    }
+    state.SetItemsProcessed(state.iterations() * names.size());
+}
+BENCHMARK(BM_SuiteLineFind)->Apply(networkSizes)->Unit(benchmark::kMicrosecond);
+
+/// Removes a tenth of the stations, scattered, from a fresh copy of the line; the copy is not timed.
+void BM_SuiteLineRemove(benchmark::State &state) {
+    const Line &line = network(linesOf(state), perLineOf(state)).findLine("L0");
+    auto names = lineStationNames(perLineOf(state));
+    auto order = scattered(names.size());
+    order.resize(std::max<size_t>(1, names.size() / 10));
+    for (auto _ : state) {
+        state.PauseTiming();
+        Line copy = line;
+        state.ResumeTiming();
+        for (size_t i : order)
+            copy.removeElement(names[i]);
+        benchmark::DoNotOptimize(copy.getStations().size());
+    }
+    state.SetItemsProcessed(state.iterations() * order.size());
+}
+BENCHMARK(BM_SuiteLineRemove)->Apply(networkSizes)->Unit(benchmark::kMicrosecond);
+
+void BM_SuiteSystemFindStation(benchmark::State &state) {
+    size_t lines = linesOf(state), perLine = perLineOf(state);
+    const MetroSystem &system = network(lines, perLine);
+    std::vector<std::pair<string, string>> queries;
+    for (size_t k : scattered(lines * perLine))
+        queries.emplace_back("L" + std::to_string(k / perLine), bench::stationName(k / perLine, k % perLine));
+    for (auto _ : state) {
+        for (const auto &[line, name] : queries)
+            benchmark::DoNotOptimize(system.findStationOnLine(line, name).get());
+    }
+    state.SetItemsProcessed(state.iterations() * queries.size());
+}
+BENCHMARK(BM_SuiteSystemFindStation)->Apply(networkSizes)->Unit(benchmark::kMicrosecond);
+
+void BM_SuiteSystemFindTransition(benchmark::State &state) {
+    size_t lines = linesOf(state), perLine = perLineOf(state);
+    const MetroSystem &system = network(lines, perLine);
+    std::vector<string> names;
+    for (size_t i = 0; i < lines; ++i) {
+        for (size_t j = 5; j < perLine; j += 10)
+            names.push_back(bench::stationName(i, j));
+    }
+    if (lines < 2 || names.empty()) {
+        state.SkipWithError("network has no transition stations");
+        return;
+    }
+    for (auto _ : state) {
+        for (const auto &name : names)
+            benchmark::DoNotOptimize(system.findTransitionStationByName(name).get());
+    }
+    state.SetItemsProcessed(state.iterations() * names.size());
+}
+BENCHMARK(BM_SuiteSystemFindTransition)->Apply(networkSizes)->Unit(benchmark::kMicrosecond);
+
+/// Full validation of a fresh copy, as after loading; the copy is not timed.
+void BM_SuiteSystemValidate(benchmark::State &state) {
+    const MetroSystem &system = network(linesOf(state), perLineOf(state));
+    for (auto _ : state) {
+        state.PauseTiming();
+        MetroSystem copy = system;
+        state.ResumeTiming();
+        benchmark::DoNotOptimize(copy.validateSystem(ValidationMode::Full));
+    }
+    state.SetItemsProcessed(state.iterations() * linesOf(state) * perLineOf(state));
+}
+BENCHMARK(BM_SuiteSystemValidate)->Apply(networkSizes)->Unit(benchmark::kMicrosecond);
+
+void BM_SuiteSystemDescribe(benchmark::State &state) {
+    const MetroSystem &system = network(linesOf(state), perLineOf(state));
+    for (auto _ : state) {
+        string text = system.getSystemDescription();
+        benchmark::DoNotOptimize(text.data());
+    }
+    state.SetItemsProcessed(state.iterations() * linesOf(state) * perLineOf(state));
+    state.SetBytesProcessed(state.iterations() * system.getSystemDescriptionSize());
+}
+BENCHMARK(BM_SuiteSystemDescribe)->Apply(networkSizes)->Unit(benchmark::kMicrosecond);
+
+} // namespace
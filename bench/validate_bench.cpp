@@ -0,0 +1,80 @@
+#include <benchmark/benchmark.h>
+#include "bench_network.hpp"
+#include <chrono>
+
+using namespace mgm;
+
+/**
+ * @file validate_bench.cpp
+ * @brief Cost of validateSystem() against network size and number of edits.
+ *
+ * Each edit removes a station that transition stations are connected to and adds
+ * it back, so the connections stay valid and every iteration does the same work.
+ * Only the validateSystem() call is timed. The 200k-station runs compare the
+ * serial full pass with the parallel one at 1 to 16 threads.
+ */
+
+namespace {
+
+MetroSystem &network(size_t stations) {
+    static MetroSystem small = bench::makeGridNetwork(50, 200, 10);
+    static MetroSystem large = bench::makeGridNetwork(200, 500, 10);
+    MetroSystem &system = stations <= 10000 ? small : large;
+    system.validateSystem(ValidationMode::Full);
+    return system;
+}
+
+/// Arguments: network size in stations, number of edits before validation.
+void BM_ValidateIncremental(benchmark::State &state) {
+    size_t stations = static_cast<size_t>(state.range(0));
+    size_t edits = static_cast<size_t>(state.range(1));
+    MetroSystem &system = network(stations);
+    size_t lineCount = system.getLines().size();
+    for (auto _ : state) {
+        for (size_t e = 0; e < edits; ++e) {
+            // Slot 5 of line i+1 is connected to by slot 5 of line i.
+            string line = "L" + std::to_string((e + 1) % lineCount);
+            string name = bench::stationName((e + 1) % lineCount, 5);
+            system.removeStationFromLine(line, name);
+            system.addStationToLine(line, station(name));
+        }
+        auto start = std::chrono::steady_clock::now();
+        benchmark::DoNotOptimize(system.validateSystem());
+        auto stop = std::chrono::steady_clock::now();
+        state.SetIterationTime(std::chrono::duration<double>(stop - start).count());
+    }
+}
+
+void BM_ValidateFull(benchmark::State &state) {
+    MetroSystem &system = network(static_cast<size_t>(state.range(0)));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(system.validateSystem(ValidationMode::Full));
+}
+
+/// Full validation of 200 lines of 1000 stations, serial and with 1 to 16 threads.
+MetroSystem &parallelNetwork() {
+    static MetroSystem system = bench::makeGridNetwork(200, 1000, 10);
+    return system;
+}
+
+void BM_ValidateFull200k(benchmark::State &state) {
+    MetroSystem &system = parallelNetwork();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(system.validateSystem(ValidationMode::Full));
+}
+
+void BM_ValidateParallel200k(benchmark::State &state) {
+    MetroSystem &system = parallelNetwork();
+    auto threads = static_cast<unsigned>(state.range(0));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(system.validateSystem(ValidationMode::Parallel, threads));
+    state.counters["threads"] = threads;
+}
+
+} // namespace
+
+BENCHMARK(BM_ValidateFull200k)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_ValidateParallel200k)->RangeMultiplier(2)->Range(1, 16)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_ValidateIncremental)->ArgsProduct({{10000, 100000}, {1, 10, 100}})
+    ->UseManualTime()->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_ValidateFull)->Arg(10000)->Arg(100000)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,164 @@
+#ifndef ARENA_HPP_
+#define ARENA_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace mgc {
+/**
+ * @file arena.hpp
+ * @brief Chunked arena with per-size free lists, and an allocator drawing from it.
+ */
+
+/**
+ * @brief Bump allocator over large chunks, with free lists for released blocks.
+ *
+ * Blocks are carved out of chunks in allocation order, so objects allocated
+ * together sit next to each other in memory. A released block goes to a free
+ * list for its size and alignment and is handed out again by the next request
+ * of the same shape. Chunks are returned to the system only when the arena is
+ * destroyed, all at once. Allocation and release are serialised by a mutex,
+ * so the last owner of an object may release it from any thread.
+ */
+class Arena {
+public:
+    /**
+     * @brief Constructs an empty arena.
+     * @param chunkSize Size of the chunks requested from the system.
+     */
+    explicit Arena(size_t chunkSize = 64 * 1024) : m_chunkSize(chunkSize) { m_freeLists.reserve(4); }
+
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    /**
+     * @brief Allocates a block.
+     * @param bytes Size of the block.
+     * @param align Alignment of the block; at most alignof(std::max_align_t).
+     * @return Pointer to the block.
+     * @throws std::bad_alloc if a new chunk cannot be obtained.
+     */
+    void *allocate(size_t bytes, size_t align) {
+        bytes = roundUp(std::max(bytes, sizeof(void *)), alignof(void *));
+        std::lock_guard lock(mutex);
+        auto list = std::find_if(m_freeLists.begin(), m_freeLists.end(), [&](const FreeList &l) {
+            return l.size == bytes && l.align == align;
+        });
+        if (list == m_freeLists.end()) {
+            // Registered here, so that deallocate() never has to grow the lists.
+            m_freeLists.push_back(FreeList{bytes, align, nullptr});
+        } else if (list->head) {
+            void *p = list->head;
+            list->head = *static_cast<void **>(p);
+            return p;
+        }
+        uintptr_t at = roundUp(reinterpret_cast<uintptr_t>(m_cursor), align);
+        if (!m_cursor || at + bytes > reinterpret_cast<uintptr_t>(m_end)) {
+            size_t size = std::max(m_chunkSize, bytes + align);
+            m_chunks.push_back(std::make_unique<std::byte[]>(size));
+            m_cursor = m_chunks.back().get();
+            m_end = m_cursor + size;
+            m_reserved += size;
+            at = roundUp(reinterpret_cast<uintptr_t>(m_cursor), align);
+        }
+        m_cursor = reinterpret_cast<std::byte *>(at + bytes);
+        return reinterpret_cast<void *>(at);
+    }
+
+    /**
+     * @brief Returns a block to the free list of its size.
+     *
+     * The list was registered by the allocate() that made the block, so releasing
+     * does not allocate.
+     *
+     * @param p Pointer returned by allocate().
+     * @param bytes The size passed to allocate().
+     * @param align The alignment passed to allocate().
+     */
+    void deallocate(void *p, size_t bytes, size_t align) noexcept {
+        bytes = roundUp(std::max(bytes, sizeof(void *)), alignof(void *));
+        std::lock_guard lock(mutex);
+        for (FreeList &list : m_freeLists) {
+            if (list.size == bytes && list.align == align) {
+                *static_cast<void **>(p) = list.head;
+                list.head = p;
+                return;
+            }
+        }
+    }
+
+    /**
+     * @brief Gets the number of bytes obtained from the system.
+     * @return The total size of the chunks.
+     */
+    size_t bytesReserved() const {
+        std::lock_guard lock(mutex);
+        return m_reserved;
+    }
+
+private:
+    struct FreeList {
+        size_t size;  ///< Block size served by the list.
+        size_t align; ///< Block alignment served by the list.
+        void *head;   ///< First free block; each block stores the next one.
+    };
+
+    template <typename N>
+    static N roundUp(N n, size_t align) noexcept {
+        return (n + align - 1) / align * align;
+    }
+
+    size_t m_chunkSize;
+    size_t m_reserved = 0;
+    std::byte *m_cursor = nullptr;
+    std::byte *m_end = nullptr;
+    std::vector<std::unique_ptr<std::byte[]>> m_chunks;
+    std::vector<FreeList> m_freeLists; ///< One list per block shape; stations need two or three.
+    mutable std::mutex mutex;
+};
+
+/**
+ * @brief Standard allocator drawing from a shared Arena.
+ *
+ * Every copy keeps the arena alive, so objects made with std::allocate_shared
+ * (which stores the allocator in the control block) can outlive the owner of
+ * the arena.
+ *
+ * @tparam T Type of the allocated objects.
+ */
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    /**
+     * @brief Constructs an allocator for an arena.
+     * @param arena The arena to draw from.
+     */
+    explicit ArenaAllocator(std::shared_ptr<Arena> arena) noexcept : m_arena(std::move(arena)) {}
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U> &other) noexcept : m_arena(other.m_arena) {}
+
+    T *allocate(size_t n) { return static_cast<T *>(m_arena->allocate(n * sizeof(T), alignof(T))); }
+
+    void deallocate(T *p, size_t n) noexcept { m_arena->deallocate(p, n * sizeof(T), alignof(T)); }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U> &other) const noexcept { return m_arena == other.m_arena; }
+
+private:
+    template <typename U>
+    friend class ArenaAllocator;
+
+    std::shared_ptr<Arena> m_arena;
+};
+
+}
+
+#endif
@@ -0,0 +1,146 @@
+#ifndef BYTE_SCAN_HPP_
+#define BYTE_SCAN_HPP_
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MGC_BYTE_SCAN_X86 1
+#endif
+
+namespace mgc {
+/**
+ * @file byteScan.hpp
+ * @brief Search of a byte array for a byte value, with SIMD versions picked at run time.
+ *
+ * On x86 the SSE2 version compares 16 bytes and the AVX2 version 32 bytes per
+ * step; findByte() uses the widest one the CPU supports. Elsewhere only the
+ * scalar version exists.
+ */
+
+/**
+ * @brief Implementations of the byte search.
+ */
+enum class ByteScan : uint8_t {
+    Scalar, ///< One byte per step.
+    SSE2,   ///< 16 bytes per step.
+    AVX2    ///< 32 bytes per step.
+};
+
+namespace detail {
+
+inline size_t findByteScalar(const uint8_t *data, size_t from, size_t size, uint8_t value) noexcept {
+    for (size_t i = from; i < size; ++i) {
+        if (data[i] == value)
+            return i;
+    }
+    return size;
+}
+
+#ifdef MGC_BYTE_SCAN_X86
+__attribute__((target("sse2")))
+inline size_t findByteSse2(const uint8_t *data, size_t from, size_t size, uint8_t value) noexcept {
+    const __m128i needle = _mm_set1_epi8(static_cast<char>(value));
+    size_t i = from;
+    for (; i + 16 <= size; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        auto mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle)));
+        if (mask)
+            return i + static_cast<size_t>(std::countr_zero(mask));
+    }
+    return findByteScalar(data, i, size, value);
+}
+
+__attribute__((target("avx2")))
+inline size_t findByteAvx2(const uint8_t *data, size_t from, size_t size, uint8_t value) noexcept {
+    const __m256i needle = _mm256_set1_epi8(static_cast<char>(value));
+    size_t i = from;
+    for (; i + 32 <= size; i += 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+        auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, needle)));
+        if (mask)
+            return i + static_cast<size_t>(std::countr_zero(mask));
+    }
+    return findByteSse2(data, i, size, value);
+}
+#endif
+
+using FindByteFn = size_t (*)(const uint8_t *, size_t, size_t, uint8_t) noexcept;
+
+inline FindByteFn findByteFn(ByteScan scan) noexcept {
+#ifdef MGC_BYTE_SCAN_X86
+    if (scan == ByteScan::AVX2)
+        return findByteAvx2;
+    if (scan == ByteScan::SSE2)
+        return findByteSse2;
+#else
+    (void)scan;
+#endif
+    return findByteScalar;
+}
+
+} // namespace detail
+
+/**
+ * @brief Checks whether the CPU can run an implementation.
+ * @param scan The implementation.
+ * @return true if findByte(scan, ...) can be called on this machine.
+ */
+inline bool byteScanSupported(ByteScan scan) noexcept {
+#ifdef MGC_BYTE_SCAN_X86
+    switch (scan) {
+    case ByteScan::Scalar:
+        return true;
+    case ByteScan::SSE2:
+        return __builtin_cpu_supports("sse2");
+    case ByteScan::AVX2:
+        return __builtin_cpu_supports("avx2");
+    }
+    return false;
+#else
+    return scan == ByteScan::Scalar;
+#endif
+}
+
+/**
+ * @brief Gets the widest implementation the CPU supports.
+ * @return The implementation used by findByte().
+ */
+inline ByteScan bestByteScan() noexcept {
+    static const ByteScan best = byteScanSupported(ByteScan::AVX2)   ? ByteScan::AVX2
+                                 : byteScanSupported(ByteScan::SSE2) ? ByteScan::SSE2
+                                                                     : ByteScan::Scalar;
+    return best;
+}
+
+/**
+ * @brief Finds the first occurrence of a byte, with a given implementation.
+ * @param scan The implementation; must be supported by the CPU.
+ * @param data The bytes to search.
+ * @param from Index to start at.
+ * @param size Number of bytes in @p data.
+ * @param value The byte to find.
+ * @return The index of the first @p value at or after @p from, or @p size.
+ */
+inline size_t findByte(ByteScan scan, const uint8_t *data, size_t from, size_t size, uint8_t value) noexcept {
+    return detail::findByteFn(scan)(data, from, size, value);
+}
+
+/**
+ * @brief Finds the first occurrence of a byte with the best implementation for the CPU.
+ * @param data The bytes to search.
+ * @param from Index to start at.
+ * @param size Number of bytes in @p data.
+ * @param value The byte to find.
+ * @return The index of the first @p value at or after @p from, or @p size.
+ */
+inline size_t findByte(const uint8_t *data, size_t from, size_t size, uint8_t value) noexcept {
+    static const detail::FindByteFn fn = detail::findByteFn(bestByteScan());
+    return fn(data, from, size, value);
+}
+
+}
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef COW_PTR_HPP_
+#define COW_PTR_HPP_
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+namespace mgc {
+/**
+ * @file cowPtr.hpp
+ * @brief Copy-on-write handle to a value shared between copies.
+ */
+
+/**
+ * @brief Handle whose copies share one value until one of them edits it.
+ *
+ * Copying a handle is O(1). edit() first copies the value if another handle
+ * still shares it, so an edit never shows through the other copies. Reading a
+ * default-constructed or moved-from handle gives a default-constructed T
+ * without allocating.
+ *
+ * Handles sharing a value may be read, copied and destroyed by different
+ * threads, as with std::shared_ptr; a single handle must not be edited while
+ * another thread copies it.
+ *
+ * @tparam T The value type; default and copy constructible.
+ */
+template <typename T>
+class CowPtr {
+public:
+    /**
+     * @brief Constructs a handle reading as a default-constructed T.
+     */
+    CowPtr() noexcept = default;
+
+    /**
+     * @brief Constructs a handle owning a value.
+     * @param value The value.
+     */
+    explicit CowPtr(T value) : m_ptr(std::make_shared<T>(std::move(value))) {}
+
+    /**
+     * @brief Reads the value.
+     * @return The value, shared with the copies of this handle.
+     */
+    const T& operator*() const noexcept { return m_ptr ? *m_ptr : empty(); }
+
+    /**
+     * @brief Reads a member of the value.
+     * @return Pointer to the value.
+     */
+    const T* operator->() const noexcept { return &**this; }
+
+    /**
+     * @brief Gets the value for editing, copying it first if it is shared.
+     * @return The value, owned by this handle alone until the handle is copied.
+     */
+    T& edit() {
+        if (!m_ptr) {
+            m_ptr = std::make_shared<T>();
+        } else if (m_ptr.use_count() > 1) {
+            m_ptr = std::make_shared<T>(std::as_const(*m_ptr));
+        } else {
+            // Orders the edits after the reads of owners that have just let go.
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+        return *m_ptr;
+    }
+
+    /**
+     * @brief Tells whether another handle shares the value.
+     * @return true if the next edit() copies the value.
+     */
+    bool shared() const noexcept { return m_ptr.use_count() > 1; }
+
+private:
+    static const T& empty() noexcept {
+        static const T instance{};
+        return instance;
+    }
+
+    std::shared_ptr<T> m_ptr; ///< Empty until the first edit.
+};
+
+}
+
+#endif
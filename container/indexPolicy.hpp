@@ -0,0 +1,414 @@
+#ifndef INDEX_POLICY_HPP_
+#define INDEX_POLICY_HPP_
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "byteScan.hpp"
+
+namespace mgc {
+/**
+ * @file indexPolicy.hpp
+ * @brief Index policies used by LookupTable to answer key lookups.
+ *
+ * A LookupTable always keeps its pairs in an insertion-ordered contiguous
+ * array. The index policy decides how find() locates a key in that array:
+ * LinearIndex scans it, FingerprintIndex scans a byte of hash per slot with
+ * SIMD compares, HashIndex keeps an open-addressing table of slot numbers
+ * next to it. The table notifies the policy about every structural
+ * change through the hooks below:
+ *
+ * - inserted(data, slot)         after a pair was constructed at @p slot; if it
+ *                                throws, the table destroys that pair again, so
+ *                                it must leave the index as it was;
+ * - erased(data, slot, size)     before the pair at @p slot is destroyed and
+ *                                the following pairs are shifted down by one;
+ * - swappedOut(data, slot, size) before the pair at @p slot is destroyed and
+ *                                the last pair is moved into its slot
+ *                                (UnorderedErase);
+ * - replacing(data, slot)        before the pair at @p slot is replaced in place;
+ * - replaced(data, slot)         after the new pair was constructed there;
+ * - reserve(n)                   when the table reserves room for @p n pairs;
+ * - clear()                      after all pairs were destroyed.
+ *
+ * find() is a template over the type of the searched key. A policy states in
+ * its @c accepts<K> constant whether a K may be looked up without converting
+ * it to Key first, which lets a table of std::string answer a std::string_view
+ * from a parse buffer without allocating.
+ */
+
+/**
+ * @brief Transparent hash of strings for the hashing index policies.
+ *
+ * Hashes std::string, std::string_view and string literals alike. Use it with
+ * std::equal_to<> as KeyEqual to look string keys up by std::string_view.
+ */
+struct StringHash {
+    using is_transparent = void;
+
+    size_t operator()(std::string_view text) const noexcept {
+        return std::hash<std::string_view>{}(text);
+    }
+};
+
+/**
+ * @brief Whether a hashing policy can look up a K in place of a Key.
+ *
+ * Either K is Key, or Hash and KeyEqual are both transparent and accept a K.
+ */
+template <typename Key, typename K, typename Hash, typename KeyEqual>
+inline constexpr bool hashedLookupAccepts =
+    std::is_same_v<K, Key> ||
+    (requires { typename Hash::is_transparent; typename KeyEqual::is_transparent; } &&
+     std::is_invocable_r_v<size_t, const Hash&, const K&> &&
+     std::is_invocable_r_v<bool, const KeyEqual&, const Key&, const K&>);
+
+/**
+ * @brief Index policy performing a linear scan (O(n)) over the pairs.
+ *
+ * Keeps no state, so it adds nothing to the size of the table.
+ *
+ * @tparam Key Type of the key.
+ */
+template <typename Key>
+class LinearIndex {
+public:
+    /// @brief Any type comparable with Key can be searched for.
+    template <typename K>
+    static constexpr bool accepts = requires(const Key& a, const K& b) {
+        { a == b } -> std::convertible_to<bool>;
+    };
+
+    /**
+     * @brief Finds the first slot holding @p key.
+     * @param key The key to search for, a Key or a type comparable with it.
+     * @param data Pointer to the pairs of the table.
+     * @param size Number of pairs in the table.
+     * @return The slot of the element if found; otherwise, @p size.
+     */
+    template <typename K, typename Pair>
+    size_t find(const K& key, const Pair* data, size_t size) const {
+        for (size_t i = 0; i < size; ++i) {
+            if (data[i].first == key) {
+                return i;
+            }
+        }
+        return size;
+    }
+
+    /// @brief Nothing to record: the scan always sees the current pairs.
+    template <typename Pair>
+    void inserted(const Pair*, size_t) noexcept {}
+
+    /// @brief Nothing to forget: the scan always sees the current pairs.
+    template <typename Pair>
+    void erased(const Pair*, size_t, size_t) noexcept {}
+
+    /// @brief Nothing to forget: the scan always sees the current pairs.
+    template <typename Pair>
+    void swappedOut(const Pair*, size_t, size_t) noexcept {}
+
+    /// @brief Nothing to forget: the scan always sees the current pairs.
+    template <typename Pair>
+    void replacing(const Pair*, size_t) noexcept {}
+
+    /// @brief Nothing to record: the scan always sees the current pairs.
+    template <typename Pair>
+    void replaced(const Pair*, size_t) noexcept {}
+
+    /// @brief No storage to size up front.
+    void reserve(size_t) noexcept {}
+
+    /// @brief No state to reset.
+    void clear() noexcept {}
+};
+
+/**
+ * @brief Index policy keeping an open-addressing hash table of slots.
+ *
+ * Buckets store the slot number of a pair together with 32 bits of its hash,
+ * so probing compares keys only on a hash match and rehashing never calls the
+ * hash function again. Collisions are resolved by linear probing and erasure
+ * uses backward-shift deletion, so the table never accumulates tombstones.
+ * find() runs in O(1) expected time. An ordered erase still renumbers the
+ * following slots, matching the O(n) shift done by the table; an unordered
+ * erase or an in-place replace only touches the buckets involved.
+ *
+ * Duplicate keys are allowed (as in LinearIndex) and find() returns the one
+ * inserted first, because equal keys share one probe sequence and keep their
+ * relative order in it. Unordered erase and replace do not keep that order.
+ *
+ * @tparam Key Type of the key.
+ * @tparam Hash Hash function object for Key.
+ * @tparam KeyEqual Equality function object for Key.
+ */
+template <typename Key, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+class HashIndex {
+    struct Bucket {
+        uint32_t slot; ///< Slot number plus one; zero marks an empty bucket.
+        uint32_t hash; ///< Upper bits of the mixed hash of the key.
+    };
+
+public:
+    HashIndex() = default;
+
+    /// @brief Key, or any type Hash and KeyEqual accept when both are transparent.
+    template <typename K>
+    static constexpr bool accepts = hashedLookupAccepts<Key, K, Hash, KeyEqual>;
+
+    /**
+     * @brief Finds the first slot holding @p key.
+     * @param key The key to search for, a Key or a type accepted by the transparent Hash.
+     * @param data Pointer to the pairs of the table.
+     * @param size Number of pairs in the table.
+     * @return The slot of the element if found; otherwise, @p size.
+     */
+    template <typename K, typename Pair>
+    size_t find(const K& key, const Pair* data, size_t size) const {
+        if (m_count == 0) {
+            return size;
+        }
+        uint32_t h = hashOf(key);
+        size_t mask = m_buckets.size() - 1;
+        for (size_t pos = h & mask;; pos = (pos + 1) & mask) {
+            const Bucket& b = m_buckets[pos];
+            if (b.slot == 0) {
+                return size;
+            }
+            if (b.hash == h && m_equal(data[b.slot - 1].first, key)) {
+                return b.slot - 1;
+            }
+        }
+    }
+
+    /// @brief Records the pair constructed at @p slot, growing the buckets at half load.
+    template <typename Pair>
+    void inserted(const Pair* data, size_t slot) {
+        if ((m_count + 1) * 2 > m_buckets.size()) {
+            grow(m_buckets.empty() ? 8 : m_buckets.size() * 2);
+        }
+        place(hashOf(data[slot].first), static_cast<uint32_t>(slot));
+        ++m_count;
+    }
+
+    /// @brief Forgets the pair at @p slot and renumbers the pairs behind it.
+    template <typename Pair>
+    void erased(const Pair* data, size_t slot, size_t size) {
+        remove(hashOf(data[slot].first), slot);
+        // The table shifts the pairs behind the erased one down by one slot.
+        if (slot + 1 != size) {
+            for (Bucket& b : m_buckets) {
+                if (b.slot > slot + 1) {
+                    --b.slot;
+                }
+            }
+        }
+    }
+
+    /// @brief Forgets the pair at @p slot and points the bucket of the last pair at @p slot.
+    template <typename Pair>
+    void swappedOut(const Pair* data, size_t slot, size_t size) {
+        remove(hashOf(data[slot].first), slot);
+        size_t last = size - 1;
+        if (slot != last) {
+            m_buckets[locate(hashOf(data[last].first), last)].slot = static_cast<uint32_t>(slot + 1);
+        }
+    }
+
+    /// @brief Forgets the pair at @p slot, which is about to be replaced.
+    template <typename Pair>
+    void replacing(const Pair* data, size_t slot) {
+        remove(hashOf(data[slot].first), slot);
+    }
+
+    /// @brief Records the pair that replaced the one at @p slot.
+    template <typename Pair>
+    void replaced(const Pair* data, size_t slot) {
+        place(hashOf(data[slot].first), static_cast<uint32_t>(slot));
+        ++m_count;
+    }
+
+    /// @brief Sizes the buckets so that @p n pairs fit without rehashing.
+    void reserve(size_t n) {
+        size_t want = 8;
+        while (want < n * 2) {
+            want *= 2;
+        }
+        if (want > m_buckets.size()) {
+            grow(want);
+        }
+    }
+
+    /// @brief Empties all buckets, keeping their storage.
+    void clear() noexcept {
+        for (Bucket& b : m_buckets) {
+            b = Bucket{0, 0};
+        }
+        m_count = 0;
+    }
+
+private:
+    template <typename K>
+    uint32_t hashOf(const K& key) const {
+        // Fibonacci mixing so that identity hashes of integers spread too.
+        uint64_t h = static_cast<uint64_t>(m_hash(key)) * 0x9E3779B97F4A7C15ull;
+        return static_cast<uint32_t>(h >> 32);
+    }
+
+    /// Position of the bucket of @p slot, whose key hashes to @p h.
+    size_t locate(uint32_t h, size_t slot) const {
+        size_t mask = m_buckets.size() - 1;
+        size_t pos = h & mask;
+        while (m_buckets[pos].slot != slot + 1) {
+            pos = (pos + 1) & mask;
+        }
+        return pos;
+    }
+
+    void remove(uint32_t h, size_t slot) {
+        size_t mask = m_buckets.size() - 1;
+        // Backward-shift deletion: pull later members of the cluster into
+        // the hole as long as that does not move them before their home.
+        size_t hole = locate(h, slot);
+        for (size_t next = (hole + 1) & mask; m_buckets[next].slot != 0; next = (next + 1) & mask) {
+            size_t home = m_buckets[next].hash & mask;
+            if (((next - home) & mask) >= ((next - hole) & mask)) {
+                m_buckets[hole] = m_buckets[next];
+                hole = next;
+            }
+        }
+        m_buckets[hole] = Bucket{0, 0};
+        --m_count;
+    }
+
+    void place(uint32_t h, uint32_t slot) {
+        size_t mask = m_buckets.size() - 1;
+        size_t pos = h & mask;
+        while (m_buckets[pos].slot != 0) {
+            pos = (pos + 1) & mask;
+        }
+        m_buckets[pos] = Bucket{slot + 1, h};
+    }
+
+    void grow(size_t new_size) {
+        // Both allocations come first, so a failed grow leaves the buckets as they were.
+        std::vector<Bucket> fresh(new_size, Bucket{0, 0});
+        std::vector<Bucket> live;
+        live.reserve(m_count);
+        for (const Bucket& b : m_buckets) {
+            if (b.slot != 0) {
+                live.push_back(b);
+            }
+        }
+        m_buckets.swap(fresh);
+        // Re-place buckets in slot order so equal keys keep their order.
+        std::sort(live.begin(), live.end(),
+                  [](const Bucket& a, const Bucket& b) { return a.slot < b.slot; });
+        for (const Bucket& b : live) {
+            place(b.hash, b.slot - 1);
+        }
+    }
+
+    std::vector<Bucket> m_buckets; ///< Open-addressing table, size is a power of two.
+    size_t m_count = 0;            ///< Number of occupied buckets.
+    [[no_unique_address]] Hash m_hash;
+    [[no_unique_address]] KeyEqual m_equal;
+};
+
+/**
+ * @brief Index policy scanning one byte of hash per pair with SIMD compares.
+ *
+ * Keeps an array of 8-bit fingerprints parallel to the pairs. find() looks for
+ * the fingerprint of the key 16 or 32 slots at a time (see findByte()) and
+ * compares full keys only where the fingerprint matches, about once in 256
+ * slots for a miss. Meant for small tables, where a hash index costs more than
+ * it saves; memory overhead is one byte per pair.
+ *
+ * Duplicate keys are allowed and find() returns the first one, as in LinearIndex.
+ *
+ * @tparam Key Type of the key.
+ * @tparam Hash Hash function object for Key.
+ * @tparam KeyEqual Equality function object for Key.
+ */
+template <typename Key, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+class FingerprintIndex {
+public:
+    /// @brief Key, or any type Hash and KeyEqual accept when both are transparent.
+    template <typename K>
+    static constexpr bool accepts = hashedLookupAccepts<Key, K, Hash, KeyEqual>;
+
+    /**
+     * @brief Finds the first slot holding @p key.
+     * @param key The key to search for, a Key or a type accepted by the transparent Hash.
+     * @param data Pointer to the pairs of the table.
+     * @param size Number of pairs in the table.
+     * @return The slot of the element if found; otherwise, @p size.
+     */
+    template <typename K, typename Pair>
+    size_t find(const K& key, const Pair* data, size_t size) const {
+        uint8_t fp = fingerprintOf(key);
+        const uint8_t* fps = m_fingerprints.data();
+        for (size_t i = findByte(fps, 0, size, fp); i < size; i = findByte(fps, i + 1, size, fp)) {
+            if (m_equal(data[i].first, key)) {
+                return i;
+            }
+        }
+        return size;
+    }
+
+    /// @brief Records the fingerprint of the pair constructed at @p slot.
+    template <typename Pair>
+    void inserted(const Pair* data, size_t slot) {
+        m_fingerprints.insert(m_fingerprints.begin() + static_cast<std::ptrdiff_t>(slot),
+                              fingerprintOf(data[slot].first));
+    }
+
+    /// @brief Drops the fingerprint of the pair at @p slot, shifting the ones behind it.
+    template <typename Pair>
+    void erased(const Pair*, size_t slot, size_t) {
+        m_fingerprints.erase(m_fingerprints.begin() + static_cast<std::ptrdiff_t>(slot));
+    }
+
+    /// @brief Moves the fingerprint of the last pair into @p slot.
+    template <typename Pair>
+    void swappedOut(const Pair*, size_t slot, size_t) {
+        m_fingerprints[slot] = m_fingerprints.back();
+        m_fingerprints.pop_back();
+    }
+
+    /// @brief Nothing to forget: the fingerprint is overwritten by replaced().
+    template <typename Pair>
+    void replacing(const Pair*, size_t) noexcept {}
+
+    /// @brief Records the fingerprint of the pair that replaced the one at @p slot.
+    template <typename Pair>
+    void replaced(const Pair* data, size_t slot) {
+        m_fingerprints[slot] = fingerprintOf(data[slot].first);
+    }
+
+    /// @brief Reserves room for @p n fingerprints.
+    void reserve(size_t n) { m_fingerprints.reserve(n); }
+
+    /// @brief Drops all fingerprints, keeping their storage.
+    void clear() noexcept { m_fingerprints.clear(); }
+
+private:
+    template <typename K>
+    uint8_t fingerprintOf(const K& key) const {
+        uint64_t h = static_cast<uint64_t>(m_hash(key)) * 0x9E3779B97F4A7C15ull;
+        return static_cast<uint8_t>(h >> 56);
+    }
+
+    std::vector<uint8_t> m_fingerprints; ///< Fingerprint of each slot, in slot order.
+    [[no_unique_address]] Hash m_hash;
+    [[no_unique_address]] KeyEqual m_equal;
+};
+
+}
+
+#endif
@@ -5,6 +5,8 @@
 #include <utility>
 #include <type_traits>
 #include <concepts>
+#include <functional>
+#include "indexPolicy.hpp"
 
 namespace mgc{
 /**
@@ -13,11 +15,14 @@ namespace mgc{
  *
  * This file defines a template class LookupTable that stores key-value pairs
  * in a dynamically allocated array (using new/delete). The container is
- * unsorted so that search operations are O(n) via linear iteration.
+ * unsorted; how search operations locate a key is decided by an index policy
+ * (see indexPolicy.hpp): O(n) linear iteration by default, a SIMD scan of key
+ * fingerprints for FingerprintLookupTable, or O(1) expected time through a hash
+ * index for HashedLookupTable.
  * Custom iterators (both mutable and const) are implemented for iteration.
  * The class supports various methods (at, operator[], front, back, data, begin,
  * end, cbegin, cend, empty, size, capacity, reserve, clear, insert, emplace,
- * erase, and find) with Doxygen-style comments.
+ * erase, eraseIf, replace, and find) with Doxygen-style comments.
  */
  
 
@@ -39,18 +44,36 @@ namespace mgc{
          { a == b } -> std::convertible_to<bool>;
      };
  
+ /**
+  * @brief Erase policy keeping the order of the remaining pairs.
+  *
+  * erase() shifts the pairs behind the erased one down by one slot, O(n).
+  */
+ struct OrderedErase {};
+
+ /**
+  * @brief Erase policy moving the last pair into the erased slot.
+  *
+  * erase() runs in O(1) (plus the index update) but changes the position of
+  * the last pair, so insertion order is not kept.
+  */
+ struct UnorderedErase {};
+
  /**
   * @brief LookupTable class template storing key-value pairs.
   *
   * The container uses a dynamically allocated array to store pairs
   * in an unsorted order. Insertion appends new elements, and search
-  * operations run in O(n) time.
+  * operations are delegated to the index policy (O(n) for LinearIndex).
   *
   * @tparam Key Type of the key.
   * @tparam Value Type of the value.
+  * @tparam Index Index policy used by find() and erase by key.
+  * @tparam Erase Erase policy: OrderedErase or UnorderedErase.
   */
- template <typename Key, typename Value>
-     requires LookupTableKeyValueConcept<Key, Value>
+ template <typename Key, typename Value, typename Index = LinearIndex<Key>, typename Erase = OrderedErase>
+     requires LookupTableKeyValueConcept<Key, Value> &&
+              (std::same_as<Erase, OrderedErase> || std::same_as<Erase, UnorderedErase>)
  class LookupTable {
  public:
      using PairType = std::pair<Key, Value>;
@@ -75,7 +98,7 @@ namespace mgc{
       * @param other Another LookupTable to copy from.
       */
      LookupTable(const LookupTable& other)
-         : m_size(other.m_size), m_capacity(other.m_capacity) {
+         : m_size(other.m_size), m_capacity(other.m_capacity), index_(other.index_) {
          if (m_capacity > 0) {
              data_ = reinterpret_cast<PairType*>(operator new(m_capacity * sizeof(PairType)));
              for (size_t i = 0; i < m_size; ++i) {
@@ -105,6 +128,7 @@ namespace mgc{
              for (size_t i = 0; i < m_size; ++i) {
                  new (&data_[i]) PairType(other.data_[i]);
              }
+             index_ = other.index_;
          }
          return *this;
      }
@@ -114,7 +138,9 @@ namespace mgc{
       * @param other Another LookupTable to move from.
       */
      LookupTable(LookupTable&& other) noexcept
-         : m_size(other.m_size), m_capacity(other.m_capacity), data_(other.data_) {
+         : m_size(other.m_size), m_capacity(other.m_capacity), data_(other.data_),
+           index_(std::move(other.index_)) {
+         other.index_.clear();
          other.data_ = nullptr;
          other.m_size = 0;
          other.m_capacity = 0;
@@ -132,6 +158,8 @@ namespace mgc{
              data_ = other.data_;
              m_size = other.m_size;
              m_capacity = other.m_capacity;
+             index_ = std::move(other.index_);
+             other.index_.clear();
              other.data_ = nullptr;
              other.m_size = 0;
              other.m_capacity = 0;
@@ -290,6 +318,7 @@ namespace mgc{
              operator delete(data_);
              data_ = new_data;
              m_capacity = new_cap;
+             index_.reserve(new_cap);
          }
      }
  
@@ -303,6 +332,7 @@ namespace mgc{
              data_[i].~PairType();
          }
          m_size = 0;
+         index_.clear();
      }
  
      /**
@@ -318,6 +348,13 @@ namespace mgc{
              reserve(m_capacity == 0 ? 1 : m_capacity * 2);
          }
          new (&data_[m_size]) PairType(key, value);
+         try {
+             index_.inserted(data_, m_size);
+         } catch (...) {
+             // The index may fail to grow; the pair is not part of the table yet.
+             data_[m_size].~PairType();
+             throw;
+         }
          ++m_size;
      }
  
@@ -335,13 +372,21 @@ namespace mgc{
              reserve(m_capacity == 0 ? 1 : m_capacity * 2);
          }
          new (&data_[m_size]) PairType(std::forward<Args>(args)...);
+         try {
+             index_.inserted(data_, m_size);
+         } catch (...) {
+             // The index may fail to grow; the pair is not part of the table yet.
+             data_[m_size].~PairType();
+             throw;
+         }
          ++m_size;
      }
  
      /**
       * @brief Erases the element at the specified index.
       *
-      * The elements following the erased element are shifted to fill the gap.
+      * With OrderedErase the elements following the erased element are shifted
+      * to fill the gap; with UnorderedErase the last element is moved into it.
       *
       * @param index Position of the element to erase.
       * @throws std::out_of_range if index is out of bounds.
@@ -350,30 +395,76 @@ namespace mgc{
          if (index >= m_size) {
              throw std::out_of_range("Index out of range in LookupTable::erase");
          }
-         data_[index].~PairType();
-         // Shift remaining elements to fill the gap.
-         for (size_t i = index; i < m_size - 1; ++i) {
-             new (&data_[i]) PairType(std::move(data_[i + 1]));
-             data_[i + 1].~PairType();
+         if constexpr (std::is_same_v<Erase, UnorderedErase>) {
+             size_t last = m_size - 1;
+             index_.swappedOut(data_, index, m_size);
+             data_[index].~PairType();
+             if (index != last) {
+                 new (&data_[index]) PairType(std::move(data_[last]));
+                 data_[last].~PairType();
+             }
+         } else {
+             index_.erased(data_, index, m_size);
+             data_[index].~PairType();
+             // Shift remaining elements to fill the gap.
+             for (size_t i = index; i < m_size - 1; ++i) {
+                 new (&data_[i]) PairType(std::move(data_[i + 1]));
+                 data_[i + 1].~PairType();
+             }
          }
          --m_size;
      }
+
+     /**
+      * @brief Replaces the element at the specified index in place.
+      *
+      * The new pair takes the slot of the old one, so no other element moves.
+      * The caller is responsible for not creating an unwanted duplicate key.
+      *
+      * @param index Position of the element to replace.
+      * @param key The key of the new element.
+      * @param value The value of the new element.
+      * @throws std::out_of_range if index is out of bounds.
+      */
+     void replace(size_t index, const Key& key, const Value& value) {
+         if (index >= m_size) {
+             throw std::out_of_range("Index out of range in LookupTable::replace");
+         }
+         PairType fresh(key, value);
+         index_.replacing(data_, index);
+         data_[index].~PairType();
+         new (&data_[index]) PairType(std::move(fresh));
+         index_.replaced(data_, index);
+     }
  
      /**
       * @brief Finds the index of the element with the specified key.
       *
-      * Performs a linear search (O(n)) over the elements.
+      * Delegates to the index policy: a linear search (O(n)) for LinearIndex,
+      * a hash probe (O(1) expected) for HashIndex.
       *
       * @param key The key to search for.
       * @return The index of the element if found; otherwise, returns size().
       */
      size_t find(const Key& key) const {
-         for (size_t i = 0; i < m_size; ++i) {
-             if (data_[i].first == key) {
-                 return i;
-             }
-         }
-         return m_size; // Not found
+         return index_.find(key, data_, m_size);
+     }
+
+     /**
+      * @brief Finds the index of the element whose key equals @p key, without converting it to Key.
+      *
+      * Available when the index policy accepts K (see indexPolicy.hpp): always
+      * for LinearIndex if Key compares with K, and for the hashing policies if
+      * their Hash and KeyEqual are transparent, e.g. StringHash and std::equal_to<>.
+      *
+      * @tparam K Type of the searched key, e.g. std::string_view for std::string keys.
+      * @param key The key to search for.
+      * @return The index of the element if found; otherwise, returns size().
+      */
+     template <typename K>
+         requires(!std::same_as<K, Key> && Index::template accepts<K>)
+     size_t find(const K& key) const {
+         return index_.find(key, data_, m_size);
      }
  
      /**
@@ -390,6 +481,61 @@ namespace mgc{
          }
          return false;
      }
+
+     /**
+      * @brief Erases the element whose key equals @p key, without converting it to Key.
+      *
+      * @tparam K Type of the key, accepted by the index policy as in find().
+      * @param key The key of the element to erase.
+      * @return true if an element was erased, false otherwise.
+      */
+     template <typename K>
+         requires(!std::same_as<K, Key> && Index::template accepts<K>)
+     bool erase(const K& key) {
+         size_t index = find(key);
+         if (index != m_size) {
+             erase(index);
+             return true;
+         }
+         return false;
+     }
+ 
+     /**
+      * @brief Erases every element matching a predicate in one pass.
+      *
+      * The remaining elements keep their order and the index is rebuilt once,
+      * so erasing k elements costs O(n) rather than k shifting erases.
+      *
+      * @tparam Pred Callable taking const PairType& and returning bool; must not throw.
+      * @param pred The predicate selecting the elements to erase.
+      * @return The number of elements erased.
+      */
+     template <typename Pred>
+     size_t eraseIf(Pred pred) {
+         size_t kept = 0;
+         for (size_t i = 0; i < m_size; ++i) {
+             if (pred(std::as_const(data_[i]))) {
+                 continue;
+             }
+             if (kept != i) {
+                 data_[kept] = std::move(data_[i]);
+             }
+             ++kept;
+         }
+         size_t erased = m_size - kept;
+         if (erased == 0) {
+             return 0;
+         }
+         for (size_t i = kept; i < m_size; ++i) {
+             data_[i].~PairType();
+         }
+         m_size = kept;
+         index_.clear();
+         for (size_t i = 0; i < m_size; ++i) {
+             index_.inserted(data_, i);
+         }
+         return erased;
+     }
  
      ////////////////////////////////////////////////////////////////////////////////
      // Iterator implementations
@@ -587,7 +733,54 @@ namespace mgc{
      PairType* data_;    ///< Pointer to dynamically allocated storage.
      size_t m_size;      ///< Current number of elements.
      size_t m_capacity;  ///< Current capacity of the container.
+     Index index_;       ///< Index policy answering key lookups.
  };
+
+ /**
+  * @brief LookupTable answering find() and erase by key in O(1) expected time.
+  *
+  * Keeps the insertion-ordered contiguous storage and iterator API of
+  * LookupTable and adds an open-addressing hash index of slots.
+  *
+  * @tparam Key Type of the key.
+  * @tparam Value Type of the value.
+  * @tparam Hash Hash function object for Key.
+  * @tparam KeyEqual Equality function object for Key; with a transparent Hash
+  *         such as StringHash, std::equal_to<> enables find() by std::string_view.
+  */
+ template <typename Key, typename Value, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+ using HashedLookupTable = LookupTable<Key, Value, HashIndex<Key, Hash, KeyEqual>>;
+
+ /**
+  * @brief HashedLookupTable whose erase() moves the last pair into the hole.
+  *
+  * Erasing by key or slot is O(1) expected time, at the price of insertion
+  * order. For collections whose order carries no meaning.
+  *
+  * @tparam Key Type of the key.
+  * @tparam Value Type of the value.
+  * @tparam Hash Hash function object for Key.
+  * @tparam KeyEqual Equality function object for Key; with a transparent Hash
+  *         such as StringHash, std::equal_to<> enables find() by std::string_view.
+  */
+ template <typename Key, typename Value, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+ using UnorderedHashedLookupTable = LookupTable<Key, Value, HashIndex<Key, Hash, KeyEqual>, UnorderedErase>;
+
+ /**
+  * @brief LookupTable scanning key fingerprints with SIMD compares in find().
+  *
+  * Still O(n), but each step checks 16 or 32 one-byte fingerprints and full
+  * keys are compared only on a fingerprint match. Suited to tables of a few
+  * dozen keys, where hashing into a bucket array does not pay off.
+  *
+  * @tparam Key Type of the key.
+  * @tparam Value Type of the value.
+  * @tparam Hash Hash function object for Key.
+  * @tparam KeyEqual Equality function object for Key; with a transparent Hash
+  *         such as StringHash, std::equal_to<> enables find() by std::string_view.
+  */
+ template <typename Key, typename Value, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+ using FingerprintLookupTable = LookupTable<Key, Value, FingerprintIndex<Key, Hash, KeyEqual>>;
  
 }
 
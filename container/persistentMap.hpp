@@ -0,0 +1,160 @@
+#ifndef PERSISTENT_MAP_HPP_
+#define PERSISTENT_MAP_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include "cowPtr.hpp"
+
+namespace mgc {
+/**
+ * @file persistentMap.hpp
+ * @brief Hash map whose copies share everything but the shards they edit.
+ */
+
+/**
+ * @brief Hash map split into copy-on-write shards, for O(1) copies.
+ *
+ * Keys are spread over 2^ShardBits std::unordered_map shards by their hash.
+ * A copy of the map shares the array of shards and every shard; the first edit
+ * of a copy duplicates the array of shard handles, and the first edit of each
+ * shard duplicates that shard alone. A copy followed by a few edits thus costs
+ * a few shards, about size() / 2^ShardBits entries each, rather than the whole
+ * map.
+ *
+ * Lookups and edits that find nothing to change do not copy anything.
+ *
+ * @tparam Key Type of the key.
+ * @tparam Value Type of the mapped value; default and copy constructible.
+ * @tparam Hash Hash function object for Key.
+ * @tparam ShardBits Base-2 logarithm of the number of shards.
+ */
+template <typename Key, typename Value, typename Hash = std::hash<Key>, unsigned ShardBits = 8>
+class PersistentMap {
+    static_assert(ShardBits > 0 && ShardBits < 16, "PersistentMap needs 2 to 2^15 shards");
+
+public:
+    /// Type of one shard.
+    using Shard = std::unordered_map<Key, Value, Hash>;
+    /// Number of shards.
+    static constexpr size_t ShardCount = size_t{1} << ShardBits;
+
+    /**
+     * @brief Gets the number of entries.
+     * @return The entry count.
+     */
+    size_t size() const noexcept { return m_root->count; }
+
+    /**
+     * @brief Checks whether the map has no entries.
+     * @return true if size() is 0.
+     */
+    bool empty() const noexcept { return size() == 0; }
+
+    /**
+     * @brief Finds the value of a key.
+     * @param key The key.
+     * @return Pointer to the value, or nullptr if the key is absent.
+     */
+    const Value* find(const Key& key) const {
+        const Shard& shard = *m_root->shards[shardOf(key)];
+        auto it = shard.find(key);
+        return it == shard.end() ? nullptr : &it->second;
+    }
+
+    /**
+     * @brief Finds the value of a key for editing, copying its shard if it is shared.
+     * @param key The key.
+     * @return Pointer to the value, or nullptr if the key is absent; nothing is copied then.
+     */
+    Value* findForEdit(const Key& key) {
+        size_t index = shardOf(key);
+        if (!m_root->shards[index]->contains(key)) {
+            return nullptr;
+        }
+        return &m_root.edit().shards[index].edit().find(key)->second;
+    }
+
+    /**
+     * @brief Gets the value of a key for editing, inserting a default-constructed one if absent.
+     * @param key The key.
+     * @return The value.
+     */
+    Value& edit(const Key& key) {
+        Root& root = m_root.edit();
+        auto [it, inserted] = root.shards[shardOf(key)].edit().try_emplace(key);
+        root.count += inserted;
+        return it->second;
+    }
+
+    /**
+     * @brief Erases the entry of a key.
+     * @param key The key.
+     * @return true if an entry was erased; nothing is copied otherwise.
+     */
+    bool erase(const Key& key) {
+        size_t index = shardOf(key);
+        if (!m_root->shards[index]->contains(key)) {
+            return false;
+        }
+        Root& root = m_root.edit();
+        root.shards[index].edit().erase(key);
+        --root.count;
+        return true;
+    }
+
+    /**
+     * @brief Reserves room for entries about to be inserted.
+     *
+     * Only shards this map owns alone are sized up, so reserving never copies a shard.
+     *
+     * @param count Number of entries the map should hold.
+     */
+    void reserve(size_t count) {
+        size_t perShard = count / ShardCount + 1;
+        Root& root = m_root.edit();
+        for (auto& shard : root.shards) {
+            if (!shard.shared()) {
+                shard.edit().reserve(perShard);
+            }
+        }
+    }
+
+    /**
+     * @brief Removes all entries, leaving the copies of the map as they are.
+     */
+    void clear() noexcept { m_root = CowPtr<Root>(); }
+
+    /**
+     * @brief Calls @p visit with every key and value, shard by shard.
+     * @param visit Callable taking (const Key&, const Value&).
+     */
+    template <typename Visit>
+    void forEach(Visit visit) const {
+        for (const auto& shard : m_root->shards) {
+            for (const auto& [key, value] : *shard) {
+                visit(key, value);
+            }
+        }
+    }
+
+private:
+    struct Root {
+        std::array<CowPtr<Shard>, ShardCount> shards;
+        size_t count = 0;
+    };
+
+    static size_t shardOf(const Key& key) {
+        // Top bits of a Fibonacci-mixed hash, independent of the bucket the shard picks.
+        uint64_t h = static_cast<uint64_t>(Hash{}(key)) * 0x9E3779B97F4A7C15ull;
+        return static_cast<size_t>(h >> (64 - ShardBits));
+    }
+
+    CowPtr<Root> m_root;
+};
+
+}
+
+#endif
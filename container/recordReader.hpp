@@ -0,0 +1,118 @@
+#ifndef RECORD_READER_HPP_
+#define RECORD_READER_HPP_
+
+#include <array>
+#include <cstring>
+#include <istream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace mgc {
+/**
+ * @file recordReader.hpp
+ * @brief Line-oriented reading of text records with whitespace-separated fields.
+ */
+
+/**
+ * @brief Reads a stream one record per line through a fixed-size chunk buffer.
+ *
+ * Records are handed out as views into the chunk, without a trailing '\r'; only
+ * a record split across two chunks is copied, into a carry buffer kept between
+ * calls. A last record without a newline is handed out too.
+ */
+class RecordReader {
+public:
+    /// Size of the read buffer.
+    static constexpr size_t ChunkSize = 1 << 16;
+
+    /**
+     * @brief Calls @p handle with every record of a stream, in order.
+     * @param in The stream.
+     * @param handle Callable taking std::string_view, valid during the call, and
+     *        returning false to stop reading.
+     */
+    template <typename Handle>
+    void read(std::istream& in, Handle handle) {
+        m_carry.clear();
+        m_chunk.resize(ChunkSize);
+        bool going = true;
+        auto emit = [&](std::string_view record) {
+            if (!record.empty() && record.back() == '\r') {
+                record.remove_suffix(1);
+            }
+            going = handle(record);
+        };
+        while (going && (in.read(m_chunk.data(), static_cast<std::streamsize>(m_chunk.size())) || in.gcount() > 0)) {
+            const char* data = m_chunk.data();
+            size_t size = static_cast<size_t>(in.gcount());
+            size_t pos = 0;
+            while (pos < size && going) {
+                const void* nl = std::memchr(data + pos, '\n', size - pos);
+                if (!nl) {
+                    m_carry.append(data + pos, size - pos);
+                    break;
+                }
+                size_t end = static_cast<const char*>(nl) - data;
+                if (m_carry.empty()) {
+                    emit(std::string_view(data + pos, end - pos));
+                } else {
+                    m_carry.append(data + pos, end - pos);
+                    emit(m_carry);
+                    m_carry.clear();
+                }
+                pos = end + 1;
+            }
+        }
+        if (going && !m_carry.empty()) {
+            emit(m_carry);
+        }
+        m_carry.clear();
+    }
+
+private:
+    std::vector<char> m_chunk; ///< Read buffer.
+    std::string m_carry;       ///< Record split across two chunks.
+};
+
+/**
+ * @brief Splits a record on spaces and tabs.
+ * @param record The record.
+ * @param fields Receives the first N fields; the rest of the record is ignored.
+ * @return The number of fields found, at most N.
+ */
+template <size_t N>
+size_t splitFields(std::string_view record, std::array<std::string_view, N>& fields) {
+    size_t count = 0, i = 0;
+    while (i < record.size() && count < N) {
+        while (i < record.size() && (record[i] == ' ' || record[i] == '\t')) {
+            ++i;
+        }
+        if (i == record.size()) {
+            break;
+        }
+        size_t start = i;
+        while (i < record.size() && record[i] != ' ' && record[i] != '\t') {
+            ++i;
+        }
+        fields[count++] = record.substr(start, i - start);
+    }
+    return count;
+}
+
+/**
+ * @brief Strips the "Error: " prefix of exception messages, for messages that get their own prefix.
+ * @param message The message.
+ * @return The message without the prefix.
+ */
+inline std::string_view withoutErrorPrefix(std::string_view message) {
+    constexpr std::string_view prefix = "Error: ";
+    if (message.starts_with(prefix)) {
+        message.remove_prefix(prefix.size());
+    }
+    return message;
+}
+
+}
+
+#endif
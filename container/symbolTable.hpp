@@ -0,0 +1,264 @@
+#ifndef SYMBOL_TABLE_HPP_
+#define SYMBOL_TABLE_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace mgc {
+/**
+ * @file symbolTable.hpp
+ * @brief Process-wide string interning: SymbolTable and its 32-bit Symbol handles.
+ *
+ * Every distinct string is stored once; a Symbol is the index of that copy.
+ * Comparing and hashing Symbols is an integer operation, and resolving a Symbol
+ * to its text is an array access. Interned strings live until the end of the program.
+ */
+
+/**
+ * @brief Append-only table of interned strings.
+ *
+ * Strings are kept in fixed-size chunks that never move, so references returned
+ * by str() stay valid while other threads intern new strings. The text -> ID index
+ * is an open-addressing table whose buckets are published atomically; when it grows,
+ * the old bucket array is retired rather than freed. Resolving an ID and looking up
+ * a string therefore never take a lock; only interning a new string does.
+ */
+class SymbolTable {
+public:
+    /**
+     * @brief Gets the process-wide table.
+     * @return The table used by Symbol.
+     */
+    static SymbolTable &instance() {
+        static SymbolTable table;
+        return table;
+    }
+
+    /**
+     * @brief Interns a string.
+     * @param text The string to intern.
+     * @return The ID of the stored copy; equal strings get equal IDs.
+     * @throws std::length_error if the table is full.
+     */
+    uint32_t intern(std::string_view text) {
+        uint32_t h = hashOf(text);
+        if (uint32_t found = probe(text, h))
+            return found - 1;
+        std::lock_guard lock(mutex);
+        if (uint32_t found = probe(text, h))
+            return found - 1;
+        uint32_t id = m_size.load(std::memory_order_relaxed);
+        if ((id >> ChunkBits) >= MaxChunks)
+            throw std::length_error("SymbolTable is full");
+        std::string *chunk = chunks[id >> ChunkBits].load(std::memory_order_relaxed);
+        if (!chunk) {
+            owned[id >> ChunkBits] = std::make_unique<std::string[]>(ChunkSize);
+            chunk = owned[id >> ChunkBits].get();
+            chunks[id >> ChunkBits].store(chunk, std::memory_order_release);
+        }
+        chunk[id & ChunkMask].assign(text);
+        const BucketArray *current = buckets.load(std::memory_order_relaxed);
+        if (!current || (size_t{id} + 1) * 2 > current->mask + 1)
+            current = grow(current ? (current->mask + 1) * 2 : 1024);
+        place(*current, pack(id + 1, h), std::memory_order_release);
+        m_size.store(id + 1, std::memory_order_release);
+        return id;
+    }
+
+    /**
+     * @brief Looks up a string without interning it.
+     * @param text The string to look up.
+     * @return Its ID, or std::nullopt if it was never interned.
+     */
+    std::optional<uint32_t> lookup(std::string_view text) const noexcept {
+        if (uint32_t found = probe(text, hashOf(text)))
+            return found - 1;
+        return std::nullopt;
+    }
+
+    /**
+     * @brief Gets the text of an interned string.
+     * @param id An ID returned by intern().
+     * @return A reference to the stored string, valid for the rest of the program.
+     */
+    const std::string &str(uint32_t id) const noexcept {
+        return chunks[id >> ChunkBits].load(std::memory_order_acquire)[id & ChunkMask];
+    }
+
+    /**
+     * @brief Gets the number of interned strings.
+     * @return The string count.
+     */
+    size_t size() const noexcept { return m_size.load(std::memory_order_acquire); }
+
+private:
+    static constexpr unsigned ChunkBits = 12;
+    static constexpr size_t ChunkSize = size_t{1} << ChunkBits;
+    static constexpr size_t ChunkMask = ChunkSize - 1;
+    static constexpr size_t MaxChunks = size_t{1} << 14; ///< Room for 64M strings.
+
+    /// Buckets hold the ID plus one in the low half (zero when empty) and the hash in the high half.
+    struct BucketArray {
+        explicit BucketArray(size_t size) : mask(size - 1), slots(new std::atomic<uint64_t>[size]) {
+            for (size_t i = 0; i < size; ++i)
+                slots[i].store(0, std::memory_order_relaxed);
+        }
+        size_t mask;
+        std::unique_ptr<std::atomic<uint64_t>[]> slots;
+    };
+
+    SymbolTable() { intern(""); }
+
+    static uint64_t pack(uint32_t idPlusOne, uint32_t h) noexcept {
+        return (static_cast<uint64_t>(h) << 32) | idPlusOne;
+    }
+
+    static uint32_t hashOf(std::string_view text) noexcept {
+        uint64_t h = static_cast<uint64_t>(std::hash<std::string_view>{}(text)) * 0x9E3779B97F4A7C15ull;
+        return static_cast<uint32_t>(h >> 32);
+    }
+
+    /// Returns the ID plus one of @p text, or zero.
+    uint32_t probe(std::string_view text, uint32_t h) const noexcept {
+        const BucketArray *current = buckets.load(std::memory_order_acquire);
+        if (!current)
+            return 0;
+        for (size_t pos = h & current->mask;; pos = (pos + 1) & current->mask) {
+            uint64_t b = current->slots[pos].load(std::memory_order_acquire);
+            if (b == 0)
+                return 0;
+            uint32_t idPlusOne = static_cast<uint32_t>(b);
+            if (static_cast<uint32_t>(b >> 32) == h && str(idPlusOne - 1) == text)
+                return idPlusOne;
+        }
+    }
+
+    static void place(const BucketArray &array, uint64_t bucket, std::memory_order order) noexcept {
+        size_t pos = static_cast<uint32_t>(bucket >> 32) & array.mask;
+        while (array.slots[pos].load(std::memory_order_relaxed) != 0)
+            pos = (pos + 1) & array.mask;
+        array.slots[pos].store(bucket, order);
+    }
+
+    /// Copies the buckets into a larger array and publishes it. Needs the lock.
+    const BucketArray *grow(size_t newSize) {
+        auto next = std::make_unique<BucketArray>(newSize);
+        if (const BucketArray *current = buckets.load(std::memory_order_relaxed)) {
+            for (size_t i = 0; i <= current->mask; ++i) {
+                uint64_t b = current->slots[i].load(std::memory_order_relaxed);
+                if (b != 0)
+                    place(*next, b, std::memory_order_relaxed);
+            }
+        }
+        const BucketArray *published = next.get();
+        arrays.push_back(std::move(next));
+        buckets.store(published, std::memory_order_release);
+        return published;
+    }
+
+    std::array<std::atomic<std::string *>, MaxChunks> chunks{};  ///< Published chunk pointers.
+    std::array<std::unique_ptr<std::string[]>, MaxChunks> owned; ///< Owners of the chunks.
+    std::atomic<const BucketArray *> buckets{nullptr};           ///< Current text -> ID index.
+    std::vector<std::unique_ptr<BucketArray>> arrays;            ///< Current and retired indexes.
+    std::atomic<uint32_t> m_size{0};                             ///< Number of interned strings.
+    std::mutex mutex;                                            ///< Serialises interning.
+};
+
+/**
+ * @brief Handle of a string interned in the process-wide SymbolTable.
+ *
+ * Four bytes, compared and hashed as an integer. A default-constructed Symbol
+ * is the empty string. Symbols convert implicitly to the interned string.
+ */
+class Symbol {
+public:
+    /**
+     * @brief Constructs the symbol of the empty string.
+     */
+    constexpr Symbol() noexcept : m_id(0) {}
+
+    /**
+     * @brief Interns a string.
+     * @param text The string to intern.
+     */
+    explicit Symbol(std::string_view text) : m_id(SymbolTable::instance().intern(text)) {}
+
+    /**
+     * @brief Finds the symbol of a string without interning it.
+     *
+     * A string that was never interned cannot be the key of anything, so callers
+     * can answer "not found" without touching their own containers.
+     *
+     * @param text The string to look up.
+     * @return The symbol, or std::nullopt if the string was never interned.
+     */
+    static std::optional<Symbol> find(std::string_view text) noexcept {
+        auto id = SymbolTable::instance().lookup(text);
+        if (!id)
+            return std::nullopt;
+        return fromId(*id);
+    }
+
+    /**
+     * @brief Reconstructs a symbol from its ID.
+     * @param id An ID obtained from id().
+     * @return The symbol.
+     */
+    static constexpr Symbol fromId(uint32_t id) noexcept {
+        Symbol s;
+        s.m_id = id;
+        return s;
+    }
+
+    /**
+     * @brief Gets the ID of the symbol.
+     * @return The index of the string in the SymbolTable.
+     */
+    constexpr uint32_t id() const noexcept { return m_id; }
+
+    /**
+     * @brief Gets the interned string.
+     * @return A reference valid for the rest of the program.
+     */
+    const std::string &str() const noexcept { return SymbolTable::instance().str(m_id); }
+
+    /**
+     * @brief Converts to the interned string.
+     */
+    operator const std::string &() const noexcept { return str(); }
+
+    /**
+     * @brief Converts to a view of the interned string, for APIs taking std::string_view.
+     */
+    operator std::string_view() const noexcept { return str(); }
+
+    constexpr bool operator==(const Symbol &other) const noexcept = default;
+
+    /**
+     * @brief Compares the interned string with a string.
+     * @param text The string to compare with.
+     * @return true if the texts are equal.
+     */
+    bool operator==(std::string_view text) const noexcept { return str() == text; }
+
+private:
+    uint32_t m_id;
+};
+
+}
+
+template <>
+struct std::hash<mgc::Symbol> {
+    size_t operator()(mgc::Symbol s) const noexcept { return s.id(); }
+};
+
+#endif
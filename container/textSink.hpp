@@ -0,0 +1,199 @@
+#ifndef TEXT_SINK_HPP_
+#define TEXT_SINK_HPP_
+
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+
+namespace mgc {
+/**
+ * @file textSink.hpp
+ * @brief Destination for generated text: a string, an output stream or a file descriptor.
+ */
+
+/**
+ * @brief Appends text to a caller-supplied string, stream or file descriptor.
+ *
+ * Writers produce their output piece by piece through append() and put() without
+ * building temporaries. A string is appended to in place, so a caller that reuses one
+ * keeps its capacity from call to call. Streams and descriptors are fed from a fixed
+ * buffer inside the sink, which is passed on when full, by flush() and on destruction;
+ * errors while the destructor passes on the rest are lost, so call flush() to see them.
+ */
+class TextSink {
+public:
+    /// Size of the buffer in front of a stream or descriptor.
+    static constexpr size_t ChunkSize = 16 * 1024;
+
+    /**
+     * @brief Appends to a string.
+     * @param buffer The string; its current contents are kept.
+     */
+    explicit TextSink(std::string &buffer) noexcept : text(&buffer) {}
+
+    /**
+     * @brief Writes to an output stream.
+     * @param stream The stream.
+     */
+    explicit TextSink(std::ostream &stream) noexcept : stream(&stream) {}
+
+    /**
+     * @brief Writes to a file descriptor with write(2).
+     * @param fd The descriptor, which stays open.
+     */
+    explicit TextSink(int fd) noexcept : fd(fd) {}
+
+    TextSink(const TextSink &) = delete;
+    TextSink &operator=(const TextSink &) = delete;
+
+    ~TextSink() {
+        try {
+            drain();
+        } catch (...) {
+        }
+    }
+
+    /**
+     * @brief Announces how many bytes are about to be written.
+     *
+     * A string grows to hold them at once; other destinations ignore the hint.
+     *
+     * @param bytes The expected number of bytes.
+     */
+    void reserve(size_t bytes) {
+        if (text)
+            text->reserve(text->size() + bytes);
+    }
+
+    /**
+     * @brief Tells whether the sink appends to a string, the only destination reserve() affects.
+     * @return True for a string sink.
+     */
+    bool appendsToString() const noexcept { return text != nullptr; }
+
+    /**
+     * @brief Appends text.
+     * @param piece The text.
+     */
+    void append(std::string_view piece) {
+        total += piece.size();
+        if (text) {
+            text->append(piece);
+            return;
+        }
+        if (piece.size() > ChunkSize - used) {
+            drain();
+            if (piece.size() >= ChunkSize) {
+                emit(piece.data(), piece.size());
+                return;
+            }
+        }
+        std::memcpy(chunk.data() + used, piece.data(), piece.size());
+        used += piece.size();
+    }
+
+    /**
+     * @brief Appends one character.
+     * @param c The character.
+     */
+    void put(char c) {
+        ++total;
+        if (text) {
+            text->push_back(c);
+            return;
+        }
+        if (used == ChunkSize)
+            drain();
+        chunk[used++] = c;
+    }
+
+    /**
+     * @brief Passes buffered text on to the stream or descriptor, and flushes the stream.
+     * @throws std::invalid_argument If the descriptor cannot be written.
+     */
+    void flush() {
+        drain();
+        if (stream)
+            stream->flush();
+    }
+
+    /**
+     * @brief Gets the number of bytes appended through this sink.
+     * @return The byte count, buffered bytes included.
+     */
+    size_t written() const noexcept { return total; }
+
+private:
+    void drain() {
+        size_t pending = used;
+        used = 0;
+        if (pending)
+            emit(chunk.data(), pending);
+    }
+
+    void emit(const char *data, size_t size) {
+        if (stream) {
+            stream->write(data, static_cast<std::streamsize>(size));
+            return;
+        }
+        while (size > 0) {
+            ssize_t n = ::write(fd, data, size);
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                throw std::invalid_argument(std::string("Error: Cannot write output: ") + std::strerror(errno) + ".");
+            }
+            data += n;
+            size -= static_cast<size_t>(n);
+        }
+    }
+
+    std::string *text = nullptr;
+    std::ostream *stream = nullptr;
+    int fd = -1;
+    size_t used = 0;  ///< Bytes waiting in chunk.
+    size_t total = 0;
+    std::array<char, ChunkSize> chunk; ///< Unused for a string.
+};
+
+/**
+ * @brief Formats an unsigned number in decimal without allocating.
+ * @param digits Buffer the digits are written to.
+ * @param value The number.
+ * @return The digits, viewing @p digits.
+ */
+inline std::string_view formatNumber(std::array<char, 20>& digits, uint64_t value) noexcept {
+    auto end = std::to_chars(digits.data(), digits.data() + digits.size(), value).ptr;
+    return std::string_view(digits.data(), static_cast<size_t>(end - digits.data()));
+}
+
+/**
+ * @brief Appends an unsigned number in decimal.
+ * @param out The destination.
+ * @param value The number.
+ */
+inline void appendNumber(TextSink& out, uint64_t value) {
+    std::array<char, 20> digits;
+    out.append(formatNumber(digits, value));
+}
+
+/**
+ * @brief Appends an unsigned number in decimal.
+ * @param out The destination.
+ * @param value The number.
+ */
+inline void appendNumber(std::string& out, uint64_t value) {
+    std::array<char, 20> digits;
+    out.append(formatNumber(digits, value));
+}
+
+} // namespace mgc
+
+#endif
@@ -4,38 +4,38 @@
 
 namespace mgm {
 
-void transfer_hub::add_station(string name_of_station, string name_of_line){
-    if(station_name_line.size() >= 3)
+void transfer_hub::add_station(std::string_view name_of_station, std::string_view name_of_line){
+    if(station_name_line.size() >= capacity)
         throw std::invalid_argument("Error: The capacity of the transfer_hub cannot exceed 3.");
-    station_name_line.emplace_back(std::make_pair(name_of_station, name_of_line));
+    station_name_line.emplace_back(mgc::Symbol(name_of_station), mgc::Symbol(name_of_line));
 }
 
 string transfer_hub::get_station_names()const{
     string result;
     std::for_each(station_name_line.begin(), station_name_line.end(), 
-        [&result](auto &i){result += i.first + '\n';});
+        [&result](auto &i){result += i.first.str() + '\n';});
     return result;
 }
 
 string transfer_hub::get_lines_names()const{
     string result;
     std::for_each(station_name_line.begin(), station_name_line.end(), 
-        [&result](auto &i){result += i.second + '\n';});
+        [&result](auto &i){result += i.second.str() + '\n';});
     return result;        
 }
 
 string transfer_hub::get_stations_lines_names()const{
     string result;
     std::for_each(station_name_line.begin(), station_name_line.end(), 
-        [&result](auto &i){result += i.first + '-' + i.second + '\n';});
+        [&result](auto &i){result += i.first.str() + '-' + i.second.str() + '\n';});
     return result;        
 }
 
-const std::list<std::pair<string, string>>& transfer_hub::get_station_list()const{
+const std::list<transfer_hub::connection>& transfer_hub::get_station_list()const{
     return station_name_line;
 }
 
-std::list<std::pair<string, string>>& transfer_hub::get_station_list(){
+std::list<transfer_hub::connection>& transfer_hub::get_station_list(){
     return station_name_line;
 };
 
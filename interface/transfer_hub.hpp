@@ -3,7 +3,9 @@
 
 #include <list>
 #include <string>
+#include <string_view>
 #include <utility>
+#include "../container/symbolTable.hpp"
 using std::string;
 
 namespace mgm {
@@ -16,7 +18,17 @@ namespace mgm {
  * lists of station names, line names, and combined station-line information.
  */
 class transfer_hub {
-    std::list<std::pair<string, string>> station_name_line; ///< List of pairs (station name, line name)
+public:
+    /**
+     * @brief A connection: the interned station name and line name.
+     */
+    using connection = std::pair<mgc::Symbol, mgc::Symbol>;
+
+    /// Maximum number of connections of one hub.
+    static constexpr size_t capacity = 3;
+
+private:
+    std::list<connection> station_name_line; ///< List of pairs (station name, line name)
 public:
     /**
      * @brief Default constructor.
@@ -29,7 +41,7 @@ public:
      * @param name_of_station The name of the station.
      * @param name_of_line The name of the line.
      */
-    void add_station(string name_of_station, string name_of_line);
+    void add_station(std::string_view name_of_station, std::string_view name_of_line);
 
     /**
      * @brief Retrieves the station names.
@@ -43,14 +55,14 @@ public:
      *
      * @return A constant reference to the internal list of station-line pairs.
      */
-    const std::list<std::pair<string, string>>& get_station_list() const;
+    const std::list<connection>& get_station_list() const;
 
     /**
      * @brief Retrieves a modifiable reference to the list of station-line pairs.
      *
      * @return A reference to the internal list of station-line pairs.
      */
-    std::list<std::pair<string, string>>& get_station_list();
+    std::list<connection>& get_station_list();
 
     /**
      * @brief Retrieves the line names.
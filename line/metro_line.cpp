@@ -1,30 +1,173 @@
 #include "metro_line.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstring>
 #include <stdexcept>
 
 namespace mgm {
 
-shared_ptr<station> Line::find(const string &name) const {
-    size_t index = stations_table.find(name);
-    if (index == stations_table.size())
+void Line::appendColumns(Stations &s, const station &st) {
+    s.nameColumn.push_back(st.getNameSymbol());
+    try {
+        s.typeColumn.push_back(st.getTypeSymbol());
+        s.kindColumn.push_back(st.getKind());
+    } catch (...) {
+        s.nameColumn.resize(s.kindColumn.size());
+        s.typeColumn.resize(s.kindColumn.size());
+        throw;
+    }
+}
+
+void Line::eraseColumns(Stations &s, size_t slot) noexcept {
+    s.nameColumn.erase(s.nameColumn.begin() + slot);
+    s.typeColumn.erase(s.typeColumn.begin() + slot);
+    s.kindColumn.erase(s.kindColumn.begin() + slot);
+}
+
+void Line::reserve(size_t count) {
+    Stations &s = stations.edit();
+    s.table.reserve(count);
+    s.nameColumn.reserve(count);
+    s.typeColumn.reserve(count);
+    s.kindColumn.reserve(count);
+}
+
+shared_ptr<station> Line::find(std::string_view name) const {
+    shared_ptr<station> st = tryFind(name);
+    if (!st)
         throw std::invalid_argument("Error: Station not found on this line.");
-    return stations_table[index].second;
+    return st;
+}
+
+shared_ptr<station> Line::tryFind(std::string_view name) const noexcept {
+    auto key = mgc::Symbol::find(name);
+    if (!key)
+        return nullptr;
+    return tryFind(*key);
 }
 
-void Line::removeElement(const string &stationName) {
-    if (!stations_table.erase(stationName))
+shared_ptr<station> Line::tryFind(mgc::Symbol name) const noexcept {
+    const StationTable &table = stations->table;
+    size_t index = table.find(name);
+    if (index == table.size())
+        return nullptr;
+    return table[index].second;
+}
+
+void Line::removeElement(std::string_view stationName) {
+    auto key = mgc::Symbol::find(stationName);
+    size_t slot = key ? stations->table.find(*key) : stations->table.size();
+    if (slot == stations->table.size())
         throw std::invalid_argument("Error: Station not found in line.");
+    Stations &s = stations.edit();
+    s.table.erase(slot);
+    eraseColumns(s, slot);
+}
+
+size_t Line::removeElements(const std::unordered_set<mgc::Symbol> &names) {
+    auto listed = [&names](mgc::Symbol name) { return names.contains(name); };
+    if (std::ranges::none_of(stations->nameColumn, listed))
+        return 0;
+    Stations &s = stations.edit();
+    size_t removed = s.table.eraseIf([&listed](const StationTable::PairType &pair) { return listed(pair.first); });
+    size_t kept = 0;
+    for (size_t slot = 0; slot < s.nameColumn.size(); ++slot) {
+        if (listed(s.nameColumn[slot]))
+            continue;
+        s.nameColumn[kept] = s.nameColumn[slot];
+        s.typeColumn[kept] = s.typeColumn[slot];
+        s.kindColumn[kept] = s.kindColumn[slot];
+        ++kept;
+    }
+    s.nameColumn.resize(kept);
+    s.typeColumn.resize(kept);
+    s.kindColumn.resize(kept);
+    return removed;
 }
 
 string Line::getTableStr() const {
     string res;
-    for (auto it = stations_table.begin(); it != stations_table.end(); ++it) {
-        res += it->second->getName() + '-' + it->second->getType() + '\n';
-    }
+    res.reserve(getTableSize());
+    mgc::TextSink out(res);
+    writeTable(out);
     return res;
 }
 
+size_t Line::getTableSize() const noexcept {
+    const auto &nameColumn = stations->nameColumn;
+    const auto &typeColumn = stations->typeColumn;
+    size_t total = 2 * nameColumn.size();
+    for (size_t slot = 0; slot < nameColumn.size(); ++slot)
+        total += nameColumn[slot].str().size() + typeColumn[slot].str().size();
+    return total;
+}
+
+void Line::writeTable(mgc::TextSink &out) const {
+    const auto &nameColumn = stations->nameColumn;
+    const auto &typeColumn = stations->typeColumn;
+    for (size_t slot = 0; slot < nameColumn.size(); ++slot) {
+        out.append(nameColumn[slot].str());
+        out.put('-');
+        out.append(typeColumn[slot].str());
+        out.put('\n');
+    }
+}
+
+namespace {
+
+/// Sets the high bit of every byte of @p word equal to @p kind, and nothing else.
+uint64_t matchBytes(uint64_t word, StationKind kind) noexcept {
+    constexpr uint64_t low7 = 0x7F7F7F7F7F7F7F7Full;
+    uint64_t x = word ^ (0x0101010101010101ull * static_cast<uint8_t>(kind));
+    return ~(((x & low7) + low7) | x | low7);
+}
+
+uint64_t loadWord(const StationKind *p) noexcept {
+    uint64_t word;
+    std::memcpy(&word, p, sizeof(word));
+    return word;
+}
+
+} // namespace
+
+size_t Line::countOfKind(StationKind kind) const noexcept {
+    const StationKind *kinds = stations->kindColumn.data();
+    size_t n = stations->kindColumn.size(), slot = 0, count = 0;
+    while (slot + 8 <= n) {
+        // Per-byte counters; flushed before any of them can overflow.
+        uint64_t lanes = 0;
+        for (size_t words = 0; words < 255 && slot + 8 <= n; ++words, slot += 8)
+            lanes += matchBytes(loadWord(kinds + slot), kind) >> 7;
+        uint64_t pairs = (lanes & 0x00FF00FF00FF00FFull) + ((lanes >> 8) & 0x00FF00FF00FF00FFull);
+        count += static_cast<size_t>((pairs * 0x0001000100010001ull) >> 48);
+    }
+    for (; slot < n; ++slot)
+        count += kinds[slot] == kind;
+    return count;
+}
+
+std::vector<size_t> Line::slotsOfKind(StationKind kind) const {
+    std::vector<size_t> slots;
+    const StationKind *kinds = stations->kindColumn.data();
+    size_t n = stations->kindColumn.size(), slot = 0;
+    for (; slot + 8 <= n; slot += 8) {
+        uint64_t match = matchBytes(loadWord(kinds + slot), kind);
+        while (match) {
+            // Bytes are loaded little-endian on the supported targets.
+            slots.push_back(slot + static_cast<size_t>(std::countr_zero(match)) / 8);
+            match &= match - 1;
+        }
+    }
+    for (; slot < n; ++slot) {
+        if (kinds[slot] == kind)
+            slots.push_back(slot);
+    }
+    return slots;
+}
+
 std::ostream &Line::showTable(std::ostream &ost) const {
-    ost << getTableStr();
+    mgc::TextSink out(ost);
+    writeTable(out);
     return ost;
 }
 
@@ -4,22 +4,76 @@
 #include <ostream>
 #include <memory>
 #include <string>
+#include <span>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
 #include "../Stations/station.hpp"
 #include "../container/lookUpTable.hpp"
+#include "../container/arena.hpp"
+#include "../container/cowPtr.hpp"
+#include "../container/textSink.hpp"
 
 using std::shared_ptr;
 using std::string;
 
 namespace mgm {
 
+/**
+ * @brief Where a line allocates its station objects.
+ */
+enum class StationStorage : uint8_t {
+    Heap, ///< One std::make_shared allocation per station.
+    Arena ///< Stations of the line are packed into a pooled arena owned by the line.
+};
+
 /**
  * @brief Represents a metro line consisting of stations.
  *
- * This class stores stations in a LookupTable mapping station names to shared pointers to stations.
+ * This class stores stations in a LookupTable mapping interned station names to shared pointers to stations.
+ * The table is hash-indexed on the name symbols, so finding, adding and removing a station by name
+ * does not scan the line and never hashes or compares the name text.
+ *
+ * Next to the table the line keeps packed columns with the name, type and kind of the station in
+ * each slot. Scans that only need those fields (listing the line, filtering by kind) run over the
+ * columns and never touch the station objects.
+ *
+ * The table and the columns are copy-on-write: copying a line is O(1), and the copies share them
+ * until one copy changes its stations. The station objects themselves are shared by the copies
+ * either way.
  */
 class Line {
-    string name;
-    mgc::LookupTable<string, shared_ptr<station>> stations_table;
+public:
+    /**
+     * @brief Type of the table holding the stations of a line in their order.
+     */
+    using StationTable = mgc::HashedLookupTable<mgc::Symbol, shared_ptr<station>>;
+
+private:
+    /**
+     * @brief The stations of a line, shared by its copies until one of them is changed.
+     */
+    struct Stations {
+        StationTable table;
+        std::vector<mgc::Symbol> nameColumn; ///< Slot -> station name.
+        std::vector<mgc::Symbol> typeColumn; ///< Slot -> station type.
+        std::vector<StationKind> kindColumn; ///< Slot -> station kind, one byte each.
+    };
+
+    mgc::Symbol name;
+    mgc::CowPtr<Stations> stations;
+    std::shared_ptr<mgc::Arena> arena; ///< Set in StationStorage::Arena mode; shared by copies of the line.
+
+    template<typename T>
+    shared_ptr<station> makeStation(T &&st) {
+        using Station = std::decay_t<T>;
+        if (arena)
+            return std::allocate_shared<Station>(mgc::ArenaAllocator<Station>(arena), std::forward<T>(st));
+        return std::make_shared<Station>(std::forward<T>(st));
+    }
+
+    static void appendColumns(Stations &s, const station &st);
+    static void eraseColumns(Stations &s, size_t slot) noexcept;
 public:
     /**
      * @brief Default constructor.
@@ -30,13 +84,38 @@ public:
      * @brief Constructs a line with the given name.
      * @param n The name of the line.
      */
-    Line(string n) : name(std::move(n)) {}
+    Line(std::string_view n) : name(n) {}
+
+    /**
+     * @brief Constructs a line with the given name and station storage.
+     *
+     * In StationStorage::Arena mode every station object, together with its reference
+     * counts, is carved out of one arena, so a line's stations are contiguous in memory
+     * and freed in bulk once the line and all outside references to them are gone.
+     *
+     * @param n The name of the line.
+     * @param storage Where to allocate station objects.
+     */
+    Line(std::string_view n, StationStorage storage)
+        : name(n), arena(storage == StationStorage::Arena ? std::make_shared<mgc::Arena>() : nullptr) {}
 
     /**
      * @brief Gets the name of the line.
      * @return The line name.
      */
-    string getName() const { return name; }
+    const string &getName() const noexcept { return name.str(); }
+
+    /**
+     * @brief Gets the interned name of the line.
+     * @return The name symbol.
+     */
+    mgc::Symbol getNameSymbol() const noexcept { return name; }
+
+    /**
+     * @brief Gets where the line allocates its station objects.
+     * @return The storage mode.
+     */
+    StationStorage getStorage() const noexcept { return arena ? StationStorage::Arena : StationStorage::Heap; }
 
     /**
      * @brief Adds a station to the line while preserving its dynamic type.
@@ -47,27 +126,92 @@ public:
     template<typename T>
     requires std::is_base_of_v<station, std::decay_t<T>>
     void addElement(T &&st) {
-        string key = st.getName();
-        if (stations_table.find(key) != stations_table.size())
+        mgc::Symbol key = st.getNameSymbol();
+        if (stations->table.find(key) != stations->table.size())
+            throw std::invalid_argument("Error: Station already exists on this line.");
+        Stations &s = stations.edit();
+        shared_ptr<station> ptr = makeStation(std::forward<T>(st));
+        appendColumns(s, *ptr);
+        try {
+            s.table.insert(key, std::move(ptr));
+        } catch (...) {
+            eraseColumns(s, s.nameColumn.size() - 1);
+            throw;
+        }
+    }
+
+    /**
+     * @brief Replaces a station in place, keeping its position on the line.
+     * @tparam T The type of the new station. Must be derived from station.
+     * @param stationName The name of the station to replace.
+     * @param st The new station object; it may have a different name and type.
+     * @throws std::invalid_argument if the station is not found, or another station on the
+     *         line already has the new name.
+     */
+    template<typename T>
+    requires std::is_base_of_v<station, std::decay_t<T>>
+    void replaceElement(std::string_view stationName, T &&st) {
+        const StationTable &table = stations->table;
+        auto oldKey = mgc::Symbol::find(stationName);
+        size_t slot = oldKey ? table.find(*oldKey) : table.size();
+        if (slot == table.size())
+            throw std::invalid_argument("Error: Station not found in line.");
+        mgc::Symbol key = st.getNameSymbol();
+        size_t existing = table.find(key);
+        if (existing != table.size() && existing != slot)
             throw std::invalid_argument("Error: Station already exists on this line.");
-        auto ptr = std::make_shared<std::decay_t<T>>(std::forward<T>(st));
-        stations_table.insert(key, ptr);
+        Stations &s = stations.edit();
+        shared_ptr<station> ptr = makeStation(std::forward<T>(st));
+        s.table.replace(slot, key, ptr);
+        s.nameColumn[slot] = key;
+        s.typeColumn[slot] = ptr->getTypeSymbol();
+        s.kindColumn[slot] = ptr->getKind();
     }
 
+    /**
+     * @brief Reserves room for stations about to be added.
+     * @param count Number of stations the line should hold without reallocating.
+     */
+    void reserve(size_t count);
+
     /**
      * @brief Finds a station on the line by name.
      * @param name The name of the station to find.
      * @return A shared pointer to the station.
      * @throws std::invalid_argument if the station is not found.
      */
-    shared_ptr<station> find(const string &name) const;
+    shared_ptr<station> find(std::string_view name) const;
+
+    /**
+     * @brief Finds a station on the line by name without throwing.
+     * @param name The name of the station to find.
+     * @return A shared pointer to the station, or an empty pointer if it is not on the line.
+     */
+    shared_ptr<station> tryFind(std::string_view name) const noexcept;
+
+    /**
+     * @brief Finds a station on the line by its interned name without throwing.
+     * @param name The name symbol of the station to find.
+     * @return A shared pointer to the station, or an empty pointer if it is not on the line.
+     */
+    shared_ptr<station> tryFind(mgc::Symbol name) const noexcept;
 
     /**
      * @brief Removes a station from the line by its name.
      * @param stationName The name of the station to remove.
      * @throws std::invalid_argument if the station is not found.
      */
-    void removeElement(const string &stationName);
+    void removeElement(std::string_view stationName);
+
+    /**
+     * @brief Removes several stations in one pass over the line.
+     *
+     * The remaining stations keep their order. Names not on the line are ignored.
+     *
+     * @param names The names of the stations to remove.
+     * @return The number of stations removed.
+     */
+    size_t removeElements(const std::unordered_set<mgc::Symbol> &names);
 
     /**
      * @brief Returns a string representation of all stations on the line.
@@ -75,6 +219,18 @@ public:
      */
     string getTableStr() const;
 
+    /**
+     * @brief Gets the length of the station table text.
+     * @return The number of bytes writeTable() produces.
+     */
+    size_t getTableSize() const noexcept;
+
+    /**
+     * @brief Writes the station table, in the format of getTableStr(), to a sink.
+     * @param out The sink.
+     */
+    void writeTable(mgc::TextSink &out) const;
+
     /**
      * @brief Displays the station table to an output stream.
      * @param ost The output stream.
@@ -86,7 +242,39 @@ public:
      * @brief Provides access to the underlying station table.
      * @return A constant reference to the LookupTable.
      */
-    const mgc::LookupTable<string, shared_ptr<station>> &getStations() const { return stations_table; }
+    const StationTable &getStations() const { return stations->table; }
+
+    /**
+     * @brief Gets the station names in slot order.
+     * @return One name per station, parallel to getStations().
+     */
+    std::span<const mgc::Symbol> getNameColumn() const noexcept { return stations->nameColumn; }
+
+    /**
+     * @brief Gets the station types in slot order.
+     * @return One type per station, parallel to getStations().
+     */
+    std::span<const mgc::Symbol> getTypeColumn() const noexcept { return stations->typeColumn; }
+
+    /**
+     * @brief Gets the station kinds in slot order.
+     * @return One kind byte per station, parallel to getStations().
+     */
+    std::span<const StationKind> getKindColumn() const noexcept { return stations->kindColumn; }
+
+    /**
+     * @brief Counts the stations of a kind.
+     * @param kind The kind to count.
+     * @return The number of stations of that kind on the line.
+     */
+    size_t countOfKind(StationKind kind) const noexcept;
+
+    /**
+     * @brief Gets the slots of all stations of a kind.
+     * @param kind The kind to look for.
+     * @return The slots, in line order.
+     */
+    std::vector<size_t> slotsOfKind(StationKind kind) const;
 };
 
 } // namespace mgm
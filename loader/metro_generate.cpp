@@ -0,0 +1,73 @@
+#include "network_generator.hpp"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+/**
+ * @file metro_generate.cpp
+ * @brief Writes a synthetic network in the import format, for `metro --load`.
+ */
+
+using namespace mgm;
+
+namespace {
+
+[[noreturn]] void usage(const char *program) {
+    std::cerr << "Usage: " << program
+              << " [--profile grid|city] [--seed N] [--lines N] [--stations N per line]"
+                 " [--hub-density fraction] [--fan-out N] [--out file]\n";
+    std::exit(1);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    GeneratorOptions options;
+    string outPath;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (i + 1 == argc)
+            usage(argv[0]);
+        string value = argv[++i];
+        if (arg == "--profile" && (value == "grid" || value == "city"))
+            options.profile = value == "city" ? NetworkProfile::City : NetworkProfile::Grid;
+        else if (arg == "--seed")
+            options.seed = std::strtoull(value.c_str(), nullptr, 10);
+        else if (arg == "--lines")
+            options.lines = std::strtoul(value.c_str(), nullptr, 10);
+        else if (arg == "--stations")
+            options.stationsPerLine = std::strtoul(value.c_str(), nullptr, 10);
+        else if (arg == "--hub-density")
+            options.hubDensity = std::strtod(value.c_str(), nullptr);
+        else if (arg == "--fan-out")
+            options.hubFanOut = std::strtoul(value.c_str(), nullptr, 10);
+        else if (arg == "--out")
+            outPath = value;
+        else
+            usage(argv[0]);
+    }
+
+    try {
+        NetworkGenerator generator(options);
+        std::ofstream file;
+        if (!outPath.empty()) {
+            file.open(outPath, std::ios::binary);
+            if (!file)
+                throw std::invalid_argument("Error: Cannot open " + outPath + " for writing.");
+        } else {
+            std::ios::sync_with_stdio(false);
+        }
+        std::ostream &out = outPath.empty() ? std::cout : file;
+        auto stats = generator.write(out);
+        out.flush();
+        if (!out)
+            throw std::invalid_argument("Error: Writing the network failed.");
+        std::cerr << "Generated " << stats.lines << " lines, " << stats.stations << " stations, "
+                  << stats.transfers << " transfers.\n";
+    } catch (std::exception &ex) {
+        std::cerr << ex.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,275 @@
+#include "network_generator.hpp"
+#include "../container/textSink.hpp"
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <vector>
+
+namespace mgm {
+
+namespace {
+
+constexpr uint32_t NoPlace = UINT32_MAX;
+
+/// SplitMix64: small, fast, and the same sequence with every standard library.
+class Random {
+public:
+    explicit Random(uint64_t seed) : state(seed) {}
+
+    uint64_t next() {
+        uint64_t z = (state += 0x9e3779b97f4a7c15);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+        return z ^ (z >> 31);
+    }
+
+    /// A number in [0, n).
+    size_t below(size_t n) { return static_cast<size_t>(next() % n); }
+
+    /// A number in [0, 1).
+    double unit() { return static_cast<double>(next() >> 11) * 0x1.0p-53; }
+
+    bool chance(double p) { return unit() < p; }
+
+private:
+    uint64_t state;
+};
+
+/// A station of the plan; place numbers the City interchange it belongs to, if any.
+struct Stop {
+    uint32_t line, slot, place;
+};
+
+/// A transition station and the stations it connects to.
+struct Hub {
+    uint32_t slot, place;
+    size_t count = 0;
+    std::array<Stop, transfer_hub::capacity> targets{};
+};
+
+/// Lengths of the lines and their hubs, by slot.
+struct Plan {
+    std::vector<size_t> lengths;
+    std::vector<std::vector<Hub>> hubs;
+};
+
+void appendLineName(string &to, size_t line) {
+    to += 'L';
+    mgc::appendNumber(to, line);
+}
+
+void appendStationName(string &to, const Stop &stop) {
+    if (stop.place != NoPlace) {
+        to += "Hub";
+        mgc::appendNumber(to, stop.place);
+    } else {
+        appendLineName(to, stop.line);
+        to += "_S";
+        mgc::appendNumber(to, stop.slot);
+    }
+}
+
+Plan gridPlan(const GeneratorOptions &options) {
+    Plan plan;
+    plan.lengths.assign(options.lines, options.stationsPerLine);
+    plan.hubs.resize(options.lines);
+    if (options.lines < 2)
+        return plan;
+    Random random(options.seed);
+    size_t fanOut = std::min(options.hubFanOut, options.lines - 1);
+    for (size_t i = 0; i < options.lines; ++i) {
+        for (size_t j = 0; j < options.stationsPerLine; ++j) {
+            if (!random.chance(options.hubDensity))
+                continue;
+            Hub hub{static_cast<uint32_t>(j), NoPlace};
+            size_t count = 1 + random.below(fanOut);
+            while (hub.count < count) {
+                auto line = static_cast<uint32_t>(random.below(options.lines - 1));
+                if (line >= i)
+                    ++line;
+                auto last = hub.targets.begin() + static_cast<std::ptrdiff_t>(hub.count);
+                if (std::none_of(hub.targets.begin(), last, [&](const Stop &s) { return s.line == line; }))
+                    hub.targets[hub.count++] = Stop{line, hub.slot, NoPlace};
+            }
+            plan.hubs[i].push_back(hub);
+        }
+    }
+    return plan;
+}
+
+Plan cityPlan(const GeneratorOptions &options) {
+    Plan plan;
+    Random random(options.seed);
+    std::vector<size_t> offsets;
+    size_t total = 0;
+    for (size_t i = 0; i < options.lines; ++i) {
+        double length = static_cast<double>(options.stationsPerLine) * (0.5 + random.unit());
+        plan.lengths.push_back(std::max<size_t>(1, static_cast<size_t>(length + 0.5)));
+        offsets.push_back(total);
+        total += plan.lengths.back();
+    }
+    plan.hubs.resize(options.lines);
+    if (options.lines < 2)
+        return plan;
+
+    std::vector<bool> taken(total);
+    size_t maxLines = std::min(options.hubFanOut + 1, options.lines);
+    auto wanted = static_cast<size_t>(static_cast<double>(total) * options.hubDensity);
+    size_t hubStations = 0;
+    uint32_t places = 0;
+    for (size_t attempt = 0; hubStations + 2 <= wanted && attempt < 4 * wanted; ++attempt) {
+        size_t want = 2;
+        while (want < maxLines && random.chance(0.35))
+            ++want;
+        bool central = places % 10 == 0;
+        std::array<Stop, transfer_hub::capacity + 1> stops{};
+        size_t count = 0;
+        for (size_t tries = 0; count < want && tries < 4 * want; ++tries) {
+            auto line = static_cast<uint32_t>(random.below(options.lines));
+            auto last = stops.begin() + static_cast<std::ptrdiff_t>(count);
+            if (std::any_of(stops.begin(), last, [&](const Stop &s) { return s.line == line; }))
+                continue;
+            size_t length = plan.lengths[line];
+            size_t slot = central ? length / 2 - length / 10 + random.below(length / 5 + 1) : random.below(length);
+            if (taken[offsets[line] + slot])
+                continue;
+            stops[count++] = Stop{line, static_cast<uint32_t>(slot), places};
+        }
+        if (count < 2)
+            continue;
+        for (size_t k = 0; k < count; ++k) {
+            taken[offsets[stops[k].line] + stops[k].slot] = true;
+            Hub hub{stops[k].slot, places};
+            for (size_t other = 0; other < count; ++other) {
+                if (other != k)
+                    hub.targets[hub.count++] = stops[other];
+            }
+            plan.hubs[stops[k].line].push_back(hub);
+        }
+        hubStations += count;
+        ++places;
+    }
+    for (auto &hubs : plan.hubs)
+        std::sort(hubs.begin(), hubs.end(), [](const Hub &a, const Hub &b) { return a.slot < b.slot; });
+    return plan;
+}
+
+Plan makePlan(const GeneratorOptions &options) {
+    return options.profile == NetworkProfile::City ? cityPlan(options) : gridPlan(options);
+}
+
+} // namespace
+
+NetworkGenerator::NetworkGenerator(const GeneratorOptions &options) : options(options) {
+    if (options.lines == 0 || options.stationsPerLine == 0)
+        throw std::invalid_argument("Error: A generated network needs at least one line and one station per line.");
+    if (!(options.hubDensity >= 0.0 && options.hubDensity <= 1.0))
+        throw std::invalid_argument("Error: The hub density must be between 0 and 1.");
+    if (options.hubFanOut == 0 || options.hubFanOut > transfer_hub::capacity)
+        throw std::invalid_argument("Error: The hub fan-out must be between 1 and the capacity of the transfer_hub.");
+}
+
+LoadStats NetworkGenerator::populate(MetroSystem &system) const {
+    Plan plan = makePlan(options);
+    LoadStats stats;
+    string lineName;
+    for (size_t i = 0; i < plan.lengths.size(); ++i) {
+        lineName.clear();
+        appendLineName(lineName, i);
+        system.addLine(lineName);
+        ++stats.lines;
+    }
+
+    std::vector<StationSpec> specs;
+    for (size_t i = 0; i < plan.lengths.size(); ++i) {
+        specs.resize(plan.lengths[i]);
+        auto hub = plan.hubs[i].begin();
+        for (size_t j = 0; j < specs.size(); ++j) {
+            bool isHub = hub != plan.hubs[i].end() && hub->slot == j;
+            specs[j].name.clear();
+            appendStationName(specs[j].name,
+                              Stop{static_cast<uint32_t>(i), static_cast<uint32_t>(j), isHub ? hub->place : NoPlace});
+            specs[j].type = isHub ? "transition" : "Direct";
+            if (isHub)
+                ++hub;
+        }
+        lineName.clear();
+        appendLineName(lineName, i);
+        system.addStationsToLine(lineName, specs);
+        stats.stations += specs.size();
+    }
+
+    string stationName, targetStation, targetLine;
+    for (size_t i = 0; i < plan.hubs.size(); ++i) {
+        lineName.clear();
+        appendLineName(lineName, i);
+        for (const Hub &hub : plan.hubs[i]) {
+            stationName.clear();
+            appendStationName(stationName, Stop{static_cast<uint32_t>(i), hub.slot, hub.place});
+            for (size_t k = 0; k < hub.count; ++k) {
+                targetStation.clear();
+                appendStationName(targetStation, hub.targets[k]);
+                targetLine.clear();
+                appendLineName(targetLine, hub.targets[k].line);
+                system.addTransfer(lineName, stationName, targetStation, targetLine);
+                ++stats.transfers;
+            }
+        }
+    }
+    return stats;
+}
+
+MetroSystem NetworkGenerator::generate() const {
+    MetroSystem system;
+    populate(system);
+    return system;
+}
+
+LoadStats NetworkGenerator::write(std::ostream &out) const {
+    Plan plan = makePlan(options);
+    LoadStats stats;
+    mgc::TextSink sink(out);
+    string record;
+    for (size_t i = 0; i < plan.lengths.size(); ++i) {
+        record.assign("line ");
+        appendLineName(record, i);
+        record += ' ';
+        mgc::appendNumber(record, plan.lengths[i]);
+        record += '\n';
+        sink.append(record);
+        ++stats.lines;
+        auto hub = plan.hubs[i].begin();
+        for (size_t j = 0; j < plan.lengths[i]; ++j) {
+            bool isHub = hub != plan.hubs[i].end() && hub->slot == j;
+            record.assign("station ");
+            appendStationName(record,
+                              Stop{static_cast<uint32_t>(i), static_cast<uint32_t>(j), isHub ? hub->place : NoPlace});
+            record += isHub ? " transition\n" : " Direct\n";
+            sink.append(record);
+            if (isHub)
+                ++hub;
+        }
+        stats.stations += plan.lengths[i];
+    }
+    for (size_t i = 0; i < plan.hubs.size(); ++i) {
+        for (const Hub &hub : plan.hubs[i]) {
+            for (size_t k = 0; k < hub.count; ++k) {
+                record.assign("transfer ");
+                appendLineName(record, i);
+                record += ' ';
+                appendStationName(record, Stop{static_cast<uint32_t>(i), hub.slot, hub.place});
+                record += ' ';
+                appendStationName(record, hub.targets[k]);
+                record += ' ';
+                appendLineName(record, hub.targets[k].line);
+                record += '\n';
+                sink.append(record);
+                ++stats.transfers;
+            }
+        }
+    }
+    sink.flush();
+    return stats;
+}
+
+} // namespace mgm
@@ -0,0 +1,96 @@
+#ifndef NETWORK_GENERATOR_HPP_
+#define NETWORK_GENERATOR_HPP_
+
+#include "network_loader.hpp"
+#include <cstdint>
+#include <ostream>
+
+/**
+ * @file network_generator.hpp
+ * @brief Seeded synthetic networks for tests and load testing, built in memory or as import files.
+ */
+
+namespace mgm {
+
+/**
+ * @brief Shapes of generated networks.
+ */
+enum class NetworkProfile {
+    Grid, ///< Lines of equal length with hubs spread uniformly, each linked one way to stations on other lines.
+    City  ///< Lines of varying length sharing named interchanges, clustered in the middle of the lines.
+};
+
+/**
+ * @brief Parameters of a generated network.
+ */
+struct GeneratorOptions {
+    uint64_t seed = 1;                            ///< Seed; equal options give equal networks.
+    size_t lines = 10;                            ///< Number of lines.
+    size_t stationsPerLine = 100;                 ///< Stations per line; the mean length for City.
+    double hubDensity = 0.1;                      ///< Share of stations that are transition stations.
+    size_t hubFanOut = 2;                         ///< Most connections per hub, at most transfer_hub::capacity.
+    NetworkProfile profile = NetworkProfile::Grid; ///< Shape of the network.
+};
+
+/**
+ * @brief Deterministic generator of synthetic metro networks.
+ *
+ * Lines are named "L<i>" and ordinary stations "L<i>_S<j>", as in the benchmark
+ * networks. Grid hubs keep their own name and get up to @c hubFanOut connections to
+ * the station in the same position on other lines. City interchanges are named
+ * "Hub<k>" on every line they serve, like real interchange stations, and connect
+ * to each other; each joins two to @c hubFanOut + 1 lines, most of them two, and a
+ * tenth of them sit in the middle stretch of their lines as a city centre. Every
+ * connection points to a station that exists, so a generated network validates
+ * without changes.
+ *
+ * The network is drawn from its own pseudo-random sequence rather than from
+ * \<random\> distributions, so a seed gives the same network with every standard
+ * library. populate() adds the stations of each line as one batch with
+ * MetroSystem::addStationsToLine(); write() streams the same network in the format
+ * read by NetworkLoader without building it.
+ */
+class NetworkGenerator {
+public:
+    /**
+     * @brief Constructs a generator.
+     * @param options The network parameters.
+     * @throws std::invalid_argument if there are no lines or stations, the hub density is
+     *         outside [0, 1] or the fan-out is outside [1, transfer_hub::capacity].
+     */
+    explicit NetworkGenerator(const GeneratorOptions &options);
+
+    /**
+     * @brief Adds the network to a system.
+     * @param system The system; it must not have lines of the generated names.
+     * @return Counts of what was added.
+     * @throws std::invalid_argument if a line of the network already exists.
+     */
+    LoadStats populate(MetroSystem &system) const;
+
+    /**
+     * @brief Builds the network as a new system.
+     * @return The system.
+     */
+    MetroSystem generate() const;
+
+    /**
+     * @brief Writes the network in the format read by NetworkLoader.
+     * @param out The output stream.
+     * @return Counts of what was written.
+     */
+    LoadStats write(std::ostream &out) const;
+
+    /**
+     * @brief Gets the parameters of the generator.
+     * @return The options.
+     */
+    const GeneratorOptions &getOptions() const noexcept { return options; }
+
+private:
+    GeneratorOptions options;
+};
+
+} // namespace mgm
+
+#endif
@@ -0,0 +1,153 @@
+#include "network_loader.hpp"
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace mgm {
+
+namespace {
+
+constexpr size_t MaxFields = 6;
+/// Station count hints are advisory; no more stations than this are reserved up front.
+constexpr size_t MaxReservedStations = size_t{1} << 16;
+
+} // namespace
+
+void NetworkLoader::fail(size_t line, std::string_view message) const {
+    throw std::invalid_argument("Error: line " + std::to_string(line) + ": " + string(mgc::withoutErrorPrefix(message)));
+}
+
+LoadStats NetworkLoader::load(std::istream &in) {
+    stats = LoadStats{};
+    inputLine = 0;
+    currentLine.clear();
+    pendingCount = 0;
+    transfers.clear();
+    reader.read(in, [this](std::string_view record) {
+        parseRecord(record);
+        return true;
+    });
+    flushLine();
+
+    for (const auto &t : transfers) {
+        try {
+            metroSystem.addTransfer(t.line, t.station, t.targetStation, t.targetLine);
+        } catch (const std::invalid_argument &ex) {
+            fail(t.inputLine, ex.what());
+        }
+        ++stats.transfers;
+    }
+    transfers.clear();
+    return stats;
+}
+
+LoadStats NetworkLoader::loadFile(const string &path) {
+    if (path == "-")
+        return load(std::cin);
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        throw std::invalid_argument("Error: Cannot open network file " + path + ".");
+    return load(file);
+}
+
+void NetworkLoader::parseRecord(std::string_view record) {
+    ++inputLine;
+    std::array<std::string_view, MaxFields> fields;
+    size_t count = mgc::splitFields(record, fields);
+    if (count == 0 || fields[0].front() == '#')
+        return;
+
+    if (fields[0] == "station") {
+        if (currentLine.empty())
+            fail(inputLine, "station record before any line record.");
+        if (count < 2 || count > 3)
+            fail(inputLine, "expected: station <name> [<type>].");
+        if (pendingCount == pending.size()) {
+            pending.emplace_back();
+            pendingRecords.emplace_back();
+        }
+        pendingRecords[pendingCount] = inputLine;
+        StationSpec &spec = pending[pendingCount++];
+        spec.name.assign(fields[1]);
+        if (count == 3)
+            spec.type.assign(fields[2]);
+        else
+            spec.type.assign("Direct");
+    } else if (fields[0] == "line") {
+        if (count < 2 || count > 3)
+            fail(inputLine, "expected: line <name> [<station count>].");
+        flushLine();
+        currentLine.assign(fields[1]);
+        currentLineRecord = inputLine;
+        if (!metroSystem.tryFindLine(currentLine))
+            metroSystem.addLine(currentLine);
+        if (count == 3) {
+            size_t hint = 0;
+            auto [ptr, ec] = std::from_chars(fields[2].data(), fields[2].data() + fields[2].size(), hint);
+            if (ec == std::errc::result_out_of_range)
+                fail(inputLine, "station count is out of range.");
+            if (ec != std::errc() || ptr != fields[2].data() + fields[2].size())
+                fail(inputLine, "station count must be a number.");
+            pending.reserve(std::min(hint, MaxReservedStations));
+            pendingRecords.reserve(pending.capacity());
+        }
+        ++stats.lines;
+    } else if (fields[0] == "transfer") {
+        if (count != 5)
+            fail(inputLine, "expected: transfer <line> <station> <target station> <target line>.");
+        transfers.push_back(PendingTransfer{string(fields[1]), string(fields[2]),
+                                            string(fields[3]), string(fields[4]), inputLine});
+    } else {
+        fail(inputLine, "unknown record '" + string(fields[0]) + "'.");
+    }
+}
+
+void NetworkLoader::flushLine() {
+    if (pendingCount == 0)
+        return;
+    try {
+        metroSystem.addStationsToLine(currentLine, std::span<const StationSpec>(pending.data(), pendingCount));
+    } catch (const std::invalid_argument &ex) {
+        fail(rejectedRecord(), ex.what());
+    }
+    stats.stations += pendingCount;
+    pendingCount = 0;
+}
+
+size_t NetworkLoader::rejectedRecord() const {
+    // The batch was rolled back, so the line is as it was: the first station already
+    // on it or earlier in the batch is the one addStationsToLine() refused.
+    const Line *line = metroSystem.tryFindLine(currentLine);
+    std::unordered_set<std::string_view> seen;
+    for (size_t i = 0; i < pendingCount; ++i) {
+        std::string_view name = pending[i].name;
+        if ((line && line->tryFind(name)) || !seen.insert(name).second)
+            return pendingRecords[i];
+    }
+    return currentLineRecord;
+}
+
+void saveNetwork(const MetroSystem &system, std::ostream &out) {
+    for (const auto &linePair : system.getLines()) {
+        const auto &table = linePair.second.getStations();
+        out << "line " << linePair.first.str() << ' ' << table.size() << '\n';
+        for (const auto &stationPair : table)
+            out << "station " << stationPair.first.str() << ' ' << stationPair.second->getType() << '\n';
+    }
+    for (const auto &linePair : system.getLines()) {
+        for (const auto &stationPair : linePair.second.getStations()) {
+            auto *ts = dynamic_cast<const transition_station *>(stationPair.second.get());
+            if (!ts)
+                continue;
+            for (const auto &conn : ts->get_station_list())
+                out << "transfer " << linePair.first.str() << ' ' << stationPair.first.str() << ' '
+                    << conn.first.str() << ' ' << conn.second.str() << '\n';
+        }
+    }
+}
+
+} // namespace mgm
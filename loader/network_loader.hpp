@@ -0,0 +1,105 @@
+#ifndef NETWORK_LOADER_HPP_
+#define NETWORK_LOADER_HPP_
+
+#include "../Metro_system/metro_system.hpp"
+#include "../container/recordReader.hpp"
+#include <istream>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @file network_loader.hpp
+ * @brief Bulk import and export of metro networks in a line-oriented text format.
+ *
+ * One record per line, fields separated by spaces or tabs:
+ * @code
+ * # comment
+ * line <line name> [<station count hint>]
+ * station <station name> [<type>]
+ * transfer <line name> <station name> <target station> <target line>
+ * @endcode
+ * @c station records append to the line named by the last @c line record, in
+ * order; the type defaults to "Direct". @c transfer records may appear anywhere
+ * and are applied once all stations are in place. The station count of a
+ * @c line record only sizes buffers, up to a fixed cap; it is not checked.
+ */
+
+namespace mgm {
+
+/**
+ * @brief Counts of what a bulk load added.
+ */
+struct LoadStats {
+    size_t lines = 0;     ///< Line records read.
+    size_t stations = 0;  ///< Stations added.
+    size_t transfers = 0; ///< Transfer connections added.
+};
+
+/**
+ * @brief Streaming loader for network definitions.
+ *
+ * Reads the input in one pass through a fixed-size chunk buffer, splits records
+ * without allocating, and hands the stations of each line to
+ * MetroSystem::addStationsToLine() as one batch. The buffers are kept between
+ * loads, so one loader can import several files cheaply.
+ */
+class NetworkLoader {
+public:
+    /**
+     * @brief Constructs a loader that adds to the given system.
+     * @param system The system to populate.
+     */
+    explicit NetworkLoader(MetroSystem &system) : metroSystem(system) {}
+
+    /**
+     * @brief Loads network records from a stream.
+     * @param in The input stream.
+     * @return Counts of what was added.
+     * @throws std::invalid_argument on a malformed record or a rejected edit, with the
+     *         number of the offending input line in the message.
+     */
+    LoadStats load(std::istream &in);
+
+    /**
+     * @brief Loads network records from a file.
+     * @param path Path of the file, or "-" for standard input.
+     * @return Counts of what was added.
+     * @throws std::invalid_argument if the file cannot be opened or its contents are invalid.
+     */
+    LoadStats loadFile(const string &path);
+
+private:
+    struct PendingTransfer {
+        string line, station, targetStation, targetLine;
+        size_t inputLine;
+    };
+
+    void parseRecord(std::string_view record);
+    void flushLine();
+    size_t rejectedRecord() const;
+    [[noreturn]] void fail(size_t inputLine, std::string_view message) const;
+
+    MetroSystem &metroSystem;
+    LoadStats stats;
+    size_t inputLine = 0;          ///< Number of the record being parsed.
+    string currentLine;            ///< Line the station records append to.
+    size_t currentLineRecord = 0;  ///< Input line of the current line record.
+    std::vector<StationSpec> pending; ///< Reused station buffer of the current line.
+    std::vector<size_t> pendingRecords; ///< Input line of each station in pending.
+    size_t pendingCount = 0;
+    std::vector<PendingTransfer> transfers;
+    mgc::RecordReader reader;
+};
+
+/**
+ * @brief Writes a system in the format read by NetworkLoader.
+ * @param system The system to write.
+ * @param out The output stream.
+ */
+void saveNetwork(const MetroSystem &system, std::ostream &out);
+
+} // namespace mgm
+
+#endif
@@ -1,8 +1,96 @@
 #include "Metro_system/metro_system.hpp"
 #include "UI/UI.hpp"
+#include "UI/batch_runner.hpp"
+#include "loader/network_loader.hpp"
+#include "server/metro_server.hpp"
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <unistd.h>
 
-int main() {
+namespace {
+
+mgm::MetroServer *serving = nullptr;
+
+void stopServing(int) {
+    if (serving)
+        serving->stop();
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
     mgm::MetroSystem metroSystem;
+    bool batch = false;
+    const char *network = nullptr;
+    const char *socketPath = nullptr;
+    unsigned workers = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--batch") {
+            batch = true;
+        } else if (arg == "--load" && i + 1 < argc && !network) {
+            network = argv[++i];
+        } else if (arg == "--serve" && i + 1 < argc && !socketPath) {
+            socketPath = argv[++i];
+        } else if (arg == "--workers" && i + 1 < argc) {
+            workers = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--load <network file | ->] [--batch | --serve <socket> [--workers N]]\n";
+            return 1;
+        }
+    }
+    if (batch && socketPath) {
+        std::cerr << "Error: --batch and --serve cannot be combined.\n";
+        return 1;
+    }
+    if (batch && network && std::string(network) == "-") {
+        std::cerr << "Error: --batch reads commands from standard input; load the network from a file.\n";
+        return 1;
+    }
+    if (batch)
+        std::ios::sync_with_stdio(false);
+    if (network) {
+        try {
+            auto stats = mgm::NetworkLoader(metroSystem).loadFile(network);
+            (batch ? std::cerr : std::cout) << "Loaded " << stats.lines << " lines, " << stats.stations
+                                            << " stations, " << stats.transfers << " transfers.\n";
+        } catch (std::exception &ex) {
+            std::cerr << ex.what() << "\n";
+            return 1;
+        }
+    }
+    if (batch) {
+        mgc::TextSink out(STDOUT_FILENO);
+        try {
+            auto stats = mgm::BatchRunner(metroSystem).run(std::cin, out);
+            out.flush();
+            return stats.errors ? 2 : 0;
+        } catch (std::exception &ex) {
+            std::cerr << ex.what() << "\n";
+            return 1;
+        }
+    }
+    if (socketPath) {
+        try {
+            mgm::SharedMetroSystem shared(std::move(metroSystem));
+            mgm::MetroServer server(shared, mgm::ServerOptions{socketPath, workers});
+            serving = &server;
+            std::signal(SIGINT, stopServing);
+            std::signal(SIGTERM, stopServing);
+            std::cout << "Serving on " << socketPath << std::endl;
+            server.run();
+            serving = nullptr;
+            const auto &stats = server.stats();
+            std::cout << "Served " << stats.requests << " requests on " << stats.connections << " connections.\n";
+        } catch (std::exception &ex) {
+            std::cerr << ex.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
     mgm::UI ui(metroSystem);
     ui.update();
     return 0;
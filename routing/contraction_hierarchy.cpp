@@ -0,0 +1,331 @@
+#include "contraction_hierarchy.hpp"
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+namespace mgm {
+
+namespace {
+
+constexpr uint32_t NoParent = std::numeric_limits<uint32_t>::max();
+constexpr uint32_t NoMiddle = std::numeric_limits<uint32_t>::max(); ///< Middle of an edge of the graph itself.
+constexpr uint64_t Primary = uint64_t{1} << 32;
+constexpr uint64_t Infinite = std::numeric_limits<uint64_t>::max();
+
+/// Nodes a witness search settles before it gives up and a shortcut is added anyway.
+constexpr uint32_t WitnessSettleLimit = 128;
+
+using HeapItem = std::pair<uint64_t, uint32_t>;
+constexpr auto later = std::greater<HeapItem>{};
+
+/// An edge of the graph being contracted, kept at both of its ends.
+struct Arc {
+    uint32_t to;
+    uint32_t middle;
+    uint64_t weight;
+};
+
+/// Adds an edge or lowers the weight of the existing one.
+void setArc(std::vector<Arc> &arcs, uint32_t to, uint64_t weight, uint32_t middle) {
+    for (Arc &arc : arcs) {
+        if (arc.to == to) {
+            if (weight < arc.weight) {
+                arc.weight = weight;
+                arc.middle = middle;
+            }
+            return;
+        }
+    }
+    arcs.push_back(Arc{to, middle, weight});
+}
+
+/// The graph during contraction, with the searches that decide which shortcuts are needed.
+class Contractor {
+public:
+    Contractor(const RouteGraphView &graph, RouteCost cost)
+        : adj(graph.nodeCount), deleted(graph.nodeCount, 0), level(graph.nodeCount, 0),
+          dist(graph.nodeCount), seen(graph.nodeCount, 0) {
+        const uint64_t ride = cost == RouteCost::FewestStops ? Primary : 1;
+        const uint64_t transfer = cost == RouteCost::FewestStops ? 1 : Primary;
+        for (uint32_t u = 0; u < graph.nodeCount; ++u) {
+            for (uint32_t e = graph.offsets[u]; e < graph.offsets[u + 1]; ++e) {
+                uint32_t v = graph.targets[e];
+                if (v == u)
+                    continue;
+                bool isRide = graph.kinds[e] == static_cast<uint8_t>(EdgeKind::Ride);
+                setArc(adj[u], v, isRide ? ride : transfer, NoMiddle);
+            }
+        }
+    }
+
+    /// Counts the shortcuts contracting @p v needs and returns its priority: the edge
+    /// difference plus the neighbours already contracted. With @p outTo set, the
+    /// shortcuts are collected too, as an arc out of each entry of @p outFrom.
+    int64_t simulate(uint32_t v, std::vector<Arc> *outTo = nullptr, std::vector<uint32_t> *outFrom = nullptr) {
+        const auto &arcs = adj[v];
+        int64_t added = 0;
+        for (size_t i = 0; i < arcs.size(); ++i) {
+            uint64_t limit = 0;
+            for (size_t j = i + 1; j < arcs.size(); ++j)
+                limit = std::max(limit, arcs[i].weight + arcs[j].weight);
+            if (limit == 0)
+                continue;
+            witness(arcs[i].to, v, limit);
+            for (size_t j = i + 1; j < arcs.size(); ++j) {
+                uint64_t via = arcs[i].weight + arcs[j].weight;
+                uint32_t w = arcs[j].to;
+                if (seen[w] == generation && dist[w] <= via)
+                    continue;
+                ++added;
+                if (outTo) {
+                    outTo->push_back(Arc{w, v, via});
+                    outFrom->push_back(arcs[i].to);
+                }
+            }
+        }
+        return 4 * (added - static_cast<int64_t>(arcs.size())) + 2 * deleted[v] + level[v];
+    }
+
+    /// Removes @p v from the graph; returns its edges, all of them to higher-ranked nodes.
+    std::vector<Arc> contract(uint32_t v) {
+        std::vector<Arc> shortcuts;
+        std::vector<uint32_t> from;
+        simulate(v, &shortcuts, &from);
+        std::vector<Arc> up = std::move(adj[v]);
+        adj[v].clear();
+        for (const Arc &arc : up) {
+            std::erase_if(adj[arc.to], [v](const Arc &a) { return a.to == v; });
+            ++deleted[arc.to];
+            level[arc.to] = std::max(level[arc.to], level[v] + 1);
+        }
+        for (size_t i = 0; i < shortcuts.size(); ++i) {
+            setArc(adj[from[i]], shortcuts[i].to, shortcuts[i].weight, v);
+            setArc(adj[shortcuts[i].to], from[i], shortcuts[i].weight, v);
+        }
+        return up;
+    }
+
+private:
+    /// Dijkstra from @p source without @p skip, up to cost @p limit.
+    void witness(uint32_t source, uint32_t skip, uint64_t limit) {
+        if (++generation == 0) {
+            std::fill(seen.begin(), seen.end(), 0);
+            generation = 1;
+        }
+        heap.clear();
+        seen[source] = generation;
+        dist[source] = 0;
+        heap.emplace_back(0, source);
+        uint32_t settledNodes = 0;
+        while (!heap.empty() && settledNodes < WitnessSettleLimit) {
+            std::pop_heap(heap.begin(), heap.end(), later);
+            auto [d, u] = heap.back();
+            heap.pop_back();
+            if (d != dist[u])
+                continue;
+            if (d > limit)
+                break;
+            ++settledNodes;
+            for (const Arc &arc : adj[u]) {
+                if (arc.to == skip)
+                    continue;
+                uint64_t nd = d + arc.weight;
+                if (seen[arc.to] != generation || nd < dist[arc.to]) {
+                    seen[arc.to] = generation;
+                    dist[arc.to] = nd;
+                    heap.emplace_back(nd, arc.to);
+                    std::push_heap(heap.begin(), heap.end(), later);
+                }
+            }
+        }
+    }
+
+    std::vector<std::vector<Arc>> adj;
+    std::vector<int64_t> deleted; ///< Neighbours contracted so far.
+    std::vector<int64_t> level;   ///< Depth of the hierarchy below the node so far.
+    std::vector<uint64_t> dist;
+    std::vector<uint32_t> seen;
+    std::vector<HeapItem> heap;
+    uint32_t generation = 0;
+};
+
+} // namespace
+
+ContractionHierarchy ContractionHierarchy::build(const RouteGraphView &graph, RouteCost cost) {
+    ContractionHierarchy h;
+    h.model = cost;
+    uint32_t n = graph.nodeCount;
+    h.rank.assign(n, 0);
+    Contractor contractor(graph, cost);
+
+    // Lazy greedy order: priorities change as neighbours are contracted, so a node's
+    // is recomputed when it comes up and the node pushed back if it is no longer the least.
+    using Candidate = std::pair<int64_t, uint32_t>;
+    std::vector<Candidate> queue;
+    queue.reserve(n);
+    for (uint32_t v = 0; v < n; ++v)
+        queue.emplace_back(contractor.simulate(v), v);
+    const auto lower = std::greater<Candidate>{};
+    std::make_heap(queue.begin(), queue.end(), lower);
+
+    std::vector<std::vector<Arc>> up(n);
+    uint32_t order = 0;
+    while (!queue.empty()) {
+        std::pop_heap(queue.begin(), queue.end(), lower);
+        uint32_t v = queue.back().second;
+        queue.pop_back();
+        int64_t priority = contractor.simulate(v);
+        if (!queue.empty() && priority > queue.front().first) {
+            queue.emplace_back(priority, v);
+            std::push_heap(queue.begin(), queue.end(), lower);
+            continue;
+        }
+        h.rank[v] = order++;
+        up[v] = contractor.contract(v);
+    }
+
+    // Renumber by rank: a query climbs into the few top nodes, which then sit together.
+    h.node.resize(n);
+    for (uint32_t v = 0; v < n; ++v)
+        h.node[h.rank[v]] = v;
+    h.offsets.assign(n + 1, 0);
+    for (uint32_t r = 0; r < n; ++r)
+        h.offsets[r + 1] = h.offsets[r] + static_cast<uint32_t>(up[h.node[r]].size());
+    h.targets.reserve(h.offsets[n]);
+    h.weights.reserve(h.offsets[n]);
+    h.middles.reserve(h.offsets[n]);
+    for (uint32_t r = 0; r < n; ++r) {
+        for (const Arc &arc : up[h.node[r]]) {
+            h.targets.push_back(h.rank[arc.to]);
+            h.weights.push_back(arc.weight);
+            h.middles.push_back(arc.middle == NoMiddle ? NoMiddle : h.rank[arc.middle]);
+            h.shortcuts += arc.middle != NoMiddle;
+        }
+    }
+    return h;
+}
+
+size_t ContractionHierarchy::byteSize() const noexcept {
+    return (rank.size() + node.size() + offsets.size()) * sizeof(uint32_t) +
+           targets.size() * (sizeof(uint32_t) + sizeof(uint64_t) + sizeof(uint32_t));
+}
+
+uint32_t ContractionHierarchy::edgeBetween(uint32_t a, uint32_t b) const noexcept {
+    if (b < a)
+        std::swap(a, b);
+    for (uint32_t e = offsets[a]; e < offsets[a + 1]; ++e) {
+        if (targets[e] == b)
+            return e;
+    }
+    return NoParent;
+}
+
+void HierarchyFinder::prepare(uint32_t nodeCount) {
+    for (Side *side : {&forward, &backward}) {
+        if (side->labels.size() < nodeCount)
+            side->labels.resize(nodeCount);
+        side->heap.clear();
+    }
+    if (++generation == 0) {
+        for (Side *side : {&forward, &backward}) {
+            for (Label &label : side->labels)
+                label.seen = 0;
+        }
+        generation = 1;
+    }
+    settled = 0;
+}
+
+void HierarchyFinder::unpack(const ContractionHierarchy &h, uint32_t a, uint32_t b, std::vector<uint32_t> &out) {
+    pending.clear();
+    pending.emplace_back(a, b);
+    while (!pending.empty()) {
+        auto [x, y] = pending.back();
+        pending.pop_back();
+        uint32_t m = h.middles[h.edgeBetween(x, y)];
+        if (m == NoMiddle) {
+            out.push_back(h.node[y]);
+            continue;
+        }
+        pending.emplace_back(m, y);
+        pending.emplace_back(x, m);
+    }
+}
+
+std::optional<RoutePath> HierarchyFinder::search(const ContractionHierarchy &h,
+                                                 std::span<const uint32_t> from,
+                                                 std::span<const uint32_t> to) {
+    if (from.empty() || to.empty())
+        return std::nullopt;
+    prepare(h.nodeCount());
+    auto start = [this, &h](Side &side, std::span<const uint32_t> nodes) {
+        for (uint32_t node : nodes) {
+            uint32_t s = h.rank[node];
+            side.labels[s] = Label{0, NoParent, generation};
+            side.heap.emplace_back(0, s);
+        }
+        std::make_heap(side.heap.begin(), side.heap.end(), later);
+    };
+    start(forward, from);
+    start(backward, to);
+
+    uint64_t best = Infinite;
+    uint32_t meet = NoParent;
+    for (;;) {
+        uint64_t topForward = forward.heap.empty() ? Infinite : forward.heap.front().first;
+        uint64_t topBackward = backward.heap.empty() ? Infinite : backward.heap.front().first;
+        if (std::min(topForward, topBackward) >= best)
+            break;
+        Side &side = topForward <= topBackward ? forward : backward;
+        Side &other = &side == &forward ? backward : forward;
+        std::pop_heap(side.heap.begin(), side.heap.end(), later);
+        auto [d, u] = side.heap.back();
+        side.heap.pop_back();
+        if (d != side.labels[u].dist)
+            continue;
+        ++settled;
+        const Label &across = other.labels[u];
+        if (across.seen == generation && d + across.dist < best) {
+            best = d + across.dist;
+            meet = u;
+        }
+        // Stall on demand: edges are symmetric, so a higher neighbour already reached
+        // more cheaply proves this node is not on a shortest path from this side.
+        bool stalled = false;
+        for (uint32_t e = h.offsets[u]; e < h.offsets[u + 1] && !stalled; ++e) {
+            const Label &above = side.labels[h.targets[e]];
+            stalled = above.seen == generation && above.dist + h.weights[e] < d;
+        }
+        if (stalled)
+            continue;
+        for (uint32_t e = h.offsets[u]; e < h.offsets[u + 1]; ++e) {
+            uint32_t v = h.targets[e];
+            uint64_t nd = d + h.weights[e];
+            Label &label = side.labels[v];
+            if (label.seen != generation || nd < label.dist) {
+                label = Label{nd, u, generation};
+                side.heap.emplace_back(nd, v);
+                std::push_heap(side.heap.begin(), side.heap.end(), later);
+            }
+        }
+    }
+    if (meet == NoParent)
+        return std::nullopt;
+
+    RoutePath path;
+    std::vector<uint32_t> up;
+    for (uint32_t v = meet; v != NoParent; v = forward.labels[v].parent)
+        up.push_back(v);
+    path.nodes.push_back(h.node[up.back()]);
+    for (size_t i = up.size() - 1; i > 0; --i)
+        unpack(h, up[i], up[i - 1], path.nodes);
+    for (uint32_t v = meet; backward.labels[v].parent != NoParent; v = backward.labels[v].parent)
+        unpack(h, v, backward.labels[v].parent, path.nodes);
+    uint32_t high = static_cast<uint32_t>(best >> 32);
+    uint32_t low = static_cast<uint32_t>(best);
+    path.stopCount = h.model == RouteCost::FewestStops ? high : low;
+    path.transferCount = h.model == RouteCost::FewestStops ? low : high;
+    return path;
+}
+
+} // namespace mgm
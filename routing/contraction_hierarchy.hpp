@@ -0,0 +1,148 @@
+#ifndef CONTRACTION_HIERARCHY_HPP_
+#define CONTRACTION_HIERARCHY_HPP_
+
+#include "route_graph.hpp"
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+/**
+ * @file contraction_hierarchy.hpp
+ * @brief Contraction hierarchy over a routing graph for fast point-to-point queries.
+ */
+
+namespace mgm {
+
+/**
+ * @brief Preprocessed routing graph for one cost model.
+ *
+ * Nodes are contracted one at a time, least important first: a contracted node is
+ * taken out of the graph and, for every pair of its remaining neighbours whose
+ * cheapest connection ran through it, a shortcut edge of the same cost is added.
+ * The order is chosen greedily by edge difference, so the long chains of ordinary
+ * stations between interchanges go first and the interchanges end up on top.
+ *
+ * Every edge is then stored once, at its lower-ranked end, pointing upwards, with
+ * nodes renumbered by rank so that the top of the hierarchy is compact. A
+ * query searches upwards from both ends and meets at the highest node of the
+ * route; the shortcuts on it are unpacked back into graph edges. The costs are the
+ * lexicographic ones of RouteFinder, so both return routes of equal cost, though
+ * not always the same route among equally cheap ones.
+ *
+ * The hierarchy refers to nodes of the graph it was built from and must be rebuilt
+ * when the graph is.
+ */
+class ContractionHierarchy {
+public:
+    /**
+     * @brief Contracts a routing graph.
+     * @param graph The graph.
+     * @param cost The cost model the hierarchy answers.
+     * @return The hierarchy.
+     */
+    static ContractionHierarchy build(const RouteGraphView &graph, RouteCost cost);
+
+    /**
+     * @brief Gets the cost model of the hierarchy.
+     * @return The cost model it was built for.
+     */
+    RouteCost cost() const noexcept { return model; }
+
+    /**
+     * @brief Gets the number of nodes.
+     * @return The node count of the graph it was built from.
+     */
+    uint32_t nodeCount() const noexcept { return static_cast<uint32_t>(rank.size()); }
+
+    /**
+     * @brief Gets the number of upward edges, shortcuts included.
+     * @return The edge count.
+     */
+    uint32_t edgeCount() const noexcept { return static_cast<uint32_t>(targets.size()); }
+
+    /**
+     * @brief Gets the number of shortcut edges added by the contraction.
+     * @return The shortcut count.
+     */
+    uint32_t shortcutCount() const noexcept { return shortcuts; }
+
+    /**
+     * @brief Gets the memory taken by the hierarchy.
+     * @return The size of its arrays in bytes.
+     */
+    size_t byteSize() const noexcept;
+
+private:
+    friend class HierarchyFinder;
+
+    /// Finds the edge between two nodes given by rank.
+    uint32_t edgeBetween(uint32_t a, uint32_t b) const noexcept;
+
+    RouteCost model = RouteCost::FewestStops;
+    std::vector<uint32_t> rank;     ///< Node -> position in the contraction order.
+    std::vector<uint32_t> node;     ///< Rank -> node.
+    // The edge arrays number nodes by rank.
+    std::vector<uint32_t> offsets;  ///< CSR offsets of the upward edges.
+    std::vector<uint32_t> targets;  ///< Higher-ranked end of each edge.
+    std::vector<uint64_t> weights;  ///< Packed lexicographic cost of each edge.
+    std::vector<uint32_t> middles;  ///< Rank of the node a shortcut bypasses, or UINT32_MAX for a graph edge.
+    uint32_t shortcuts = 0;
+};
+
+/**
+ * @brief Reusable search state for queries on a ContractionHierarchy.
+ *
+ * Like RouteFinder, arrays are reset lazily through generation stamps, so a query
+ * only pays for the nodes it touches. One finder must not be used by several
+ * threads at once; the hierarchy itself can be shared freely.
+ */
+class HierarchyFinder {
+public:
+    /**
+     * @brief Finds the cheapest route from any of @p from to any of @p to.
+     * @param hierarchy The hierarchy to search.
+     * @param from Origin nodes.
+     * @param to Destination nodes.
+     * @return The route over graph nodes, or std::nullopt if no destination is reachable.
+     */
+    std::optional<RoutePath> search(const ContractionHierarchy &hierarchy,
+                                    std::span<const uint32_t> from,
+                                    std::span<const uint32_t> to);
+
+    /**
+     * @brief Gets the number of nodes settled by the last search, both directions together.
+     * @return The settled node count.
+     */
+    uint32_t settledCount() const noexcept { return settled; }
+
+private:
+    using HeapItem = std::pair<uint64_t, uint32_t>;
+
+    /// What one direction of the search knows about a node, kept together for locality.
+    struct Label {
+        uint64_t dist;
+        uint32_t parent; ///< Lower node the node was reached from.
+        uint32_t seen;   ///< Generation in which dist and parent were set.
+    };
+
+    /// One direction of the search; nodes are numbered by rank.
+    struct Side {
+        std::vector<Label> labels;
+        std::vector<HeapItem> heap;
+    };
+
+    void prepare(uint32_t nodeCount);
+    void unpack(const ContractionHierarchy &h, uint32_t a, uint32_t b, std::vector<uint32_t> &out);
+
+    Side forward;
+    Side backward;
+    std::vector<std::pair<uint32_t, uint32_t>> pending; ///< Edges still to unpack.
+    uint32_t generation = 0;
+    uint32_t settled = 0;
+};
+
+} // namespace mgm
+
+#endif
@@ -0,0 +1,149 @@
+#include "route_cache.hpp"
+#include <algorithm>
+
+namespace mgm {
+
+void RouteCache::unlink(uint32_t slot) noexcept {
+    Entry &e = entries[slot];
+    (e.prev == None ? head : entries[e.prev].next) = e.next;
+    (e.next == None ? tail : entries[e.next].prev) = e.prev;
+    e.prev = e.next = None;
+}
+
+void RouteCache::pushFront(uint32_t slot) noexcept {
+    Entry &e = entries[slot];
+    e.prev = None;
+    e.next = head;
+    (head == None ? tail : entries[head].prev) = slot;
+    head = slot;
+}
+
+void RouteCache::erase(uint32_t slot) {
+    unlink(slot);
+    Entry &e = entries[slot];
+    slots.erase(e.key);
+    e.route.reset();
+    e.lines.clear();
+    freeSlots.push_back(slot);
+}
+
+template<typename Pred>
+size_t RouteCache::eraseIf(Pred pred) {
+    size_t dropped = 0;
+    for (uint32_t slot = head; slot != None;) {
+        uint32_t next = entries[slot].next;
+        if (pred(entries[slot])) {
+            erase(slot);
+            ++dropped;
+        }
+        slot = next;
+    }
+    counters.invalidations += dropped;
+    return dropped;
+}
+
+const std::optional<Route> *RouteCache::find(const RouteKey &key) {
+    if (maxEntries == 0)
+        return nullptr;
+    auto it = slots.find(key);
+    if (it == slots.end()) {
+        ++counters.misses;
+        return nullptr;
+    }
+    ++counters.hits;
+    if (it->second != head) {
+        unlink(it->second);
+        pushFront(it->second);
+    }
+    return &entries[it->second].route;
+}
+
+void RouteCache::insert(const RouteKey &key, const std::optional<Route> &route) {
+    if (maxEntries == 0)
+        return;
+    std::vector<mgc::Symbol> lines;
+    if (route) {
+        for (const auto &stop : route->path)
+            lines.push_back(mgc::Symbol(stop.line));
+        std::sort(lines.begin(), lines.end(), [](mgc::Symbol a, mgc::Symbol b) { return a.id() < b.id(); });
+        lines.erase(std::unique(lines.begin(), lines.end()), lines.end());
+    }
+    auto [it, fresh] = slots.try_emplace(key, None);
+    if (!fresh) {
+        Entry &e = entries[it->second];
+        e.route = route;
+        e.lines = std::move(lines);
+        unlink(it->second);
+        pushFront(it->second);
+        return;
+    }
+    if (slots.size() > maxEntries) {
+        ++counters.evictions;
+        erase(tail);
+    }
+    uint32_t slot;
+    if (!freeSlots.empty()) {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        slot = static_cast<uint32_t>(entries.size());
+        entries.emplace_back();
+    }
+    Entry &e = entries[slot];
+    e.key = key;
+    e.route = route;
+    e.lines = std::move(lines);
+    it->second = slot;
+    pushFront(slot);
+}
+
+size_t RouteCache::invalidateLine(mgc::Symbol line) {
+    if (slots.empty())
+        return 0;
+    return eraseIf([line](const Entry &e) {
+        return std::find(e.lines.begin(), e.lines.end(), line) != e.lines.end();
+    });
+}
+
+size_t RouteCache::invalidateEndpoint(mgc::Symbol station) {
+    if (slots.empty())
+        return 0;
+    return eraseIf([station](const Entry &e) {
+        return e.key.fromStation == station || e.key.toStation == station;
+    });
+}
+
+size_t RouteCache::invalidateRemovedLine(mgc::Symbol line, std::vector<mgc::Symbol> stations) {
+    if (slots.empty())
+        return 0;
+    auto byId = [](mgc::Symbol a, mgc::Symbol b) { return a.id() < b.id(); };
+    std::sort(stations.begin(), stations.end(), byId);
+    auto onLine = [&](mgc::Symbol station) {
+        return std::binary_search(stations.begin(), stations.end(), station, byId);
+    };
+    return eraseIf([&](const Entry &e) {
+        if (e.key.anyLine)
+            return onLine(e.key.fromStation) || onLine(e.key.toStation) ||
+                   std::find(e.lines.begin(), e.lines.end(), line) != e.lines.end();
+        return e.key.fromLine == line || e.key.toLine == line ||
+               std::find(e.lines.begin(), e.lines.end(), line) != e.lines.end();
+    });
+}
+
+void RouteCache::clear() {
+    counters.invalidations += slots.size();
+    slots.clear();
+    entries.clear();
+    freeSlots.clear();
+    head = tail = None;
+}
+
+void RouteCache::setCapacity(size_t capacity) {
+    maxEntries = capacity;
+    while (slots.size() > maxEntries) {
+        ++counters.evictions;
+        erase(tail);
+    }
+}
+
+} // namespace mgm
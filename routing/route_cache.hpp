@@ -0,0 +1,171 @@
+#ifndef ROUTE_CACHE_HPP_
+#define ROUTE_CACHE_HPP_
+
+#include "route_graph.hpp"
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @file route_cache.hpp
+ * @brief Bounded least-recently-used cache of route query results.
+ */
+
+namespace mgm {
+
+/**
+ * @brief A route query by interned names.
+ *
+ * Queries between station names on any of their lines set @c anyLine and leave both
+ * line names empty.
+ */
+struct RouteKey {
+    mgc::Symbol fromLine;    ///< The line of the origin.
+    mgc::Symbol fromStation; ///< The origin station.
+    mgc::Symbol toLine;      ///< The line of the destination.
+    mgc::Symbol toStation;   ///< The destination station.
+    RouteCost cost = RouteCost::FewestStops; ///< The cost model.
+    bool anyLine = false;    ///< The stations may be on any of their lines.
+    bool operator==(const RouteKey &) const noexcept = default;
+};
+
+struct RouteKeyHash {
+    size_t operator()(const RouteKey &key) const noexcept {
+        uint64_t h = (uint64_t{key.fromLine.id()} << 32 | key.fromStation.id()) * 0x9E3779B97F4A7C15ull;
+        h ^= (uint64_t{key.toLine.id()} << 32 | key.toStation.id()) + (static_cast<uint64_t>(key.cost) << 1 | key.anyLine);
+        return static_cast<size_t>(h * 0xC2B2AE3D27D4EB4Full);
+    }
+};
+
+/**
+ * @brief Counters of a RouteCache, for sizing it.
+ */
+struct RouteCacheStats {
+    uint64_t hits = 0;          ///< Queries answered from the cache.
+    uint64_t misses = 0;        ///< Queries that had to search.
+    uint64_t evictions = 0;     ///< Entries dropped to make room for newer ones.
+    uint64_t invalidations = 0; ///< Entries dropped because the network changed.
+};
+
+/**
+ * @brief Route query results, least recently used first out.
+ *
+ * Each entry remembers the lines its route rides or transfers on, so that a change
+ * of one line drops only the routes through it. Unreachable results are cached too;
+ * they have no lines and go only with invalidateEndpoint(), invalidateRemovedLine()
+ * or clear(). Entries live
+ * in one array linked in use order, so the cache is copied like a value and a
+ * lookup does not allocate. A capacity of 0 disables the cache.
+ */
+class RouteCache {
+public:
+    /// Capacity of a default-constructed cache.
+    static constexpr size_t DefaultCapacity = 1024;
+
+    /**
+     * @brief Constructs an empty cache.
+     * @param capacity Maximum number of entries.
+     */
+    explicit RouteCache(size_t capacity = DefaultCapacity) : maxEntries(capacity) {}
+
+    /**
+     * @brief Looks a query up and marks it most recently used.
+     * @param key The query.
+     * @return The cached result, valid until the cache is next changed, or nullptr on a miss.
+     */
+    const std::optional<Route> *find(const RouteKey &key);
+
+    /**
+     * @brief Caches the result of a query, evicting the least recently used entry if full.
+     * @param key The query.
+     * @param route Its result.
+     */
+    void insert(const RouteKey &key, const std::optional<Route> &route);
+
+    /**
+     * @brief Drops the routes that ride or transfer on a line.
+     * @param line The name of the line.
+     * @return The number of entries dropped.
+     */
+    size_t invalidateLine(mgc::Symbol line);
+
+    /**
+     * @brief Drops the queries from or to a station name.
+     * @param station The name of the station.
+     * @return The number of entries dropped.
+     */
+    size_t invalidateEndpoint(mgc::Symbol station);
+
+    /**
+     * @brief Drops what a removed line can change: the routes on it, the queries naming
+     *        it, and the queries by name from or to one of its stations.
+     * @param line The name of the line.
+     * @param stations The names of its stations.
+     * @return The number of entries dropped.
+     */
+    size_t invalidateRemovedLine(mgc::Symbol line, std::vector<mgc::Symbol> stations);
+
+    /**
+     * @brief Drops every entry, counting them as invalidations.
+     */
+    void clear();
+
+    /**
+     * @brief Changes the capacity, evicting the least recently used entries over it.
+     * @param capacity Maximum number of entries; 0 disables the cache.
+     */
+    void setCapacity(size_t capacity);
+
+    /**
+     * @brief Gets the capacity.
+     * @return The maximum number of entries.
+     */
+    size_t capacity() const noexcept { return maxEntries; }
+
+    /**
+     * @brief Gets the number of cached entries.
+     * @return The entry count.
+     */
+    size_t size() const noexcept { return slots.size(); }
+
+    /**
+     * @brief Gets the counters accumulated since construction or resetStats().
+     * @return The counters.
+     */
+    const RouteCacheStats &stats() const noexcept { return counters; }
+
+    /**
+     * @brief Sets all counters to zero.
+     */
+    void resetStats() noexcept { counters = RouteCacheStats{}; }
+
+private:
+    static constexpr uint32_t None = UINT32_MAX;
+
+    struct Entry {
+        RouteKey key;
+        std::optional<Route> route;
+        std::vector<mgc::Symbol> lines; ///< Lines on the route, sorted.
+        uint32_t prev = None;           ///< More recently used neighbour.
+        uint32_t next = None;           ///< Less recently used neighbour.
+    };
+
+    void unlink(uint32_t slot) noexcept;
+    void pushFront(uint32_t slot) noexcept;
+    void erase(uint32_t slot);
+    template<typename Pred>
+    size_t eraseIf(Pred pred);
+
+    std::vector<Entry> entries;                                 ///< Entry storage; unused slots are on freeSlots.
+    std::vector<uint32_t> freeSlots;                            ///< Slots of dropped entries.
+    std::unordered_map<RouteKey, uint32_t, RouteKeyHash> slots; ///< Query -> slot.
+    uint32_t head = None;                                       ///< Most recently used slot.
+    uint32_t tail = None;                                       ///< Least recently used slot.
+    size_t maxEntries;
+    RouteCacheStats counters;
+};
+
+} // namespace mgm
+
+#endif
@@ -0,0 +1,226 @@
+#include "route_graph.hpp"
+#include "../Stations/transitionstation.hpp"
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+namespace mgm {
+
+namespace {
+
+constexpr uint32_t NoParent = std::numeric_limits<uint32_t>::max();
+constexpr uint64_t Primary = uint64_t{1} << 32;
+
+} // namespace
+
+void RouteFinder::prepare(uint32_t nodeCount) {
+    if (seen.size() < nodeCount) {
+        dist.resize(nodeCount);
+        parent.resize(nodeCount);
+        seen.resize(nodeCount, 0);
+        target.resize(nodeCount, 0);
+    }
+    if (++generation == 0) {
+        std::fill(seen.begin(), seen.end(), 0);
+        std::fill(target.begin(), target.end(), 0);
+        generation = 1;
+    }
+    heap.clear();
+}
+
+std::optional<RoutePath> RouteFinder::search(const RouteGraphView &graph,
+                                             std::span<const uint32_t> from,
+                                             std::span<const uint32_t> to,
+                                             RouteCost cost) {
+    if (from.empty() || to.empty())
+        return std::nullopt;
+    prepare(graph.nodeCount);
+    // Lexicographic cost packed in one integer: the minimised quantity in the
+    // upper half, the tie-breaker in the lower half.
+    const uint64_t rideWeight = cost == RouteCost::FewestStops ? Primary : 1;
+    const uint64_t transferWeight = cost == RouteCost::FewestStops ? 1 : Primary;
+    const auto later = std::greater<std::pair<uint64_t, uint32_t>>{};
+
+    for (uint32_t t : to)
+        target[t] = generation;
+    for (uint32_t s : from) {
+        seen[s] = generation;
+        dist[s] = 0;
+        parent[s] = NoParent;
+        heap.emplace_back(0, s);
+    }
+    std::make_heap(heap.begin(), heap.end(), later);
+
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), later);
+        auto [d, u] = heap.back();
+        heap.pop_back();
+        if (d != dist[u])
+            continue;
+        if (target[u] == generation) {
+            RoutePath path;
+            for (uint32_t v = u; v != NoParent; v = parent[v])
+                path.nodes.push_back(v);
+            std::reverse(path.nodes.begin(), path.nodes.end());
+            uint32_t high = static_cast<uint32_t>(d >> 32);
+            uint32_t low = static_cast<uint32_t>(d);
+            path.stopCount = cost == RouteCost::FewestStops ? high : low;
+            path.transferCount = cost == RouteCost::FewestStops ? low : high;
+            return path;
+        }
+        for (uint32_t e = graph.offsets[u]; e < graph.offsets[u + 1]; ++e) {
+            uint32_t v = graph.targets[e];
+            uint64_t nd = d + (graph.kinds[e] == static_cast<uint8_t>(EdgeKind::Ride) ? rideWeight : transferWeight);
+            if (seen[v] != generation || nd < dist[v]) {
+                seen[v] = generation;
+                dist[v] = nd;
+                parent[v] = u;
+                heap.emplace_back(nd, v);
+                std::push_heap(heap.begin(), heap.end(), later);
+            }
+        }
+    }
+    return std::nullopt;
+}
+
+RouteGraph RouteGraph::build(const std::vector<const Line *> &lines) {
+    RouteGraph g;
+    size_t total = 0;
+    for (const Line *line : lines)
+        total += line->getStations().size();
+
+    g.lineNames.reserve(lines.size());
+    g.lineFirst.reserve(lines.size() + 1);
+    g.nodeLine.reserve(total);
+    g.nodeStation.reserve(total);
+    g.lineIds.reserve(lines.size());
+    g.stationIds.reserve(total);
+    for (uint32_t li = 0; li < lines.size(); ++li) {
+        g.lineNames.push_back(lines[li]->getNameSymbol());
+        g.lineIds.emplace(g.lineNames.back(), li);
+        g.lineFirst.push_back(static_cast<uint32_t>(g.nodeLine.size()));
+        for (mgc::Symbol stationName : lines[li]->getNameColumn()) {
+            auto [it, inserted] = g.stationIds.try_emplace(stationName,
+                                                            static_cast<uint32_t>(g.stationNames.size()));
+            if (inserted)
+                g.stationNames.push_back(stationName);
+            g.nodeLine.push_back(li);
+            g.nodeStation.push_back(it->second);
+        }
+    }
+    g.lineFirst.push_back(static_cast<uint32_t>(total));
+
+    // Group nodes by station name (counting sort).
+    g.nameOffsets.assign(g.stationNames.size() + 1, 0);
+    for (uint32_t id : g.nodeStation)
+        ++g.nameOffsets[id + 1];
+    for (size_t i = 1; i < g.nameOffsets.size(); ++i)
+        g.nameOffsets[i] += g.nameOffsets[i - 1];
+    g.nameNodes.resize(total);
+    {
+        std::vector<uint32_t> cursor(g.nameOffsets.begin(), g.nameOffsets.end() - 1);
+        for (uint32_t u = 0; u < total; ++u)
+            g.nameNodes[cursor[g.nodeStation[u]]++] = u;
+    }
+
+    // Resolve transfer connections to node pairs.
+    std::vector<std::pair<uint32_t, uint32_t>> transfers;
+    for (uint32_t li = 0; li < lines.size(); ++li) {
+        const auto &table = lines[li]->getStations();
+        auto kinds = lines[li]->getKindColumn();
+        for (size_t slot = 0; slot < kinds.size(); ++slot) {
+            if (kinds[slot] != StationKind::Transition)
+                continue;
+            auto *ts = dynamic_cast<const transition_station *>(table[slot].second.get());
+            if (!ts)
+                continue;
+            for (const auto &conn : ts->get_station_list()) {
+                auto lineIt = g.lineIds.find(conn.second);
+                if (lineIt == g.lineIds.end())
+                    continue;
+                const auto &targetTable = lines[lineIt->second]->getStations();
+                size_t targetSlot = targetTable.find(conn.first);
+                if (targetSlot == targetTable.size())
+                    continue;
+                transfers.emplace_back(g.lineFirst[li] + static_cast<uint32_t>(slot),
+                                       g.lineFirst[lineIt->second] + static_cast<uint32_t>(targetSlot));
+            }
+        }
+    }
+
+    // Degrees, then CSR fill: ride edges first, transfer edges after them.
+    g.offsets.assign(total + 1, 0);
+    for (uint32_t li = 0; li < lines.size(); ++li) {
+        uint32_t first = g.lineFirst[li], last = g.lineFirst[li + 1];
+        for (uint32_t u = first; u < last; ++u)
+            g.offsets[u + 1] += (u > first) + (u + 1 < last);
+    }
+    for (auto [u, v] : transfers) {
+        ++g.offsets[u + 1];
+        ++g.offsets[v + 1];
+    }
+    for (size_t i = 1; i < g.offsets.size(); ++i)
+        g.offsets[i] += g.offsets[i - 1];
+    g.targets.resize(g.offsets.back());
+    g.kinds.resize(g.offsets.back());
+    std::vector<uint32_t> cursor(g.offsets.begin(), g.offsets.end() - 1);
+    auto addEdge = [&g, &cursor](uint32_t u, uint32_t v, EdgeKind kind) {
+        g.targets[cursor[u]] = v;
+        g.kinds[cursor[u]++] = static_cast<uint8_t>(kind);
+    };
+    for (uint32_t li = 0; li < lines.size(); ++li) {
+        uint32_t first = g.lineFirst[li], last = g.lineFirst[li + 1];
+        for (uint32_t u = first; u < last; ++u) {
+            if (u > first)
+                addEdge(u, u - 1, EdgeKind::Ride);
+            if (u + 1 < last)
+                addEdge(u, u + 1, EdgeKind::Ride);
+        }
+    }
+    for (auto [u, v] : transfers) {
+        addEdge(u, v, EdgeKind::Transfer);
+        addEdge(v, u, EdgeKind::Transfer);
+    }
+    return g;
+}
+
+RouteGraphView RouteGraph::view() const noexcept {
+    return RouteGraphView{nodeCount(), offsets.data(), targets.data(), kinds.data()};
+}
+
+std::optional<uint32_t> RouteGraph::node(std::string_view lineName, std::string_view stationName) const {
+    auto lineKey = mgc::Symbol::find(lineName);
+    if (!lineKey)
+        return std::nullopt;
+    auto lineIt = lineIds.find(*lineKey);
+    if (lineIt == lineIds.end())
+        return std::nullopt;
+    for (uint32_t u : nodesNamed(stationName)) {
+        if (nodeLine[u] == lineIt->second)
+            return u;
+    }
+    return std::nullopt;
+}
+
+std::span<const uint32_t> RouteGraph::nodesNamed(std::string_view stationName) const {
+    auto key = mgc::Symbol::find(stationName);
+    if (!key)
+        return {};
+    auto it = stationIds.find(*key);
+    if (it == stationIds.end())
+        return {};
+    return std::span<const uint32_t>(nameNodes.data() + nameOffsets[it->second],
+                                     nameOffsets[it->second + 1] - nameOffsets[it->second]);
+}
+
+Route RouteGraph::toRoute(const RoutePath &path) const {
+    Route route;
+    route.path.reserve(path.nodes.size());
+    for (uint32_t u : path.nodes)
+        route.path.push_back(RouteStop{lineName(u), stationName(u)});
+    route.stopCount = path.stopCount;
+    route.transferCount = path.transferCount;
+    return route;
+}
+
+} // namespace mgm
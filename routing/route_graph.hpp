@@ -0,0 +1,202 @@
+#ifndef ROUTE_GRAPH_HPP_
+#define ROUTE_GRAPH_HPP_
+
+#include "../line/metro_line.hpp"
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @file route_graph.hpp
+ * @brief Compact routing graph over the lines of a metro system.
+ */
+
+namespace mgm {
+
+/**
+ * @brief Cost model of a route query.
+ *
+ * Both models are lexicographic: the named quantity is minimised first and the
+ * other one breaks ties.
+ */
+enum class RouteCost : uint8_t {
+    FewestStops,     ///< Minimise stations ridden through, then transfers.
+    FewestTransfers  ///< Minimise transfers between lines, then stations ridden.
+};
+
+/**
+ * @brief Kind of an edge of the routing graph.
+ */
+enum class EdgeKind : uint8_t {
+    Ride,     ///< Between neighbouring stations of one line.
+    Transfer  ///< Between the two ends of a transfer_hub connection.
+};
+
+/**
+ * @brief Non-owning CSR view of a routing graph.
+ *
+ * Node @c u has the outgoing edges @c targets[offsets[u]] .. @c targets[offsets[u+1]-1],
+ * and @c kinds holds the EdgeKind of each of them. The arrays can live in a
+ * RouteGraph or anywhere else with the same layout.
+ */
+struct RouteGraphView {
+    uint32_t nodeCount = 0;            ///< Number of nodes.
+    const uint32_t *offsets = nullptr; ///< nodeCount + 1 edge offsets.
+    const uint32_t *targets = nullptr; ///< Target node of each edge.
+    const uint8_t *kinds = nullptr;    ///< EdgeKind of each edge.
+};
+
+/**
+ * @brief A route as a sequence of graph nodes.
+ */
+struct RoutePath {
+    std::vector<uint32_t> nodes; ///< Visited nodes, from origin to destination.
+    uint32_t stopCount = 0;      ///< Number of ride edges on the route.
+    uint32_t transferCount = 0;  ///< Number of transfer edges on the route.
+};
+
+/**
+ * @brief A stop of a route: a station on a line.
+ */
+struct RouteStop {
+    string line;    ///< The name of the line.
+    string station; ///< The name of the station.
+};
+
+/**
+ * @brief A route between two stations, by name.
+ */
+struct Route {
+    std::vector<RouteStop> path; ///< Visited stops, from origin to destination.
+    uint32_t stopCount = 0;      ///< Number of stations ridden to along a line.
+    uint32_t transferCount = 0;  ///< Number of transfers between lines.
+};
+
+/**
+ * @brief Reusable search state for route queries.
+ *
+ * Holds the distance, parent and heap arrays of the search so that repeated
+ * queries do not allocate. Arrays are reset lazily through generation stamps,
+ * so a query only pays for the nodes it touches. One finder must not be used
+ * by several threads at once; the graph itself can be shared freely.
+ */
+class RouteFinder {
+public:
+    /**
+     * @brief Finds the cheapest route from any of @p from to any of @p to.
+     * @param graph The graph to search.
+     * @param from Origin nodes.
+     * @param to Destination nodes.
+     * @param cost The cost model.
+     * @return The route, or std::nullopt if no destination is reachable.
+     */
+    std::optional<RoutePath> search(const RouteGraphView &graph,
+                                    std::span<const uint32_t> from,
+                                    std::span<const uint32_t> to,
+                                    RouteCost cost);
+
+private:
+    void prepare(uint32_t nodeCount);
+
+    std::vector<uint64_t> dist;
+    std::vector<uint32_t> parent;
+    std::vector<uint32_t> seen;     ///< Generation in which dist/parent were set.
+    std::vector<uint32_t> target;   ///< Generation in which the node was a destination.
+    std::vector<std::pair<uint64_t, uint32_t>> heap;
+    uint32_t generation = 0;
+};
+
+/**
+ * @brief Routing graph built from the station order of lines and their transfer hubs.
+ *
+ * Every station of every line becomes a node with an integer ID; nodes of one
+ * line are numbered consecutively in station order. Neighbouring stations of a
+ * line are joined by ride edges, and every connection stored in the transfer_hub
+ * of a transition station that names an existing station adds a transfer edge
+ * in both directions. Adjacency is kept in CSR arrays.
+ */
+class RouteGraph {
+public:
+    /**
+     * @brief Builds the graph for the given lines.
+     * @param lines The lines of the network.
+     * @return The routing graph.
+     */
+    static RouteGraph build(const std::vector<const Line *> &lines);
+
+    /**
+     * @brief Gets a CSR view of the graph.
+     * @return The view, valid as long as the graph is alive and unchanged.
+     */
+    RouteGraphView view() const noexcept;
+
+    /**
+     * @brief Gets the number of nodes (station occurrences on lines).
+     * @return The node count.
+     */
+    uint32_t nodeCount() const noexcept { return static_cast<uint32_t>(nodeLine.size()); }
+
+    /**
+     * @brief Gets the number of directed edges.
+     * @return The edge count.
+     */
+    uint32_t edgeCount() const noexcept { return static_cast<uint32_t>(targets.size()); }
+
+    /**
+     * @brief Finds the node of a station on a line.
+     * @param lineName The name of the line.
+     * @param stationName The name of the station.
+     * @return The node ID, or std::nullopt if the line or station is unknown.
+     */
+    std::optional<uint32_t> node(std::string_view lineName, std::string_view stationName) const;
+
+    /**
+     * @brief Gets all nodes of a station name, one per line it is on.
+     * @param stationName The name of the station.
+     * @return The node IDs; empty if the name is unknown.
+     */
+    std::span<const uint32_t> nodesNamed(std::string_view stationName) const;
+
+    /**
+     * @brief Gets the name of the line a node belongs to.
+     * @param node The node ID.
+     * @return The line name.
+     */
+    const string &lineName(uint32_t node) const { return lineNames[nodeLine[node]].str(); }
+
+    /**
+     * @brief Gets the station name of a node.
+     * @param node The node ID.
+     * @return The station name.
+     */
+    const string &stationName(uint32_t node) const { return stationNames[nodeStation[node]].str(); }
+
+    /**
+     * @brief Resolves the nodes of a path to line and station names.
+     * @param path A path found on this graph.
+     * @return The route by name.
+     */
+    Route toRoute(const RoutePath &path) const;
+
+private:
+    std::vector<mgc::Symbol> lineNames;      ///< Line ID -> name.
+    std::vector<mgc::Symbol> stationNames;   ///< Station name ID -> name.
+    std::vector<uint32_t> lineFirst;         ///< Line ID -> first node, plus one past the last.
+    std::vector<uint32_t> nodeLine;          ///< Node -> line ID.
+    std::vector<uint32_t> nodeStation;       ///< Node -> station name ID.
+    std::vector<uint32_t> nameOffsets;       ///< Station name ID -> range in nameNodes.
+    std::vector<uint32_t> nameNodes;         ///< Nodes grouped by station name ID.
+    std::vector<uint32_t> offsets;           ///< CSR edge offsets.
+    std::vector<uint32_t> targets;           ///< CSR edge targets.
+    std::vector<uint8_t> kinds;              ///< CSR edge kinds.
+    std::unordered_map<mgc::Symbol, uint32_t> lineIds;    ///< Line name -> line ID.
+    std::unordered_map<mgc::Symbol, uint32_t> stationIds; ///< Station name -> station name ID.
+};
+
+} // namespace mgm
+
+#endif
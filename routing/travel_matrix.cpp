@@ -0,0 +1,274 @@
+#include "travel_matrix.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <exception>
+#include <fcntl.h>
+#include <numeric>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace mgm {
+
+namespace {
+
+constexpr char TravelMatrixMagic[8] = {'M', 'G', 'M', 'T', 'M', 'A', 'T', '\0'};
+
+static_assert(sizeof(TravelMatrixHeader) == 64, "travel matrix header layout changed");
+
+/// Rows a worker takes at a time.
+constexpr uint32_t RowBlock = 32;
+
+constexpr uint64_t align8(uint64_t offset) { return (offset + 7) & ~uint64_t{7}; }
+
+TravelMatrixHeader layout(uint32_t rows, uint32_t cols) {
+    TravelMatrixHeader h{};
+    std::memcpy(h.magic, TravelMatrixMagic, sizeof h.magic);
+    h.version = TravelMatrixVersion;
+    h.rows = rows;
+    h.cols = cols;
+    uint64_t cells = uint64_t{rows} * cols;
+    h.sources = sizeof(TravelMatrixHeader);
+    h.targets = align8(h.sources + uint64_t{rows} * sizeof(uint32_t));
+    h.hops = align8(h.targets + uint64_t{cols} * sizeof(uint32_t));
+    h.transfers = align8(h.hops + cells * sizeof(uint16_t));
+    h.fileSize = align8(h.transfers + cells * sizeof(uint16_t));
+    return h;
+}
+
+void checkNodes(const RouteGraphView &graph, std::span<const uint32_t> nodes) {
+    for (uint32_t node : nodes) {
+        if (node >= graph.nodeCount)
+            throw std::invalid_argument("Error: Node out of range.");
+    }
+}
+
+/// Breadth-first search state of one worker, reset lazily through generation stamps.
+class Searcher {
+public:
+    Searcher(const RouteGraphView &graph, const std::vector<uint8_t> &isTarget, uint32_t targetCount)
+        : graph(graph), isTarget(isTarget), targetCount(targetCount),
+          seen(graph.nodeCount, 0), dist(graph.nodeCount), transfers(graph.nodeCount) {
+        queue.reserve(graph.nodeCount);
+    }
+
+    /// Searches from @p source and writes its rows.
+    void run(uint32_t source, std::span<const uint32_t> targets, uint16_t *hopRow, uint16_t *transferRow) {
+        if (targets.empty())
+            return;
+        if (++generation == 0) {
+            std::fill(seen.begin(), seen.end(), 0);
+            generation = 1;
+        }
+        queue.clear();
+        queue.push_back(source);
+        seen[source] = generation;
+        dist[source] = 0;
+        transfers[source] = 0;
+        uint32_t remaining = targetCount;
+        // All nodes of one distance leave the queue before any of the next, so a node's
+        // transfer count is final once it is dequeued.
+        for (size_t head = 0; head < queue.size(); ++head) {
+            uint32_t u = queue[head];
+            if (isTarget[u] && --remaining == 0)
+                break;
+            uint16_t next = dist[u] == Unreached - 1 ? dist[u] : static_cast<uint16_t>(dist[u] + 1);
+            for (uint32_t e = graph.offsets[u]; e < graph.offsets[u + 1]; ++e) {
+                uint32_t v = graph.targets[e];
+                bool transfer = graph.kinds[e] == static_cast<uint8_t>(EdgeKind::Transfer);
+                auto t = static_cast<uint16_t>(std::min<uint32_t>(transfers[u] + transfer, Unreached - 1));
+                if (seen[v] != generation) {
+                    seen[v] = generation;
+                    dist[v] = next;
+                    transfers[v] = t;
+                    queue.push_back(v);
+                } else if (dist[v] == next && t < transfers[v]) {
+                    transfers[v] = t;
+                }
+            }
+        }
+        for (size_t col = 0; col < targets.size(); ++col) {
+            uint32_t v = targets[col];
+            bool reached = seen[v] == generation;
+            hopRow[col] = reached ? dist[v] : TravelMatrix::Unreachable;
+            transferRow[col] = reached ? transfers[v] : TravelMatrix::Unreachable;
+        }
+    }
+
+private:
+    static constexpr uint16_t Unreached = TravelMatrix::Unreachable;
+
+    const RouteGraphView &graph;
+    const std::vector<uint8_t> &isTarget;
+    uint32_t targetCount;
+    std::vector<uint32_t> seen;
+    std::vector<uint16_t> dist;
+    std::vector<uint16_t> transfers;
+    std::vector<uint32_t> queue;
+    uint32_t generation = 0;
+};
+
+/// Fills the sections of a matrix laid out at @p base.
+void fill(const RouteGraphView &graph, std::span<const uint32_t> sources, std::span<const uint32_t> targets,
+          char *base, unsigned threads) {
+    const TravelMatrixHeader &h = *reinterpret_cast<const TravelMatrixHeader *>(base);
+    std::copy(sources.begin(), sources.end(), reinterpret_cast<uint32_t *>(base + h.sources));
+    std::copy(targets.begin(), targets.end(), reinterpret_cast<uint32_t *>(base + h.targets));
+    auto *hops = reinterpret_cast<uint16_t *>(base + h.hops);
+    auto *transferCounts = reinterpret_cast<uint16_t *>(base + h.transfers);
+
+    std::vector<uint8_t> isTarget(graph.nodeCount, 0);
+    uint32_t targetCount = 0;
+    for (uint32_t node : targets) {
+        if (!isTarget[node]) {
+            isTarget[node] = 1;
+            ++targetCount;
+        }
+    }
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    uint32_t blocks = (h.rows + RowBlock - 1) / RowBlock;
+    threads = std::max(1u, std::min(threads, blocks));
+    std::atomic<uint32_t> nextBlock{0};
+    std::vector<std::exception_ptr> errors(threads);
+    auto worker = [&](unsigned id) {
+        try {
+            Searcher searcher(graph, isTarget, targetCount);
+            for (uint32_t block; (block = nextBlock.fetch_add(1, std::memory_order_relaxed)) < blocks;) {
+                uint32_t end = std::min(h.rows, (block + 1) * RowBlock);
+                for (uint32_t row = block * RowBlock; row < end; ++row) {
+                    size_t at = size_t{row} * h.cols;
+                    searcher.run(sources[row], targets, hops + at, transferCounts + at);
+                }
+            }
+        } catch (...) {
+            errors[id] = std::current_exception();
+        }
+    };
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (unsigned id = 1; id < threads; ++id)
+        pool.emplace_back(worker, id);
+    worker(0);
+    for (auto &thread : pool)
+        thread.join();
+    for (const auto &error : errors) {
+        if (error)
+            std::rethrow_exception(error);
+    }
+}
+
+} // namespace
+
+TravelMatrix TravelMatrix::compute(const RouteGraphView &graph, std::span<const uint32_t> sources,
+                                   std::span<const uint32_t> targets, unsigned threads) {
+    checkNodes(graph, sources);
+    checkNodes(graph, targets);
+    TravelMatrixHeader h = layout(static_cast<uint32_t>(sources.size()), static_cast<uint32_t>(targets.size()));
+    TravelMatrix matrix;
+    matrix.owned = std::make_unique_for_overwrite<uint64_t[]>(h.fileSize / sizeof(uint64_t));
+    matrix.base = reinterpret_cast<char *>(matrix.owned.get());
+    matrix.size = h.fileSize;
+    std::memcpy(matrix.base, &h, sizeof h);
+    fill(graph, sources, targets, matrix.base, threads);
+    return matrix;
+}
+
+TravelMatrix TravelMatrix::computeAll(const RouteGraphView &graph, unsigned threads) {
+    std::vector<uint32_t> nodes(graph.nodeCount);
+    std::iota(nodes.begin(), nodes.end(), 0u);
+    return compute(graph, nodes, nodes, threads);
+}
+
+TravelMatrix TravelMatrix::computeToFile(const RouteGraphView &graph, std::span<const uint32_t> sources,
+                                         std::span<const uint32_t> targets, const string &path,
+                                         unsigned threads) {
+    checkNodes(graph, sources);
+    checkNodes(graph, targets);
+    TravelMatrixHeader h = layout(static_cast<uint32_t>(sources.size()), static_cast<uint32_t>(targets.size()));
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+        throw std::invalid_argument("Error: Cannot write travel matrix file " + path + ".");
+    if (::ftruncate(fd, static_cast<off_t>(h.fileSize)) != 0) {
+        ::close(fd);
+        throw std::invalid_argument("Error: Cannot write travel matrix file " + path + ".");
+    }
+    void *mapping = ::mmap(nullptr, h.fileSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+        throw std::invalid_argument("Error: Cannot map travel matrix file " + path + ".");
+    TravelMatrix matrix;
+    matrix.base = static_cast<char *>(mapping);
+    matrix.size = h.fileSize;
+    matrix.mapped = true;
+    std::memcpy(matrix.base, &h, sizeof h);
+    fill(graph, sources, targets, matrix.base, threads);
+    return matrix;
+}
+
+TravelMatrix TravelMatrix::open(const string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        throw std::invalid_argument("Error: Cannot open travel matrix file " + path + ".");
+    struct stat info {};
+    if (::fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(TravelMatrixHeader))) {
+        ::close(fd);
+        throw std::invalid_argument("Error: Not a travel matrix file: " + path + ".");
+    }
+    size_t fileSize = static_cast<size_t>(info.st_size);
+    void *mapping = ::mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+        throw std::invalid_argument("Error: Cannot map travel matrix file " + path + ".");
+    TravelMatrix matrix;
+    matrix.base = static_cast<char *>(mapping);
+    matrix.size = fileSize;
+    matrix.mapped = true;
+    const TravelMatrixHeader &h = matrix.header();
+    if (std::memcmp(h.magic, TravelMatrixMagic, sizeof h.magic) != 0)
+        throw std::invalid_argument("Error: Not a travel matrix file: " + path + ".");
+    if (h.version != TravelMatrixVersion)
+        throw std::invalid_argument("Error: Unsupported travel matrix version " + std::to_string(h.version) + ".");
+    TravelMatrixHeader expected = layout(h.rows, h.cols);
+    if (h.fileSize != fileSize || std::memcmp(&h, &expected, sizeof h) != 0)
+        throw std::invalid_argument("Error: Truncated travel matrix file.");
+    return matrix;
+}
+
+TravelMatrix::~TravelMatrix() { release(); }
+
+TravelMatrix::TravelMatrix(TravelMatrix &&other) noexcept
+    : base(other.base), size(other.size), mapped(other.mapped), owned(std::move(other.owned)) {
+    other.base = nullptr;
+    other.size = 0;
+    other.mapped = false;
+}
+
+TravelMatrix &TravelMatrix::operator=(TravelMatrix &&other) noexcept {
+    if (this != &other) {
+        release();
+        base = other.base;
+        size = other.size;
+        mapped = other.mapped;
+        owned = std::move(other.owned);
+        other.base = nullptr;
+        other.size = 0;
+        other.mapped = false;
+    }
+    return *this;
+}
+
+void TravelMatrix::release() noexcept {
+    if (mapped && base)
+        ::munmap(base, size);
+    owned.reset();
+    base = nullptr;
+    size = 0;
+    mapped = false;
+}
+
+} // namespace mgm
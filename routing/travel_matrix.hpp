@@ -0,0 +1,186 @@
+#ifndef TRAVEL_MATRIX_HPP_
+#define TRAVEL_MATRIX_HPP_
+
+#include "route_graph.hpp"
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+
+/**
+ * @file travel_matrix.hpp
+ * @brief Many-to-many hop and transfer count matrices over a routing graph.
+ *
+ * File layout (native byte order, every section 8-byte aligned):
+ * - TravelMatrixHeader: magic, version, dimensions and section offsets;
+ * - the source and target node IDs;
+ * - the hop counts, then the transfer counts, each row-major with one row per source.
+ */
+
+namespace mgm {
+
+/**
+ * @brief Fixed-size header at the start of a travel matrix, in memory and on disk.
+ */
+struct TravelMatrixHeader {
+    char magic[8];      ///< "MGMTMAT" followed by a zero byte.
+    uint32_t version;   ///< Format version, TravelMatrixVersion.
+    uint32_t rows;      ///< Number of sources.
+    uint32_t cols;      ///< Number of targets.
+    uint32_t reserved;  ///< Zero.
+    uint64_t sources;   ///< uint32_t[rows].
+    uint64_t targets;   ///< uint32_t[cols].
+    uint64_t hops;      ///< uint16_t[rows * cols].
+    uint64_t transfers; ///< uint16_t[rows * cols].
+    uint64_t fileSize;  ///< Total size in bytes.
+};
+
+/// Current travel matrix format version.
+inline constexpr uint32_t TravelMatrixVersion = 1;
+
+/**
+ * @brief Hop and transfer counts from a set of source nodes to a set of target nodes.
+ *
+ * The hop count of a pair is the number of edges, rides and transfers alike, on a
+ * shortest path of the routing graph; the transfer count is the smallest number of
+ * transfer edges among those shortest paths. Both come from one breadth-first search
+ * per source: the sources are split into blocks of rows that worker threads take in
+ * turn, and each search stops once every target has been reached.
+ *
+ * The matrix lives either in memory or in a file mapped into memory, with the same
+ * layout. It is movable but not copyable.
+ */
+class TravelMatrix {
+public:
+    /// Entry of a pair whose target cannot be reached; larger counts saturate below it.
+    static constexpr uint16_t Unreachable = 0xFFFF;
+
+    /**
+     * @brief Computes the matrix in memory.
+     * @param graph The routing graph.
+     * @param sources Source nodes, one row each.
+     * @param targets Target nodes, one column each.
+     * @param threads Number of threads, counting the calling one; 0 uses std::thread::hardware_concurrency().
+     * @return The matrix.
+     * @throws std::invalid_argument if a node is not in the graph.
+     */
+    static TravelMatrix compute(const RouteGraphView &graph, std::span<const uint32_t> sources,
+                                std::span<const uint32_t> targets, unsigned threads = 0);
+
+    /**
+     * @brief Computes the matrix between all nodes of a graph in memory.
+     * @param graph The routing graph.
+     * @param threads Number of threads; 0 uses std::thread::hardware_concurrency().
+     * @return The matrix; row and column @c i belong to node @c i.
+     */
+    static TravelMatrix computeAll(const RouteGraphView &graph, unsigned threads = 0);
+
+    /**
+     * @brief Computes the matrix straight into a file mapped into memory.
+     *
+     * The rows are written through a shared mapping of the file, so the matrix is
+     * never held in anonymous memory and can be larger than RAM.
+     *
+     * @param graph The routing graph.
+     * @param sources Source nodes, one row each.
+     * @param targets Target nodes, one column each.
+     * @param path Path of the file to create or overwrite.
+     * @param threads Number of threads; 0 uses std::thread::hardware_concurrency().
+     * @return The matrix, backed by the file.
+     * @throws std::invalid_argument if a node is not in the graph or the file cannot be written.
+     */
+    static TravelMatrix computeToFile(const RouteGraphView &graph, std::span<const uint32_t> sources,
+                                      std::span<const uint32_t> targets, const string &path,
+                                      unsigned threads = 0);
+
+    /**
+     * @brief Maps a matrix file written by computeToFile().
+     * @param path Path of the file.
+     * @return The matrix, backed by the file.
+     * @throws std::invalid_argument if the file cannot be mapped or is not a valid matrix.
+     */
+    static TravelMatrix open(const string &path);
+
+    ~TravelMatrix();
+    TravelMatrix(TravelMatrix &&other) noexcept;
+    TravelMatrix &operator=(TravelMatrix &&other) noexcept;
+    TravelMatrix(const TravelMatrix &) = delete;
+    TravelMatrix &operator=(const TravelMatrix &) = delete;
+
+    /**
+     * @brief Gets the number of rows.
+     * @return The number of sources.
+     */
+    uint32_t rows() const noexcept { return header().rows; }
+
+    /**
+     * @brief Gets the number of columns.
+     * @return The number of targets.
+     */
+    uint32_t cols() const noexcept { return header().cols; }
+
+    /**
+     * @brief Gets the source node of a row.
+     * @param row The row.
+     * @return The node ID.
+     */
+    uint32_t source(uint32_t row) const noexcept { return section<uint32_t>(header().sources)[row]; }
+
+    /**
+     * @brief Gets the target node of a column.
+     * @param col The column.
+     * @return The node ID.
+     */
+    uint32_t target(uint32_t col) const noexcept { return section<uint32_t>(header().targets)[col]; }
+
+    /**
+     * @brief Gets the hop count of a pair.
+     * @param row The row of the source.
+     * @param col The column of the target.
+     * @return The number of edges on a shortest path, or Unreachable.
+     */
+    uint16_t hops(uint32_t row, uint32_t col) const noexcept { return hopRow(row)[col]; }
+
+    /**
+     * @brief Gets the transfer count of a pair.
+     * @param row The row of the source.
+     * @param col The column of the target.
+     * @return The fewest transfers on a shortest path, or Unreachable.
+     */
+    uint16_t transfers(uint32_t row, uint32_t col) const noexcept { return transferRow(row)[col]; }
+
+    /**
+     * @brief Gets the hop counts of a row.
+     * @param row The row.
+     * @return One entry per column.
+     */
+    std::span<const uint16_t> hopRow(uint32_t row) const noexcept {
+        return {section<uint16_t>(header().hops) + size_t{row} * cols(), cols()};
+    }
+
+    /**
+     * @brief Gets the transfer counts of a row.
+     * @param row The row.
+     * @return One entry per column.
+     */
+    std::span<const uint16_t> transferRow(uint32_t row) const noexcept {
+        return {section<uint16_t>(header().transfers) + size_t{row} * cols(), cols()};
+    }
+
+private:
+    TravelMatrix() = default;
+
+    const TravelMatrixHeader &header() const noexcept { return *reinterpret_cast<const TravelMatrixHeader *>(base); }
+    template <typename T>
+    const T *section(uint64_t offset) const noexcept { return reinterpret_cast<const T *>(base + offset); }
+    void release() noexcept;
+
+    char *base = nullptr;
+    size_t size = 0;
+    bool mapped = false;                 ///< base is a file mapping rather than owned memory.
+    std::unique_ptr<uint64_t[]> owned;   ///< In-memory storage, 8-byte aligned.
+};
+
+} // namespace mgm
+
+#endif
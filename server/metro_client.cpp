@@ -0,0 +1,127 @@
+#include "metro_client.hpp"
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace mgm {
+
+namespace {
+
+constexpr size_t ChunkSize = 1 << 16;
+
+[[noreturn]] void failConnection(const char *what) {
+    throw std::invalid_argument(string("Error: Cannot ") + what + " the metro server: " + std::strerror(errno) + ".");
+}
+
+} // namespace
+
+MetroClient::MetroClient(const string &socketPath) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof addr.sun_path)
+        throw std::invalid_argument("Error: Socket path too long: " + socketPath + ".");
+    std::memcpy(addr.sun_path, socketPath.c_str(), socketPath.size() + 1);
+    fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        failConnection("reach");
+    if (::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof addr) < 0) {
+        int error = errno;
+        ::close(fd);
+        errno = error;
+        failConnection("connect to");
+    }
+}
+
+MetroClient::~MetroClient() {
+    if (fd >= 0)
+        ::close(fd);
+}
+
+WireWriter MetroClient::start(WireOp op) {
+    WireWriter frame(out);
+    frame.u32(nextId++);
+    frame.u8(static_cast<uint8_t>(op));
+    return frame;
+}
+
+uint32_t MetroClient::find(std::string_view line, std::string_view station) {
+    WireWriter frame = start(WireOp::Find);
+    frame.str(line);
+    frame.str(station);
+    frame.finish();
+    return nextId - 1;
+}
+
+uint32_t MetroClient::describe() {
+    start(WireOp::Describe).finish();
+    return nextId - 1;
+}
+
+uint32_t MetroClient::route(RouteCost cost, std::string_view fromLine, std::string_view fromStation,
+                            std::string_view toLine, std::string_view toStation) {
+    WireWriter frame = start(WireOp::Route);
+    frame.u8(static_cast<uint8_t>(cost));
+    frame.str(fromLine);
+    frame.str(fromStation);
+    frame.str(toLine);
+    frame.str(toStation);
+    frame.finish();
+    return nextId - 1;
+}
+
+uint32_t MetroClient::validate() {
+    start(WireOp::Validate).finish();
+    return nextId - 1;
+}
+
+void MetroClient::flush() {
+    size_t sent = 0;
+    while (sent < out.size()) {
+        ssize_t n = ::send(fd, out.data() + sent, out.size() - sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            failConnection("write to");
+        }
+        sent += static_cast<size_t>(n);
+    }
+    out.clear();
+}
+
+void MetroClient::shutdownSending() {
+    flush();
+    if (::shutdown(fd, SHUT_WR) < 0)
+        failConnection("shut down writing to");
+}
+
+ClientResponse MetroClient::receive() {
+    flush();
+    in.erase(0, consumed);
+    consumed = 0;
+    uint32_t size = 0;
+    size_t frame;
+    while ((frame = WireReader::frameSize(in, size)) == 0) {
+        std::array<char, ChunkSize> chunk;
+        ssize_t n = ::read(fd, chunk.data(), chunk.size());
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            failConnection("read from");
+        if (n == 0)
+            throw std::invalid_argument("Error: The metro server closed the connection.");
+        in.append(chunk.data(), static_cast<size_t>(n));
+    }
+    consumed = frame;
+    WireReader payload(std::string_view(in).substr(FrameHeaderSize, size));
+    ClientResponse response;
+    response.id = payload.u32();
+    response.status = static_cast<WireStatus>(payload.u8());
+    response.body = payload.rest();
+    return response;
+}
+
+} // namespace mgm
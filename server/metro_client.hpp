@@ -0,0 +1,115 @@
+#ifndef METRO_CLIENT_HPP_
+#define METRO_CLIENT_HPP_
+
+#include "protocol.hpp"
+#include "../routing/route_graph.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * @file metro_client.hpp
+ * @brief Blocking client of the metro query server.
+ */
+
+namespace mgm {
+
+/**
+ * @brief A response as received by MetroClient.
+ */
+struct ClientResponse {
+    uint32_t id = 0;                      ///< ID of the request it answers.
+    WireStatus status = WireStatus::Error; ///< Outcome.
+    std::string_view body;                ///< Body, valid until the next receive().
+};
+
+/**
+ * @brief One connection to a MetroServer.
+ *
+ * Request methods only queue a frame and return its ID, so several requests can
+ * be sent with one flush() and be in flight at once; receive() flushes what is
+ * queued and waits for the next response. One client must not be used by several
+ * threads at once.
+ */
+class MetroClient {
+public:
+    /**
+     * @brief Connects to a server.
+     * @param socketPath Path of the server socket.
+     * @throws std::invalid_argument If the connection fails.
+     */
+    explicit MetroClient(const string &socketPath);
+
+    MetroClient(const MetroClient &) = delete;
+    MetroClient &operator=(const MetroClient &) = delete;
+
+    ~MetroClient();
+
+    /**
+     * @brief Queues a Find request.
+     * @param line The line name.
+     * @param station The station name.
+     * @return The request ID.
+     */
+    uint32_t find(std::string_view line, std::string_view station);
+
+    /**
+     * @brief Queues a Describe request.
+     * @return The request ID.
+     */
+    uint32_t describe();
+
+    /**
+     * @brief Queues a Route request; empty line names ask for a route between station names.
+     * @param cost The cost model.
+     * @param fromLine The line of the origin, or empty.
+     * @param fromStation The origin station.
+     * @param toLine The line of the destination, or empty.
+     * @param toStation The destination station.
+     * @return The request ID.
+     */
+    uint32_t route(RouteCost cost, std::string_view fromLine, std::string_view fromStation,
+                   std::string_view toLine, std::string_view toStation);
+
+    /**
+     * @brief Queues a Validate request.
+     * @return The request ID.
+     */
+    uint32_t validate();
+
+    /**
+     * @brief Sends every queued request.
+     * @throws std::invalid_argument If the connection fails.
+     */
+    void flush();
+
+    /**
+     * @brief Sends every queued request and tells the server that no more follow.
+     *
+     * The answers to the requests sent so far can still be received; the server
+     * closes the connection after the last one.
+     *
+     * @throws std::invalid_argument If the connection fails.
+     */
+    void shutdownSending();
+
+    /**
+     * @brief Sends queued requests and waits for the next response.
+     * @return The response.
+     * @throws std::invalid_argument If the connection fails or the server closes it.
+     */
+    ClientResponse receive();
+
+private:
+    WireWriter start(WireOp op);
+
+    int fd = -1;
+    uint32_t nextId = 1;
+    string out;       ///< Queued request frames.
+    string in;        ///< Received bytes.
+    size_t consumed = 0; ///< Bytes of in already returned by receive().
+};
+
+} // namespace mgm
+
+#endif
@@ -0,0 +1,190 @@
+#include "metro_client.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @file metro_load.cpp
+ * @brief Load generator for the metro query server.
+ *
+ * Learns the stations of the served network from one Describe request, then runs
+ * a number of client threads, each keeping a fixed number of Find and Route
+ * requests in flight on its own connection between random stations. Reports
+ * throughput and the latency percentiles of all requests.
+ */
+
+using namespace mgm;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct Options {
+    string socketPath;
+    unsigned clients = 4;
+    size_t requests = 100000; ///< Per client.
+    unsigned depth = 1;       ///< Requests in flight per client.
+    unsigned routeShare = 20; ///< Percentage of Route requests.
+};
+
+struct Stop {
+    string line, station;
+};
+
+struct ClientResult {
+    std::vector<uint64_t> latencies; ///< Nanoseconds per request.
+    size_t errors = 0;
+};
+
+[[noreturn]] void usage(const char *program) {
+    std::cerr << "Usage: " << program
+              << " <socket> [--clients N] [--requests N per client] [--depth N] [--route-share percent]\n";
+    std::exit(1);
+}
+
+/// Parses the "Line: X" headers and "station-type" rows of a system description.
+std::vector<Stop> parseStops(std::string_view description) {
+    std::vector<Stop> stops;
+    string line;
+    while (!description.empty()) {
+        size_t end = description.find('\n');
+        std::string_view row = description.substr(0, end);
+        description.remove_prefix(end == std::string_view::npos ? description.size() : end + 1);
+        if (row.starts_with("Line: ")) {
+            line.assign(row.substr(6));
+        } else if (size_t dash = row.rfind('-'); dash != std::string_view::npos && !line.empty()) {
+            stops.push_back(Stop{line, string(row.substr(0, dash))});
+        }
+    }
+    return stops;
+}
+
+void runClient(const Options &options, const std::vector<Stop> &stops, unsigned seed, ClientResult &result) {
+    MetroClient client(options.socketPath);
+    std::mt19937_64 random(seed);
+    std::uniform_int_distribution<size_t> pick(0, stops.size() - 1);
+    std::uniform_int_distribution<unsigned> percent(0, 99);
+    std::unordered_map<uint32_t, Clock::time_point> inFlight;
+    result.latencies.reserve(options.requests);
+
+    size_t sent = 0;
+    auto sendOne = [&] {
+        const Stop &a = stops[pick(random)];
+        uint32_t id;
+        if (percent(random) < options.routeShare) {
+            const Stop &b = stops[pick(random)];
+            id = client.route(RouteCost::FewestStops, a.line, a.station, b.line, b.station);
+        } else {
+            id = client.find(a.line, a.station);
+        }
+        inFlight.emplace(id, Clock::now());
+        ++sent;
+    };
+    while (sent < options.requests && sent < options.depth)
+        sendOne();
+    while (!inFlight.empty()) {
+        ClientResponse response = client.receive();
+        auto now = Clock::now();
+        auto it = inFlight.find(response.id);
+        if (it == inFlight.end())
+            continue;
+        result.latencies.push_back(
+            static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - it->second).count()));
+        inFlight.erase(it);
+        if (response.status == WireStatus::Error)
+            ++result.errors;
+        if (sent < options.requests)
+            sendOne();
+    }
+}
+
+double percentile(const std::vector<uint64_t> &sorted, double p) {
+    if (sorted.empty())
+        return 0;
+    size_t index = std::min(sorted.size() - 1, static_cast<size_t>(p * static_cast<double>(sorted.size())));
+    return static_cast<double>(sorted[index]) / 1000.0;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    if (argc < 2)
+        usage(argv[0]);
+    Options options;
+    options.socketPath = argv[1];
+    for (int i = 2; i < argc; ++i) {
+        string arg = argv[i];
+        if (i + 1 == argc)
+            usage(argv[0]);
+        unsigned long value = std::strtoul(argv[++i], nullptr, 10);
+        if (arg == "--clients")
+            options.clients = static_cast<unsigned>(value);
+        else if (arg == "--requests")
+            options.requests = value;
+        else if (arg == "--depth")
+            options.depth = static_cast<unsigned>(value);
+        else if (arg == "--route-share")
+            options.routeShare = static_cast<unsigned>(value);
+        else
+            usage(argv[0]);
+    }
+    if (options.clients == 0 || options.depth == 0)
+        usage(argv[0]);
+
+    std::vector<Stop> stops;
+    try {
+        MetroClient client(options.socketPath);
+        client.describe();
+        stops = parseStops(client.receive().body);
+    } catch (std::exception &ex) {
+        std::cerr << ex.what() << "\n";
+        return 1;
+    }
+    if (stops.empty()) {
+        std::cerr << "Error: The served network has no stations.\n";
+        return 1;
+    }
+
+    std::vector<ClientResult> results(options.clients);
+    std::vector<std::thread> threads;
+    std::vector<string> failures(options.clients);
+    auto started = Clock::now();
+    for (unsigned c = 0; c < options.clients; ++c) {
+        threads.emplace_back([&, c] {
+            try {
+                runClient(options, stops, c + 1, results[c]);
+            } catch (std::exception &ex) {
+                failures[c] = ex.what();
+            }
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+    double seconds = std::chrono::duration<double>(Clock::now() - started).count();
+
+    std::vector<uint64_t> latencies;
+    size_t errors = 0;
+    for (const auto &result : results) {
+        latencies.insert(latencies.end(), result.latencies.begin(), result.latencies.end());
+        errors += result.errors;
+    }
+    for (const auto &failure : failures) {
+        if (!failure.empty())
+            std::cerr << failure << "\n";
+    }
+    std::sort(latencies.begin(), latencies.end());
+    std::printf("stations %zu, clients %u, depth %u, route share %u%%\n", stops.size(), options.clients,
+                options.depth, options.routeShare);
+    std::printf("requests %zu, errors %zu, %.2f s, %.0f QPS\n", latencies.size(), errors, seconds,
+                static_cast<double>(latencies.size()) / seconds);
+    std::printf("latency us: p50 %.1f, p99 %.1f, max %.1f\n", percentile(latencies, 0.50),
+                percentile(latencies, 0.99), percentile(latencies, 1.0));
+    return errors || latencies.size() != options.requests * options.clients ? 2 : 0;
+}
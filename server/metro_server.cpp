@@ -0,0 +1,453 @@
+#include "metro_server.hpp"
+#include "../container/recordReader.hpp"
+#include "../container/textSink.hpp"
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace mgm {
+
+namespace {
+
+constexpr size_t ChunkSize = 1 << 16;
+constexpr int MaxEvents = 64;
+
+/**
+ * @brief Per-thread state of a worker: a pinned version, a route finder and argument buffers.
+ */
+class Worker {
+public:
+    explicit Worker(SharedMetroSystem &shared) : shared(shared), reader(shared) {}
+
+    /// Pins the latest version for the next batch.
+    void pin() { current = &reader.pin(); }
+
+    /**
+     * @brief Answers one request.
+     * @param request The request payload.
+     * @param frames Where the response frame is appended.
+     * @return False if the answer is an error.
+     */
+    bool answer(std::string_view request, string &frames) {
+        WireReader in(request);
+        uint32_t id = in.u32();
+        size_t start = frames.size();
+        try {
+            WireWriter out(frames);
+            out.u32(id);
+            respond(in, out);
+            out.finish();
+            return true;
+        } catch (const std::exception &ex) {
+            frames.resize(start);
+            WireWriter out(frames);
+            out.u32(id);
+            out.u8(static_cast<uint8_t>(WireStatus::Error));
+            out.bytes(mgc::withoutErrorPrefix(ex.what()));
+            out.finish();
+            return false;
+        }
+    }
+
+private:
+    static void malformed() { throw std::invalid_argument("Error: Malformed request."); }
+
+    void respond(WireReader &in, WireWriter &out) {
+        auto op = static_cast<WireOp>(in.u8());
+        switch (op) {
+        case WireOp::Find: {
+            lineName = in.str();
+            stationName = in.str();
+            if (in.failed() || !in.atEnd())
+                malformed();
+            auto st = current->findStationOnLine(lineName, stationName);
+            out.u8(static_cast<uint8_t>(WireStatus::Ok));
+            out.bytes(st->getType());
+            break;
+        }
+        case WireOp::Describe: {
+            if (in.failed() || !in.atEnd())
+                malformed();
+            out.u8(static_cast<uint8_t>(WireStatus::Ok));
+            mgc::TextSink sink(out.buffer());
+            current->writeSystemDescription(sink);
+            break;
+        }
+        case WireOp::Route: {
+            uint8_t cost = in.u8();
+            lineName = in.str();
+            stationName = in.str();
+            toLineName = in.str();
+            toStationName = in.str();
+            if (in.failed() || !in.atEnd() || cost > static_cast<uint8_t>(RouteCost::FewestTransfers))
+                malformed();
+            route(static_cast<RouteCost>(cost), out);
+            break;
+        }
+        case WireOp::Validate: {
+            if (in.failed() || !in.atEnd())
+                malformed();
+            size_t removed = 0;
+            shared.update([&removed](MetroSystem &system) { removed = system.validateSystem(); });
+            pin();
+            out.u8(static_cast<uint8_t>(WireStatus::Ok));
+            out.u64(removed);
+            break;
+        }
+        default:
+            malformed();
+        }
+    }
+
+    void route(RouteCost cost, WireWriter &out) {
+        const RouteGraph &graph = current->getRouteGraph();
+        std::optional<RoutePath> path;
+        if (lineName.empty() && toLineName.empty()) {
+            auto from = graph.nodesNamed(stationName);
+            auto to = graph.nodesNamed(toStationName);
+            if (from.empty() || to.empty())
+                throw std::invalid_argument("Error: Station not found.");
+            path = finder.search(graph.view(), from, to, cost);
+        } else {
+            auto from = graph.node(lineName, stationName);
+            auto to = graph.node(toLineName, toStationName);
+            if (!from || !to)
+                throw std::invalid_argument("Error: Station not found on this line.");
+            path = finder.search(graph.view(), std::span(&*from, 1), std::span(&*to, 1), cost);
+        }
+        if (!path) {
+            out.u8(static_cast<uint8_t>(WireStatus::NotFound));
+            return;
+        }
+        out.u8(static_cast<uint8_t>(WireStatus::Ok));
+        out.u32(path->stopCount);
+        out.u32(path->transferCount);
+        out.u32(static_cast<uint32_t>(path->nodes.size()));
+        for (uint32_t node : path->nodes) {
+            out.str(graph.lineName(node));
+            out.str(graph.stationName(node));
+        }
+    }
+
+    SharedMetroSystem &shared;
+    SharedMetroSystem::Reader reader;
+    const MetroSystem *current = nullptr;
+    RouteFinder finder;
+    std::string_view lineName, stationName, toLineName, toStationName; ///< Arguments, viewing the request payload.
+};
+
+} // namespace
+
+MetroServer::MetroServer(SharedMetroSystem &system, ServerOptions options)
+    : system(system), options(std::move(options)) {
+    auto fail = [this](const char *what) {
+        string message = "Error: Cannot " + string(what) + " " + this->options.socketPath + ": " + std::strerror(errno) + ".";
+        if (wakeFd >= 0)
+            ::close(wakeFd);
+        if (epollFd >= 0)
+            ::close(epollFd);
+        if (listenFd >= 0)
+            ::close(listenFd);
+        throw std::invalid_argument(message);
+    };
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (this->options.socketPath.empty() || this->options.socketPath.size() >= sizeof addr.sun_path) {
+        errno = ENAMETOOLONG;
+        fail("listen on");
+    }
+    std::memcpy(addr.sun_path, this->options.socketPath.c_str(), this->options.socketPath.size() + 1);
+    struct stat existing;
+    if (::stat(addr.sun_path, &existing) == 0 && S_ISSOCK(existing.st_mode))
+        ::unlink(addr.sun_path);
+
+    listenFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd < 0)
+        fail("create socket for");
+    if (::bind(listenFd, reinterpret_cast<sockaddr *>(&addr), sizeof addr) < 0)
+        fail("bind");
+    if (::listen(listenFd, SOMAXCONN) < 0)
+        fail("listen on");
+    epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd < 0 || wakeFd < 0)
+        fail("set up the event loop of");
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = listenFd;
+    ::epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &ev);
+    ev.data.fd = wakeFd;
+    ::epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &ev);
+}
+
+MetroServer::~MetroServer() {
+    for (const auto &conn : connections)
+        ::close(conn.first);
+    ::close(wakeFd);
+    ::close(epollFd);
+    ::close(listenFd);
+    ::unlink(options.socketPath.c_str());
+}
+
+void MetroServer::stop() noexcept {
+    stopping.store(true, std::memory_order_release);
+    uint64_t one = 1;
+    [[maybe_unused]] ssize_t n = ::write(wakeFd, &one, sizeof one);
+}
+
+void MetroServer::run() {
+    unsigned workers = options.workers ? options.workers : std::max(1u, std::thread::hardware_concurrency());
+    {
+        std::lock_guard lock(queueMutex);
+        shuttingDown = false;
+    }
+    for (unsigned i = 0; i < workers; ++i)
+        pool.emplace_back(&MetroServer::work, this);
+    chunk.resize(ChunkSize);
+
+    std::array<epoll_event, MaxEvents> events;
+    while (!stopping.load(std::memory_order_acquire)) {
+        int n = ::epoll_wait(epollFd, events.data(), MaxEvents, -1);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+            uint32_t what = events[i].events;
+            if (fd == listenFd) {
+                accept();
+            } else if (fd == wakeFd) {
+                uint64_t count;
+                [[maybe_unused]] ssize_t r = ::read(wakeFd, &count, sizeof count);
+                deliver();
+            } else {
+                auto it = connections.find(fd);
+                if (it != connections.end() && (what & EPOLLOUT))
+                    send(fd, it->second);
+                if (connections.count(fd) && (what & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)))
+                    receive(fd);
+            }
+        }
+        submit();
+    }
+
+    {
+        std::lock_guard lock(queueMutex);
+        shuttingDown = true;
+    }
+    queued.release(static_cast<ptrdiff_t>(pool.size()));
+    for (auto &worker : pool)
+        worker.join();
+    pool.clear();
+    queue.clear();
+    done.clear();
+    pending = Frames{};
+    while (!connections.empty())
+        close(connections.begin()->first);
+}
+
+void MetroServer::accept() {
+    while (true) {
+        int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.fd = fd;
+        if (::epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            ::close(fd);
+            continue;
+        }
+        connections[fd].serial = nextSerial++;
+        ++counters.connections;
+    }
+}
+
+void MetroServer::receive(int fd) {
+    Connection &conn = connections.at(fd);
+    // Reads are no longer watched after end of input, so this is a hangup or an error.
+    if (conn.halfClosed) {
+        close(fd);
+        return;
+    }
+    bool ended = false;
+    while (true) {
+        ssize_t n = ::read(fd, chunk.data(), chunk.size());
+        if (n > 0) {
+            conn.in.append(chunk.data(), static_cast<size_t>(n));
+            if (static_cast<size_t>(n) < chunk.size())
+                break;
+            continue;
+        }
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        if (n < 0) {
+            close(fd);
+            return;
+        }
+        ended = true;
+        break;
+    }
+
+    std::string_view in = conn.in;
+    size_t pos = 0;
+    while (true) {
+        uint32_t size = 0;
+        size_t frame = WireReader::frameSize(in.substr(pos), size);
+        if (size > MaxRequestSize) {
+            close(fd);
+            return;
+        }
+        if (frame == 0)
+            break;
+        pending.items.push_back(Frames::Item{fd, conn.serial, pending.data.size(), size});
+        pending.data.append(in.substr(pos + FrameHeaderSize, size));
+        ++conn.unanswered;
+        pos += frame;
+        if (pending.items.size() >= options.maxBatch)
+            submit();
+    }
+    conn.in.erase(0, pos);
+    if (!ended)
+        return;
+    // An incomplete frame at end of input is never answered.
+    conn.halfClosed = true;
+    conn.in.clear();
+    if (conn.unanswered == 0 && !conn.writing)
+        close(fd);
+    else
+        watch(fd, conn);
+}
+
+void MetroServer::send(int fd, Connection &conn) {
+    while (conn.written < conn.out.size()) {
+        ssize_t n = ::send(fd, conn.out.data() + conn.written, conn.out.size() - conn.written, MSG_NOSIGNAL);
+        if (n > 0) {
+            conn.written += static_cast<size_t>(n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            if (!conn.writing) {
+                conn.writing = true;
+                watch(fd, conn);
+            }
+            return;
+        }
+        close(fd);
+        return;
+    }
+    conn.out.clear();
+    conn.written = 0;
+    if (conn.halfClosed && conn.unanswered == 0) {
+        close(fd);
+        return;
+    }
+    if (conn.writing) {
+        conn.writing = false;
+        watch(fd, conn);
+    }
+}
+
+void MetroServer::watch(int fd, const Connection &conn) {
+    epoll_event ev{};
+    if (!conn.halfClosed)
+        ev.events |= EPOLLIN | EPOLLRDHUP;
+    if (conn.writing)
+        ev.events |= EPOLLOUT;
+    ev.data.fd = fd;
+    ::epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &ev);
+}
+
+void MetroServer::close(int fd) {
+    ::epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    connections.erase(fd);
+}
+
+void MetroServer::submit() {
+    if (pending.items.empty())
+        return;
+    {
+        std::lock_guard lock(queueMutex);
+        queue.push_back(std::move(pending));
+    }
+    queued.release();
+    ++counters.batches;
+    pending = Frames{};
+}
+
+void MetroServer::deliver() {
+    std::vector<Frames> answers;
+    {
+        std::lock_guard lock(queueMutex);
+        answers.swap(done);
+    }
+    std::vector<int> touched;
+    for (const Frames &batch : answers) {
+        counters.requests += batch.items.size();
+        counters.errors += batch.errors;
+        for (const auto &item : batch.items) {
+            auto it = connections.find(item.fd);
+            if (it == connections.end() || it->second.serial != item.serial)
+                continue;
+            if (it->second.out.empty())
+                touched.push_back(item.fd);
+            it->second.out.append(batch.data, item.offset, item.size);
+            --it->second.unanswered;
+        }
+    }
+    for (int fd : touched) {
+        auto it = connections.find(fd);
+        if (it != connections.end() && !it->second.writing)
+            send(fd, it->second);
+    }
+}
+
+void MetroServer::work() {
+    Worker worker(system);
+    while (true) {
+        Frames batch;
+        queued.acquire();
+        {
+            std::lock_guard lock(queueMutex);
+            if (shuttingDown)
+                return;
+            batch = std::move(queue.front());
+            queue.pop_front();
+        }
+        Frames answers;
+        worker.pin();
+        for (const auto &item : batch.items) {
+            size_t offset = answers.data.size();
+            if (!worker.answer(std::string_view(batch.data).substr(item.offset, item.size), answers.data))
+                ++answers.errors;
+            answers.items.push_back(Frames::Item{item.fd, item.serial, offset, answers.data.size() - offset});
+        }
+        {
+            std::lock_guard lock(queueMutex);
+            done.push_back(std::move(answers));
+        }
+        uint64_t one = 1;
+        [[maybe_unused]] ssize_t n = ::write(wakeFd, &one, sizeof one);
+    }
+}
+
+} // namespace mgm
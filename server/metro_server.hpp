@@ -0,0 +1,146 @@
+#ifndef METRO_SERVER_HPP_
+#define METRO_SERVER_HPP_
+
+#include "../Metro_system/shared_metro_system.hpp"
+#include "protocol.hpp"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <semaphore>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @file metro_server.hpp
+ * @brief Query server answering the protocol of protocol.hpp over a Unix domain socket.
+ */
+
+namespace mgm {
+
+/**
+ * @brief Settings of a MetroServer.
+ */
+struct ServerOptions {
+    string socketPath;      ///< Path of the listening socket; an existing socket file there is replaced.
+    unsigned workers = 0;   ///< Worker threads; 0 uses std::thread::hardware_concurrency().
+    size_t maxBatch = 64;   ///< Most requests handed to a worker at once.
+};
+
+/**
+ * @brief Counters of a MetroServer.
+ */
+struct ServerStats {
+    uint64_t connections = 0; ///< Connections accepted.
+    uint64_t requests = 0;    ///< Requests answered.
+    uint64_t batches = 0;     ///< Batches handed to workers.
+    uint64_t errors = 0;      ///< Requests answered with WireStatus::Error.
+};
+
+/**
+ * @brief Serves find, describe, route and validate requests for a shared system.
+ *
+ * One thread runs an epoll loop over the listening socket and all connections:
+ * it reads whatever has arrived, cuts it into frames, and hands the complete
+ * requests of one loop iteration to the worker pool in batches of up to
+ * ServerOptions::maxBatch. A worker pins the current version of the system once
+ * per batch and answers every request of it with its own RouteFinder, so queries
+ * never wait for one another; Validate publishes a new version through
+ * SharedMetroSystem::update(). Answers come back to the loop in one buffer per
+ * batch and are written without blocking, buffering what a slow client does not
+ * take yet. A malformed request is answered with an error; a frame longer than
+ * MaxRequestSize closes its connection. A client that shuts down its sending
+ * side still gets the answers to every complete request it sent; the connection
+ * closes once they are written.
+ */
+class MetroServer {
+public:
+    /**
+     * @brief Binds and listens on the socket; no request is served before run().
+     * @param system The system to serve; must outlive the server.
+     * @param options The settings.
+     * @throws std::invalid_argument If the socket cannot be set up.
+     */
+    MetroServer(SharedMetroSystem &system, ServerOptions options);
+
+    MetroServer(const MetroServer &) = delete;
+    MetroServer &operator=(const MetroServer &) = delete;
+
+    /**
+     * @brief Closes every connection and removes the socket file.
+     */
+    ~MetroServer();
+
+    /**
+     * @brief Serves requests until stop() is called.
+     */
+    void run();
+
+    /**
+     * @brief Makes run() return; safe to call from another thread or a signal handler.
+     */
+    void stop() noexcept;
+
+    /**
+     * @brief Gets the counters, once run() has returned.
+     * @return The counters.
+     */
+    const ServerStats &stats() const noexcept { return counters; }
+
+private:
+    /// Frames stored back to back: a batch of requests, or the answers to one.
+    struct Frames {
+        struct Item {
+            int fd;
+            uint64_t serial;    ///< Connection the frame comes from or goes to.
+            size_t offset, size;
+        };
+        std::vector<Item> items;
+        string data;
+        uint64_t errors = 0;    ///< Error answers among the frames.
+    };
+
+    struct Connection {
+        uint64_t serial;    ///< Distinguishes connections that reuse a descriptor.
+        string in;          ///< Received bytes not yet cut into frames.
+        string out;         ///< Answers not yet written.
+        size_t written = 0; ///< Bytes of out already written.
+        size_t unanswered = 0; ///< Requests submitted or pending whose answers have not arrived.
+        bool writing = false; ///< Registered for EPOLLOUT.
+        bool halfClosed = false; ///< The client sends no more; close once all answers are written.
+    };
+
+    void accept();
+    void receive(int fd);
+    void send(int fd, Connection &conn);
+    void watch(int fd, const Connection &conn);
+    void close(int fd);
+    void submit();
+    void deliver();
+    void work();
+
+    SharedMetroSystem &system;
+    ServerOptions options;
+    int listenFd = -1;
+    int epollFd = -1;
+    int wakeFd = -1;                        ///< eventfd raised by stop() and by workers with answers.
+    std::atomic<bool> stopping{false};
+    uint64_t nextSerial = 1;
+    std::unordered_map<int, Connection> connections;
+    Frames pending;                         ///< Requests of the current loop iteration.
+    std::vector<char> chunk;                ///< Read buffer.
+    ServerStats counters;
+
+    std::mutex queueMutex;
+    std::counting_semaphore<> queued{0};    ///< Released once per batch queued, and once per worker to shut down.
+    std::deque<Frames> queue;               ///< Batches waiting for a worker.
+    std::vector<Frames> done;               ///< Answers waiting for the loop; guarded by queueMutex.
+    bool shuttingDown = false;              ///< Tells workers to exit; guarded by queueMutex.
+    std::vector<std::thread> pool;
+};
+
+} // namespace mgm
+
+#endif
@@ -0,0 +1,215 @@
+#ifndef PROTOCOL_HPP_
+#define PROTOCOL_HPP_
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+/**
+ * @file protocol.hpp
+ * @brief Length-prefixed binary protocol of the metro query server.
+ *
+ * Every message is a frame: a 32-bit payload length followed by the payload.
+ * Integers are in the byte order of the host, since client and server share a
+ * machine; strings are a 16-bit length followed by the bytes.
+ *
+ * A request payload is a 32-bit request ID chosen by the client, an opcode and
+ * the fields of the opcode:
+ * @code
+ * Find      <line> <station>
+ * Describe
+ * Route     <u8 RouteCost> <from line> <from station> <to line> <to station>
+ * Validate
+ * @endcode
+ * A route with both line fields empty is between station names on any of their lines.
+ *
+ * A response payload is the request ID, a status and a body, which takes the rest
+ * of the frame. On success the body of Find is the type of the station; of Describe
+ * the text of MetroSystem::getSystemDescription(); of Route the 32-bit stop and
+ * transfer counts, a 32-bit number of stops and each stop as a line and a station
+ * string; of Validate the 64-bit number of connections removed. The body of an
+ * error is its message, and NotFound has an empty body. A server may answer the
+ * requests of one connection out of order.
+ */
+
+namespace mgm {
+
+/**
+ * @brief Operation of a request.
+ */
+enum class WireOp : uint8_t {
+    Find = 1,     ///< Look a station up on a line.
+    Describe = 2, ///< Get the description of the whole system.
+    Route = 3,    ///< Find the cheapest route between two stations.
+    Validate = 4  ///< Validate the system, removing dangling transfers.
+};
+
+/**
+ * @brief Outcome of a request.
+ */
+enum class WireStatus : uint8_t {
+    Ok = 0,       ///< The body holds the result.
+    NotFound = 1, ///< The stations exist but no route joins them.
+    Error = 2     ///< The body holds the error message.
+};
+
+/// Size of the length prefix of a frame.
+constexpr size_t FrameHeaderSize = 4;
+
+/// Largest request payload a server accepts.
+constexpr size_t MaxRequestSize = 64 * 1024;
+
+/**
+ * @brief Appends one frame to a buffer.
+ *
+ * The length prefix is reserved on construction and filled in by finish(), so a
+ * frame is written in place without knowing its size in advance.
+ */
+class WireWriter {
+public:
+    /**
+     * @brief Starts a frame at the end of a buffer.
+     * @param buffer The buffer; its current contents are kept.
+     */
+    explicit WireWriter(std::string &buffer) : out(buffer), start(buffer.size()) {
+        out.append(FrameHeaderSize, '\0');
+    }
+
+    void u8(uint8_t value) { out.push_back(static_cast<char>(value)); }
+    void u16(uint16_t value) { raw(&value, sizeof value); }
+    void u32(uint32_t value) { raw(&value, sizeof value); }
+    void u64(uint64_t value) { raw(&value, sizeof value); }
+
+    /**
+     * @brief Appends a length-prefixed string.
+     * @param text The string.
+     * @throws std::invalid_argument If it is longer than 65535 bytes.
+     */
+    void str(std::string_view text) {
+        if (text.size() > UINT16_MAX)
+            throw std::invalid_argument("Error: String too long for a request field.");
+        u16(static_cast<uint16_t>(text.size()));
+        out.append(text);
+    }
+
+    /**
+     * @brief Appends bytes without a length, as the body of a response.
+     * @param bytes The bytes.
+     */
+    void bytes(std::string_view bytes) { out.append(bytes); }
+
+    /**
+     * @brief Gets the buffer the frame is written to, to append a body directly.
+     * @return The buffer.
+     */
+    std::string &buffer() noexcept { return out; }
+
+    /**
+     * @brief Writes the length prefix once the payload is complete.
+     */
+    void finish() noexcept {
+        uint32_t length = static_cast<uint32_t>(out.size() - start - FrameHeaderSize);
+        std::memcpy(out.data() + start, &length, sizeof length);
+    }
+
+private:
+    void raw(const void *data, size_t size) { out.append(static_cast<const char *>(data), size); }
+
+    std::string &out;
+    size_t start;
+};
+
+/**
+ * @brief Reads the fields of one payload.
+ *
+ * Reading past the end yields zeros and empty strings and marks the reader as
+ * failed, so a caller reads all fields and checks failed() once.
+ */
+class WireReader {
+public:
+    /**
+     * @brief Reads a payload.
+     * @param payload The payload, without the length prefix.
+     */
+    explicit WireReader(std::string_view payload) noexcept : data(payload) {}
+
+    uint8_t u8() noexcept { return get<uint8_t>(); }
+    uint16_t u16() noexcept { return get<uint16_t>(); }
+    uint32_t u32() noexcept { return get<uint32_t>(); }
+    uint64_t u64() noexcept { return get<uint64_t>(); }
+
+    /**
+     * @brief Reads a length-prefixed string.
+     * @return The string, pointing into the payload.
+     */
+    std::string_view str() noexcept {
+        size_t size = u16();
+        if (size > data.size()) {
+            bad = true;
+            data = {};
+            return {};
+        }
+        std::string_view text = data.substr(0, size);
+        data.remove_prefix(size);
+        return text;
+    }
+
+    /**
+     * @brief Takes the unread rest of the payload.
+     * @return The rest, as the body of a response.
+     */
+    std::string_view rest() noexcept {
+        std::string_view text = data;
+        data = {};
+        return text;
+    }
+
+    /**
+     * @brief Tells whether a read ran past the end of the payload.
+     * @return True if the payload was too short.
+     */
+    bool failed() const noexcept { return bad; }
+
+    /**
+     * @brief Tells whether the whole payload has been read.
+     * @return True if nothing is left.
+     */
+    bool atEnd() const noexcept { return data.empty(); }
+
+    /**
+     * @brief Finds the first complete frame of a buffer.
+     * @param buffer Received bytes.
+     * @param payloadSize Set to the payload length when the header is complete.
+     * @return The size of the whole frame, or 0 if it has not fully arrived.
+     */
+    static size_t frameSize(std::string_view buffer, uint32_t &payloadSize) noexcept {
+        if (buffer.size() < FrameHeaderSize)
+            return 0;
+        std::memcpy(&payloadSize, buffer.data(), sizeof payloadSize);
+        size_t total = FrameHeaderSize + size_t{payloadSize};
+        return buffer.size() < total ? 0 : total;
+    }
+
+private:
+    template<typename T>
+    T get() noexcept {
+        T value{};
+        if (data.size() < sizeof value) {
+            bad = true;
+            data = {};
+            return value;
+        }
+        std::memcpy(&value, data.data(), sizeof value);
+        data.remove_prefix(sizeof value);
+        return value;
+    }
+
+    std::string_view data;
+    bool bad = false;
+};
+
+} // namespace mgm
+
+#endif
@@ -0,0 +1,431 @@
+#include "snapshot.hpp"
+#include "../Stations/transitionstation.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+namespace mgm {
+
+namespace {
+
+constexpr char SnapshotMagic[8] = {'M', 'G', 'M', 'S', 'N', 'A', 'P', '\0'};
+
+static_assert(sizeof(SnapshotHeader) == 136, "snapshot header layout changed");
+
+constexpr uint64_t align8(uint64_t offset) { return (offset + 7) & ~uint64_t{7}; }
+
+/// Collects distinct strings and hands out their IDs.
+class StringTable {
+public:
+    uint32_t intern(std::string_view s) {
+        auto [it, inserted] = ids.try_emplace(s, static_cast<uint32_t>(strings.size()));
+        if (inserted)
+            strings.push_back(s);
+        return it->second;
+    }
+    const std::vector<std::string_view> &all() const { return strings; }
+
+private:
+    std::vector<std::string_view> strings;
+    std::unordered_map<std::string_view, uint32_t> ids;
+};
+
+/// Appends sections to a file, keeping every section 8-byte aligned.
+class SectionWriter {
+public:
+    explicit SectionWriter(std::ofstream &out) : out(out) {}
+
+    template <typename T>
+    uint64_t write(const T *data, size_t count) {
+        pad();
+        uint64_t at = offset;
+        out.write(reinterpret_cast<const char *>(data), static_cast<std::streamsize>(count * sizeof(T)));
+        offset += count * sizeof(T);
+        return at;
+    }
+    template <typename T>
+    uint64_t write(const std::vector<T> &v) { return write(v.data(), v.size()); }
+    uint64_t end() {
+        pad();
+        return offset;
+    }
+    void skip(uint64_t bytes) {
+        std::vector<char> zeros(bytes, 0);
+        out.write(zeros.data(), static_cast<std::streamsize>(bytes));
+        offset += bytes;
+    }
+
+private:
+    void pad() {
+        static const char zeros[8] = {};
+        uint64_t aligned = align8(offset);
+        out.write(zeros, static_cast<std::streamsize>(aligned - offset));
+        offset = aligned;
+    }
+
+    std::ofstream &out;
+    uint64_t offset = 0;
+};
+
+} // namespace
+
+void saveSnapshot(const MetroSystem &system, const string &path) {
+    std::vector<const string *> lineNames;
+    std::vector<const Line *> lineRefs;
+    lineNames.reserve(system.getLines().size());
+    lineRefs.reserve(system.getLines().size());
+    for (const auto &linePair : system.getLines()) {
+        lineNames.push_back(&linePair.first.str());
+        lineRefs.push_back(&linePair.second);
+    }
+    RouteGraph graph = RouteGraph::build(lineRefs);
+    RouteGraphView csr = graph.view();
+
+    StringTable strings;
+    std::vector<SnapshotLine> lines;
+    std::vector<SnapshotNode> nodes;
+    std::vector<uint32_t> connectionOffsets{0};
+    std::vector<SnapshotConnection> connections;
+    lines.reserve(lineRefs.size());
+    nodes.reserve(graph.nodeCount());
+    connectionOffsets.reserve(graph.nodeCount() + 1);
+    for (uint32_t li = 0; li < lineRefs.size(); ++li) {
+        const auto &table = lineRefs[li]->getStations();
+        lines.push_back(SnapshotLine{strings.intern(*lineNames[li]), static_cast<uint32_t>(nodes.size()),
+                                     static_cast<uint32_t>(table.size())});
+        for (const auto &stationPair : table) {
+            const station &st = *stationPair.second;
+            nodes.push_back(SnapshotNode{strings.intern(stationPair.first.str()), strings.intern(st.getType()), li});
+            if (auto *ts = dynamic_cast<const transition_station *>(&st)) {
+                for (const auto &conn : ts->get_station_list())
+                    connections.push_back(SnapshotConnection{strings.intern(conn.first.str()), strings.intern(conn.second.str())});
+            }
+            connectionOffsets.push_back(static_cast<uint32_t>(connections.size()));
+        }
+    }
+
+    const auto &all = strings.all();
+    std::vector<uint32_t> stringOffsets;
+    stringOffsets.reserve(all.size() + 1);
+    string blob;
+    for (std::string_view s : all) {
+        stringOffsets.push_back(static_cast<uint32_t>(blob.size()));
+        blob.append(s);
+    }
+    stringOffsets.push_back(static_cast<uint32_t>(blob.size()));
+
+    auto name = [&all](uint32_t id) { return all[id]; };
+    std::vector<uint32_t> linesByName(lines.size());
+    std::iota(linesByName.begin(), linesByName.end(), 0);
+    std::sort(linesByName.begin(), linesByName.end(),
+              [&](uint32_t a, uint32_t b) { return name(lines[a].name) < name(lines[b].name); });
+    auto byStationName = [&](uint32_t a, uint32_t b) { return name(nodes[a].name) < name(nodes[b].name); };
+    std::vector<uint32_t> nodesByLineName(nodes.size());
+    std::iota(nodesByLineName.begin(), nodesByLineName.end(), 0);
+    for (const auto &line : lines) {
+        auto first = nodesByLineName.begin() + line.firstNode;
+        std::sort(first, first + line.nodeCount, byStationName);
+    }
+    std::vector<uint32_t> nodesByName(nodes.size());
+    std::iota(nodesByName.begin(), nodesByName.end(), 0);
+    std::stable_sort(nodesByName.begin(), nodesByName.end(), byStationName);
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out)
+        throw std::invalid_argument("Error: Cannot write snapshot file " + path + ".");
+    SnapshotHeader header{};
+    std::memcpy(header.magic, SnapshotMagic, sizeof header.magic);
+    header.version = SnapshotVersion;
+    header.lineCount = static_cast<uint32_t>(lines.size());
+    header.nodeCount = static_cast<uint32_t>(nodes.size());
+    header.stringCount = static_cast<uint32_t>(all.size());
+    header.edgeCount = graph.edgeCount();
+    header.connectionCount = static_cast<uint32_t>(connections.size());
+
+    SectionWriter writer(out);
+    writer.skip(sizeof(SnapshotHeader));
+    header.stringOffsets = writer.write(stringOffsets);
+    header.stringData = writer.write(blob.data(), blob.size());
+    header.lines = writer.write(lines);
+    header.linesByName = writer.write(linesByName);
+    header.nodes = writer.write(nodes);
+    header.nodesByLineName = writer.write(nodesByLineName);
+    header.nodesByName = writer.write(nodesByName);
+    header.edgeOffsets = writer.write(csr.offsets, csr.nodeCount + 1);
+    header.edgeTargets = writer.write(csr.targets, header.edgeCount);
+    header.edgeKinds = writer.write(csr.kinds, header.edgeCount);
+    header.connectionOffsets = writer.write(connectionOffsets);
+    header.connections = writer.write(connections);
+    header.fileSize = writer.end();
+    out.seekp(0);
+    out.write(reinterpret_cast<const char *>(&header), sizeof header);
+    out.close();
+    if (!out)
+        throw std::invalid_argument("Error: Cannot write snapshot file " + path + ".");
+}
+
+SnapshotView::SnapshotView(const string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        throw std::invalid_argument("Error: Cannot open snapshot file " + path + ".");
+    struct stat info {};
+    if (::fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(SnapshotHeader))) {
+        ::close(fd);
+        throw std::invalid_argument("Error: Not a snapshot file: " + path + ".");
+    }
+    size = static_cast<size_t>(info.st_size);
+    void *mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED)
+        throw std::invalid_argument("Error: Cannot map snapshot file " + path + ".");
+    base = static_cast<const char *>(mapped);
+    try {
+        validate();
+    } catch (...) {
+        unmap();
+        throw;
+    }
+}
+
+SnapshotView::~SnapshotView() { unmap(); }
+
+SnapshotView::SnapshotView(SnapshotView &&other) noexcept
+    : base(other.base), size(other.size), finder(std::move(other.finder)) {
+    other.base = nullptr;
+    other.size = 0;
+}
+
+SnapshotView &SnapshotView::operator=(SnapshotView &&other) noexcept {
+    if (this != &other) {
+        unmap();
+        base = other.base;
+        size = other.size;
+        finder = std::move(other.finder);
+        other.base = nullptr;
+        other.size = 0;
+    }
+    return *this;
+}
+
+void SnapshotView::unmap() noexcept {
+    if (base)
+        ::munmap(const_cast<char *>(base), size);
+    base = nullptr;
+    size = 0;
+}
+
+void SnapshotView::validate() const {
+    const SnapshotHeader &h = header();
+    if (std::memcmp(h.magic, SnapshotMagic, sizeof h.magic) != 0)
+        throw std::invalid_argument("Error: Not a snapshot file.");
+    if (h.version != SnapshotVersion)
+        throw std::invalid_argument("Error: Unsupported snapshot version " + std::to_string(h.version) + ".");
+    if (h.fileSize != size)
+        throw std::invalid_argument("Error: Truncated snapshot file.");
+    auto fits = [this](uint64_t offset, uint64_t count, uint64_t width) {
+        return offset <= size && count <= (size - offset) / width;
+    };
+    bool ok = fits(h.stringOffsets, uint64_t{h.stringCount} + 1, sizeof(uint32_t)) &&
+              fits(h.lines, h.lineCount, sizeof(SnapshotLine)) &&
+              fits(h.linesByName, h.lineCount, sizeof(uint32_t)) &&
+              fits(h.nodes, h.nodeCount, sizeof(SnapshotNode)) &&
+              fits(h.nodesByLineName, h.nodeCount, sizeof(uint32_t)) &&
+              fits(h.nodesByName, h.nodeCount, sizeof(uint32_t)) &&
+              fits(h.edgeOffsets, uint64_t{h.nodeCount} + 1, sizeof(uint32_t)) &&
+              fits(h.edgeTargets, h.edgeCount, sizeof(uint32_t)) &&
+              fits(h.edgeKinds, h.edgeCount, sizeof(uint8_t)) &&
+              fits(h.connectionOffsets, uint64_t{h.nodeCount} + 1, sizeof(uint32_t)) &&
+              fits(h.connections, h.connectionCount, sizeof(SnapshotConnection));
+    uint64_t sections[] = {h.stringOffsets, h.lines, h.linesByName, h.nodes, h.nodesByLineName, h.nodesByName,
+                           h.edgeOffsets, h.edgeTargets, h.connectionOffsets, h.connections};
+    ok = ok && std::all_of(std::begin(sections), std::end(sections), [](uint64_t at) { return at % 8 == 0; });
+    if (!ok || !fits(h.stringData, section<uint32_t>(h.stringOffsets)[h.stringCount], 1))
+        throw std::invalid_argument("Error: Corrupt snapshot file.");
+
+    // One pass over the index arrays, so that no query can read out of bounds.
+    auto corrupt = [](const char *what) {
+        throw std::invalid_argument(std::string("Error: Corrupt snapshot file: bad ") + what + ".");
+    };
+    auto monotonic = [](const uint32_t *offsets, uint32_t count, uint64_t limit) {
+        for (uint32_t i = 0; i < count; ++i) {
+            if (offsets[i] > offsets[i + 1])
+                return false;
+        }
+        return offsets[0] == 0 && offsets[count] <= limit;
+    };
+    auto indexes = [](const uint32_t *ids, uint32_t count, uint32_t limit) {
+        return std::all_of(ids, ids + count, [limit](uint32_t id) { return id < limit; });
+    };
+    const uint32_t *stringOffsets = section<uint32_t>(h.stringOffsets);
+    if (!monotonic(stringOffsets, h.stringCount, stringOffsets[h.stringCount]))
+        corrupt("string offsets");
+    const SnapshotLine *lines = section<SnapshotLine>(h.lines);
+    for (uint32_t li = 0; li < h.lineCount; ++li) {
+        const SnapshotLine &l = lines[li];
+        if (l.name >= h.stringCount || l.firstNode > h.nodeCount || l.nodeCount > h.nodeCount - l.firstNode)
+            corrupt("line record");
+    }
+    if (!indexes(section<uint32_t>(h.linesByName), h.lineCount, h.lineCount))
+        corrupt("line name index");
+    const SnapshotNode *nodes = section<SnapshotNode>(h.nodes);
+    for (uint32_t u = 0; u < h.nodeCount; ++u) {
+        const SnapshotNode &n = nodes[u];
+        if (n.name >= h.stringCount || n.type >= h.stringCount || n.line >= h.lineCount)
+            corrupt("station record");
+    }
+    if (!indexes(section<uint32_t>(h.nodesByLineName), h.nodeCount, h.nodeCount))
+        corrupt("station index by line");
+    if (!indexes(section<uint32_t>(h.nodesByName), h.nodeCount, h.nodeCount))
+        corrupt("station index by name");
+    if (!monotonic(section<uint32_t>(h.edgeOffsets), h.nodeCount, h.edgeCount) ||
+        !indexes(section<uint32_t>(h.edgeTargets), h.edgeCount, h.nodeCount))
+        corrupt("routing edges");
+    if (!monotonic(section<uint32_t>(h.connectionOffsets), h.nodeCount, h.connectionCount))
+        corrupt("connection offsets");
+    const SnapshotConnection *connections = section<SnapshotConnection>(h.connections);
+    for (uint32_t i = 0; i < h.connectionCount; ++i) {
+        if (connections[i].station >= h.stringCount || connections[i].line >= h.stringCount)
+            corrupt("connection");
+    }
+}
+
+std::string_view SnapshotView::str(uint32_t id) const noexcept {
+    const uint32_t *offsets = section<uint32_t>(header().stringOffsets);
+    return std::string_view(section<char>(header().stringData) + offsets[id], offsets[id + 1] - offsets[id]);
+}
+
+SnapshotStation SnapshotView::stationAt(uint32_t node) const noexcept {
+    const SnapshotNode &n = section<SnapshotNode>(header().nodes)[node];
+    const SnapshotLine &l = section<SnapshotLine>(header().lines)[n.line];
+    return SnapshotStation{str(n.name), str(n.type), str(l.name), node};
+}
+
+std::optional<uint32_t> SnapshotView::lineId(std::string_view lineName) const noexcept {
+    const uint32_t *first = section<uint32_t>(header().linesByName);
+    const uint32_t *last = first + header().lineCount;
+    const SnapshotLine *lines = section<SnapshotLine>(header().lines);
+    auto it = std::lower_bound(first, last, lineName,
+                               [&](uint32_t id, std::string_view key) { return str(lines[id].name) < key; });
+    if (it == last || str(lines[*it].name) != lineName)
+        return std::nullopt;
+    return *it;
+}
+
+std::optional<uint32_t> SnapshotView::nodeOnLine(uint32_t line, std::string_view stationName) const noexcept {
+    const SnapshotLine &l = section<SnapshotLine>(header().lines)[line];
+    const SnapshotNode *nodes = section<SnapshotNode>(header().nodes);
+    const uint32_t *first = section<uint32_t>(header().nodesByLineName) + l.firstNode;
+    const uint32_t *last = first + l.nodeCount;
+    auto it = std::lower_bound(first, last, stationName,
+                               [&](uint32_t id, std::string_view key) { return str(nodes[id].name) < key; });
+    if (it == last || str(nodes[*it].name) != stationName)
+        return std::nullopt;
+    return *it;
+}
+
+std::optional<SnapshotStation> SnapshotView::findStationOnLine(std::string_view lineName,
+                                                               std::string_view stationName) const {
+    auto line = lineId(lineName);
+    if (!line)
+        return std::nullopt;
+    auto node = nodeOnLine(*line, stationName);
+    if (!node)
+        return std::nullopt;
+    return stationAt(*node);
+}
+
+std::optional<SnapshotStation> SnapshotView::findTransitionStationByName(std::string_view stationName) const {
+    const SnapshotNode *nodes = section<SnapshotNode>(header().nodes);
+    const uint32_t *first = section<uint32_t>(header().nodesByName);
+    const uint32_t *last = first + header().nodeCount;
+    auto it = std::lower_bound(first, last, stationName,
+                               [&](uint32_t id, std::string_view key) { return str(nodes[id].name) < key; });
+    for (; it != last && str(nodes[*it].name) == stationName; ++it) {
+        if (str(nodes[*it].type) == "transition")
+            return stationAt(*it);
+    }
+    return std::nullopt;
+}
+
+std::string SnapshotView::getConnections(uint32_t node) const {
+    const uint32_t *offsets = section<uint32_t>(header().connectionOffsets);
+    const SnapshotConnection *conns = section<SnapshotConnection>(header().connections);
+    std::string result;
+    for (uint32_t i = offsets[node]; i < offsets[node + 1]; ++i) {
+        result += str(conns[i].station);
+        result += '-';
+        result += str(conns[i].line);
+        result += '\n';
+    }
+    return result;
+}
+
+std::string SnapshotView::getSystemDescription() const {
+    std::string result;
+    mgc::TextSink out(result);
+    writeSystemDescription(out);
+    return result;
+}
+
+void SnapshotView::writeSystemDescription(mgc::TextSink &out) const {
+    const SnapshotHeader &h = header();
+    const SnapshotLine *lines = section<SnapshotLine>(h.lines);
+    const SnapshotNode *nodes = section<SnapshotNode>(h.nodes);
+    if (out.appendsToString()) {
+        size_t total = 0;
+        for (uint32_t li = 0; li < h.lineCount; ++li)
+            total += 8 + str(lines[li].name).size();
+        for (uint32_t u = 0; u < h.nodeCount; ++u)
+            total += 2 + str(nodes[u].name).size() + str(nodes[u].type).size();
+        out.reserve(total);
+    }
+    for (uint32_t li = 0; li < h.lineCount; ++li) {
+        out.append("Line: ");
+        out.append(str(lines[li].name));
+        out.put('\n');
+        for (uint32_t u = lines[li].firstNode; u < lines[li].firstNode + lines[li].nodeCount; ++u) {
+            out.append(str(nodes[u].name));
+            out.put('-');
+            out.append(str(nodes[u].type));
+            out.put('\n');
+        }
+        out.put('\n');
+    }
+}
+
+RouteGraphView SnapshotView::routeGraph() const noexcept {
+    const SnapshotHeader &h = header();
+    return RouteGraphView{h.nodeCount, section<uint32_t>(h.edgeOffsets), section<uint32_t>(h.edgeTargets),
+                          section<uint8_t>(h.edgeKinds)};
+}
+
+std::optional<Route> SnapshotView::findRoute(std::string_view fromLine, std::string_view fromStation,
+                                             std::string_view toLine, std::string_view toStation,
+                                             RouteCost cost) const {
+    auto from = findStationOnLine(fromLine, fromStation);
+    auto to = findStationOnLine(toLine, toStation);
+    if (!from || !to)
+        throw std::invalid_argument("Error: Station not found on this line.");
+    auto path = finder.search(routeGraph(), std::span(&from->node, 1), std::span(&to->node, 1), cost);
+    if (!path)
+        return std::nullopt;
+    Route route;
+    route.path.reserve(path->nodes.size());
+    for (uint32_t u : path->nodes) {
+        SnapshotStation st = stationAt(u);
+        route.path.push_back(RouteStop{string(st.line), string(st.name)});
+    }
+    route.stopCount = path->stopCount;
+    route.transferCount = path->transferCount;
+    return route;
+}
+
+} // namespace mgm
@@ -0,0 +1,207 @@
+#ifndef SNAPSHOT_HPP_
+#define SNAPSHOT_HPP_
+
+#include "../Metro_system/metro_system.hpp"
+#include "../routing/route_graph.hpp"
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+/**
+ * @file snapshot.hpp
+ * @brief Versioned binary snapshots of a metro system and a zero-copy reader for them.
+ *
+ * File layout (native byte order, every section 8-byte aligned):
+ * - SnapshotHeader: magic, version, counts and section offsets;
+ * - string table: @c stringCount + 1 offsets into a blob of all distinct names and types;
+ * - line records in node order, and line IDs sorted by line name;
+ * - node records (one per station on a line, consecutive per line), and per line
+ *   the node IDs sorted by station name, plus all node IDs sorted by station name;
+ * - routing CSR arrays (offsets, targets, edge kinds) as in RouteGraph;
+ * - transfer_hub connections per node, as (station name, line name) string IDs.
+ */
+
+namespace mgm {
+
+/**
+ * @brief Fixed-size header at the start of a snapshot file.
+ */
+struct SnapshotHeader {
+    char magic[8];           ///< "MGMSNAP" followed by a zero byte.
+    uint32_t version;        ///< Format version, SnapshotVersion.
+    uint32_t lineCount;      ///< Number of lines.
+    uint32_t nodeCount;      ///< Number of stations on lines.
+    uint32_t stringCount;    ///< Number of interned strings.
+    uint32_t edgeCount;      ///< Number of routing edges.
+    uint32_t connectionCount;///< Number of transfer_hub connections.
+    uint64_t stringOffsets;  ///< uint32_t[stringCount + 1].
+    uint64_t stringData;     ///< Concatenated string bytes.
+    uint64_t lines;          ///< SnapshotLine[lineCount].
+    uint64_t linesByName;    ///< uint32_t[lineCount].
+    uint64_t nodes;          ///< SnapshotNode[nodeCount].
+    uint64_t nodesByLineName;///< uint32_t[nodeCount], sorted by name within each line.
+    uint64_t nodesByName;    ///< uint32_t[nodeCount], sorted by name.
+    uint64_t edgeOffsets;    ///< uint32_t[nodeCount + 1].
+    uint64_t edgeTargets;    ///< uint32_t[edgeCount].
+    uint64_t edgeKinds;      ///< uint8_t[edgeCount].
+    uint64_t connectionOffsets; ///< uint32_t[nodeCount + 1].
+    uint64_t connections;    ///< SnapshotConnection[connectionCount].
+    uint64_t fileSize;       ///< Total size of the file in bytes.
+};
+
+/// Current snapshot format version.
+inline constexpr uint32_t SnapshotVersion = 1;
+
+/**
+ * @brief A line record: its name and its range of nodes.
+ */
+struct SnapshotLine {
+    uint32_t name;      ///< String ID of the line name.
+    uint32_t firstNode; ///< First node of the line.
+    uint32_t nodeCount; ///< Number of stations on the line.
+};
+
+/**
+ * @brief A station record.
+ */
+struct SnapshotNode {
+    uint32_t name; ///< String ID of the station name.
+    uint32_t type; ///< String ID of the station type.
+    uint32_t line; ///< Index of the line record.
+};
+
+/**
+ * @brief A transfer_hub connection of a station.
+ */
+struct SnapshotConnection {
+    uint32_t station; ///< String ID of the target station name.
+    uint32_t line;    ///< String ID of the target line name.
+};
+
+/**
+ * @brief A station as seen through a SnapshotView.
+ */
+struct SnapshotStation {
+    std::string_view name; ///< The station name.
+    std::string_view type; ///< The station type.
+    std::string_view line; ///< The name of the line it is on.
+    uint32_t node;         ///< Its node ID in the routing graph.
+};
+
+/**
+ * @brief Writes a binary snapshot of a system.
+ * @param system The system to save.
+ * @param path Path of the file to create or overwrite.
+ * @throws std::invalid_argument if the file cannot be written.
+ */
+void saveSnapshot(const MetroSystem &system, const string &path);
+
+/**
+ * @brief Read-only view of a snapshot file mapped into memory.
+ *
+ * Opening maps the file and checks its header and index arrays in one pass
+ * without allocating; queries read the mapped pages directly, so no station
+ * objects are created. The view is movable but not copyable.
+ */
+class SnapshotView {
+public:
+    /**
+     * @brief Maps a snapshot file.
+     * @param path Path of the snapshot file.
+     * @throws std::invalid_argument if the file cannot be mapped or is not a valid snapshot.
+     */
+    explicit SnapshotView(const string &path);
+
+    ~SnapshotView();
+    SnapshotView(SnapshotView &&other) noexcept;
+    SnapshotView &operator=(SnapshotView &&other) noexcept;
+    SnapshotView(const SnapshotView &) = delete;
+    SnapshotView &operator=(const SnapshotView &) = delete;
+
+    /**
+     * @brief Gets the number of lines.
+     * @return The line count.
+     */
+    uint32_t lineCount() const noexcept { return header().lineCount; }
+
+    /**
+     * @brief Gets the number of stations on lines.
+     * @return The station count.
+     */
+    uint32_t stationCount() const noexcept { return header().nodeCount; }
+
+    /**
+     * @brief Finds a station by name on a specified line.
+     * @param lineName The name of the line.
+     * @param stationName The name of the station.
+     * @return The station, or std::nullopt if the line or station is not found.
+     */
+    std::optional<SnapshotStation> findStationOnLine(std::string_view lineName,
+                                                     std::string_view stationName) const;
+
+    /**
+     * @brief Finds a transition station by name across all lines.
+     * @param stationName The name of the transition station.
+     * @return The station, or std::nullopt if there is none.
+     */
+    std::optional<SnapshotStation> findTransitionStationByName(std::string_view stationName) const;
+
+    /**
+     * @brief Gets the transfer_hub connections of a station, as "station-line" lines.
+     * @param node The node ID of the station.
+     * @return The connections, in the format of transfer_hub::get_stations_lines_names().
+     */
+    std::string getConnections(uint32_t node) const;
+
+    /**
+     * @brief Gets a string description of the system, in the format of MetroSystem.
+     * @return The description.
+     */
+    std::string getSystemDescription() const;
+
+    /**
+     * @brief Writes the system description to a sink, in the format of MetroSystem.
+     * @param out The sink; a string sink is grown once to the size of the description.
+     */
+    void writeSystemDescription(mgc::TextSink &out) const;
+
+    /**
+     * @brief Gets the routing graph stored in the snapshot.
+     * @return A view of the mapped CSR arrays.
+     */
+    RouteGraphView routeGraph() const noexcept;
+
+    /**
+     * @brief Finds the cheapest route between two stations on given lines.
+     * @param fromLine The line of the origin station.
+     * @param fromStation The origin station.
+     * @param toLine The line of the destination station.
+     * @param toStation The destination station.
+     * @param cost The cost model.
+     * @return The route, or std::nullopt if the destination is unreachable.
+     * @throws std::invalid_argument if a line or station is not found.
+     */
+    std::optional<Route> findRoute(std::string_view fromLine, std::string_view fromStation,
+                                   std::string_view toLine, std::string_view toStation,
+                                   RouteCost cost = RouteCost::FewestStops) const;
+
+private:
+    const SnapshotHeader &header() const noexcept { return *reinterpret_cast<const SnapshotHeader *>(base); }
+    template <typename T>
+    const T *section(uint64_t offset) const noexcept { return reinterpret_cast<const T *>(base + offset); }
+    std::string_view str(uint32_t id) const noexcept;
+    SnapshotStation stationAt(uint32_t node) const noexcept;
+    std::optional<uint32_t> lineId(std::string_view lineName) const noexcept;
+    std::optional<uint32_t> nodeOnLine(uint32_t line, std::string_view stationName) const noexcept;
+    void validate() const;
+    void unmap() noexcept;
+
+    const char *base = nullptr;
+    size_t size = 0;
+    mutable RouteFinder finder; ///< Search state reused by findRoute().
+};
+
+} // namespace mgm
+
+#endif
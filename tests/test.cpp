@@ -1,7 +1,10 @@
 #include <gtest/gtest.h>
 #include "../container/lookUpTable.hpp"
 using namespace mgc;
+#include <memory>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 
 TEST(LookupTableTest, EmptyTable) {
     LookupTable<std::string, int> table;
@@ -190,9 +193,271 @@ TEST(LookupTableTest, MoveAssignment) {
     EXPECT_TRUE(table.empty());
 }
 
+TEST(HashedLookupTableTest, FindAndEraseByKey) {
+    HashedLookupTable<std::string, int> table;
+    for (int i = 0; i < 100; ++i) {
+        table.insert("key" + std::to_string(i), i);
+    }
+    EXPECT_EQ(table.find("key42"), 42u);
+    EXPECT_EQ(table.find("missing"), table.size());
+    EXPECT_TRUE(table.erase("key10"));
+    EXPECT_FALSE(table.erase("key10"));
+    EXPECT_EQ(table.find("key10"), table.size());
+    // Slots behind the erased one are shifted down, as in the linear table.
+    EXPECT_EQ(table.find("key42"), 41u);
+    EXPECT_EQ(table[41].second, 42);
+    EXPECT_EQ(table.front().first, "key0");
+    EXPECT_EQ(table.back().first, "key99");
+}
+
+TEST(HashedLookupTableTest, DuplicatesCopyAndClear) {
+    HashedLookupTable<std::string, int> table;
+    table.insert("dup", 1);
+    table.insert("other", 2);
+    table.insert("dup", 3);
+    EXPECT_EQ(table.find("dup"), 0u);
+    table.erase(size_t{0});
+    EXPECT_EQ(table.find("dup"), 1u);
+    EXPECT_EQ(table[table.find("dup")].second, 3);
+
+    HashedLookupTable<std::string, int> copy(table);
+    EXPECT_EQ(copy.find("other"), 0u);
+    HashedLookupTable<std::string, int> moved(std::move(copy));
+    EXPECT_EQ(moved.find("dup"), 1u);
+    EXPECT_EQ(copy.find("dup"), copy.size());
+
+    moved.clear();
+    EXPECT_EQ(moved.find("other"), moved.size());
+    moved.insert("fresh", 7);
+    EXPECT_EQ(moved.find("fresh"), 0u);
+}
+
+/// Hash that fails on one key, as a throwing hash or a failed allocation would.
+struct FailingHash {
+    size_t operator()(const std::string& key) const {
+        if (key == "fail") {
+            throw std::runtime_error("hash failed");
+        }
+        return std::hash<std::string>{}(key);
+    }
+};
+
+TEST(HashedLookupTableTest, FailedInsertDestroysThePair) {
+    HashedLookupTable<std::string, std::shared_ptr<int>, FailingHash> table;
+    auto value = std::make_shared<int>(1);
+    table.insert("kept", value);
+    EXPECT_THROW(table.insert("fail", value), std::runtime_error);
+    EXPECT_THROW(table.emplace("fail", value), std::runtime_error);
+    EXPECT_EQ(value.use_count(), 2);
+    EXPECT_EQ(table.size(), 1u);
+    EXPECT_EQ(table.find("kept"), 0u);
+}
+
+TEST(FingerprintLookupTableTest, FindEraseAndDuplicates) {
+    FingerprintLookupTable<std::string, int> table;
+    for (int i = 0; i < 100; ++i) {
+        table.insert("key" + std::to_string(i), i);
+    }
+    table.insert("key7", 700);
+    EXPECT_EQ(table.find("key42"), 42u);
+    EXPECT_EQ(table.find("key7"), 7u);
+    EXPECT_EQ(table.find("missing"), table.size());
+    EXPECT_TRUE(table.erase("key10"));
+    EXPECT_EQ(table.find("key10"), table.size());
+    EXPECT_EQ(table.find("key42"), 41u);
+    EXPECT_TRUE(table.erase("key7"));
+    EXPECT_EQ(table[table.find("key7")].second, 700);
+
+    FingerprintLookupTable<std::string, int> copy(table);
+    EXPECT_EQ(copy.find("key99"), table.find("key99"));
+    copy.clear();
+    EXPECT_EQ(copy.find("key99"), copy.size());
+
+    // A pair whose fingerprint cannot be recorded is destroyed, not leaked.
+    FingerprintLookupTable<std::string, std::shared_ptr<int>, FailingHash> failing;
+    auto value = std::make_shared<int>(1);
+    failing.insert("kept", value);
+    EXPECT_THROW(failing.insert("fail", value), std::runtime_error);
+    EXPECT_THROW(failing.emplace("fail", value), std::runtime_error);
+    EXPECT_EQ(value.use_count(), 2);
+    EXPECT_EQ(failing.size(), 1u);
+    EXPECT_EQ(failing.find("kept"), 0u);
+}
+
+TEST(UnorderedLookupTableTest, EraseSwapsInLastAndReplaceKeepsSlot) {
+    UnorderedHashedLookupTable<std::string, int> table;
+    for (int i = 0; i < 50; ++i) {
+        table.insert("key" + std::to_string(i), i);
+    }
+    EXPECT_TRUE(table.erase("key3"));
+    EXPECT_EQ(table.size(), 49u);
+    EXPECT_EQ(table.find("key3"), table.size());
+    EXPECT_EQ(table.find("key49"), 3u);
+    EXPECT_EQ(table[3].second, 49);
+    table.erase(table.size() - 1);
+    EXPECT_EQ(table.find("key48"), table.size());
+    for (int i = 0; i < 48; ++i) {
+        if (i != 3) {
+            EXPECT_EQ(table[table.find("key" + std::to_string(i))].second, i);
+        }
+    }
+
+    table.replace(0, "fresh", 100);
+    EXPECT_EQ(table.find("key0"), table.size());
+    EXPECT_EQ(table.find("fresh"), 0u);
+    EXPECT_EQ(table[0].second, 100);
+    EXPECT_THROW(table.replace(table.size(), "x", 1), std::out_of_range);
+
+    FingerprintLookupTable<std::string, int> fingerprints;
+    fingerprints.insert("a", 1);
+    fingerprints.insert("b", 2);
+    fingerprints.replace(0, "c", 3);
+    EXPECT_EQ(fingerprints.find("a"), fingerprints.size());
+    EXPECT_EQ(fingerprints.find("c"), 0u);
+    EXPECT_EQ(fingerprints.find("b"), 1u);
+}
+
+TEST(HashedLookupTableTest, EraseIfKeepsOrder) {
+    HashedLookupTable<int, int> table;
+    for (int i = 0; i < 20; ++i) {
+        table.insert(i, i * 10);
+    }
+    EXPECT_EQ(table.eraseIf([](const auto &pair) { return pair.first % 3 == 0; }), 7u);
+    ASSERT_EQ(table.size(), 13u);
+    EXPECT_EQ(table[0].first, 1);
+    EXPECT_EQ(table[1].first, 2);
+    EXPECT_EQ(table[2].first, 4);
+    EXPECT_EQ(table.find(19), 12u);
+    EXPECT_EQ(table.find(9), table.size());
+    EXPECT_EQ(table.eraseIf([](const auto &) { return false; }), 0u);
+}
+
+TEST(HashedLookupTableTest, TransparentLookupByStringView) {
+    HashedLookupTable<std::string, int, StringHash, std::equal_to<>> table;
+    FingerprintLookupTable<std::string, int, StringHash, std::equal_to<>> small;
+    for (int i = 0; i < 40; ++i) {
+        table.insert("key" + std::to_string(i), i);
+        small.insert("key" + std::to_string(i), i);
+    }
+    std::string buffer = "key7 key39 nokey";
+    std::string_view text(buffer);
+    EXPECT_EQ(table.find(text.substr(0, 4)), 7u);
+    EXPECT_EQ(small.find(text.substr(5, 5)), 39u);
+    EXPECT_EQ(table.find(text.substr(11)), table.size());
+    EXPECT_TRUE(table.erase(text.substr(0, 4)));
+    EXPECT_EQ(table.find(std::string("key39")), 38u);
+
+    LookupTable<std::string, int> linear;
+    linear.insert("alpha", 1);
+    EXPECT_EQ(linear.find(std::string_view("alpha")), 0u);
+    EXPECT_TRUE(linear.erase(std::string_view("alpha")));
+    EXPECT_TRUE(linear.empty());
+}
+
+TEST(ByteScanTest, AllImplementationsAgree) {
+    std::vector<uint8_t> bytes(100, 0);
+    for (ByteScan scan : {ByteScan::Scalar, ByteScan::SSE2, ByteScan::AVX2}) {
+        if (!byteScanSupported(scan)) {
+            continue;
+        }
+        for (size_t pos = 0; pos < bytes.size(); ++pos) {
+            bytes[pos] = 0xAB;
+            EXPECT_EQ(findByte(scan, bytes.data(), 0, bytes.size(), 0xAB), pos);
+            EXPECT_EQ(findByte(scan, bytes.data(), pos + 1, bytes.size(), 0xAB), bytes.size());
+            EXPECT_EQ(findByte(scan, bytes.data(), 0, pos, 0xAB), pos);
+            bytes[pos] = 0;
+        }
+    }
+    EXPECT_TRUE(byteScanSupported(bestByteScan()));
+}
+
+#include "../container/arena.hpp"
+
+TEST(ArenaTest, PacksAndReusesBlocks) {
+    Arena arena(1024);
+    void *a = arena.allocate(48, 8);
+    void *b = arena.allocate(48, 8);
+    EXPECT_EQ(static_cast<char *>(b) - static_cast<char *>(a), 48);
+    void *c = arena.allocate(20, 16);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(c) % 16, 0u);
+    arena.deallocate(a, 48, 8);
+    EXPECT_EQ(arena.allocate(48, 8), a);
+    EXPECT_EQ(arena.bytesReserved(), 1024u);
+    arena.allocate(4096, 8);
+    EXPECT_GT(arena.bytesReserved(), 1024u + 4096u);
+}
+
+#include "../container/persistentMap.hpp"
+
+TEST(PersistentMapTest, CopiesShareUntilEdited) {
+    PersistentMap<int, int, std::hash<int>, 4> map;
+    for (int i = 0; i < 100; ++i) {
+        map.edit(i) = i;
+    }
+    PersistentMap<int, int, std::hash<int>, 4> copy(map);
+    EXPECT_EQ(copy.find(7), map.find(7));
+    EXPECT_EQ(copy.findForEdit(1000), nullptr);
+    EXPECT_FALSE(copy.erase(1000));
+
+    *copy.findForEdit(7) = -7;
+    EXPECT_TRUE(copy.erase(8));
+    copy.edit(1000) = 1;
+    EXPECT_EQ(*map.find(7), 7);
+    EXPECT_EQ(*copy.find(7), -7);
+    EXPECT_NE(map.find(8), nullptr);
+    EXPECT_EQ(map.find(1000), nullptr);
+    EXPECT_EQ(map.size(), 100u);
+    EXPECT_EQ(copy.size(), 100u);
+    EXPECT_EQ(*copy.find(50), 50);
+
+    size_t visited = 0;
+    copy.forEach([&visited](int, int) { ++visited; });
+    EXPECT_EQ(visited, copy.size());
+    copy.clear();
+    EXPECT_TRUE(copy.empty());
+    EXPECT_EQ(map.size(), 100u);
+}
+
+#include "../container/symbolTable.hpp"
+
+TEST(SymbolTableTest, InternFindAndCompare) {
+    Symbol a("SymbolTableTest_A");
+    Symbol b(std::string("SymbolTableTest_") + "A");
+    EXPECT_EQ(a, b);
+    EXPECT_EQ(a.str(), "SymbolTableTest_A");
+    EXPECT_TRUE(a == "SymbolTableTest_A");
+    EXPECT_EQ(&a.str(), &b.str());
+    EXPECT_NE(a, Symbol("SymbolTableTest_B"));
+    EXPECT_EQ(Symbol().str(), "");
+
+    EXPECT_EQ(Symbol::find("SymbolTableTest_A"), a);
+    size_t before = SymbolTable::instance().size();
+    EXPECT_FALSE(Symbol::find("SymbolTableTest_never_interned").has_value());
+    EXPECT_EQ(SymbolTable::instance().size(), before);
+
+    // References stay valid while the table grows past a chunk.
+    const std::string &text = a.str();
+    for (int i = 0; i < 5000; ++i)
+        Symbol("SymbolTableTest_fill_" + std::to_string(i));
+    EXPECT_EQ(text, "SymbolTableTest_A");
+    EXPECT_EQ(Symbol::fromId(a.id()), a);
+}
+
 #include "../Stations/station.hpp"
 #include "../Stations/transitionstation.hpp"
 #include "../Metro_system/metro_system.hpp"
+#include "../Metro_system/shared_metro_system.hpp"
+#include "../loader/network_loader.hpp"
+#include "../loader/network_generator.hpp"
+#include "../snapshot/snapshot.hpp"
+#include "../UI/batch_runner.hpp"
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <thread>
+#include <unistd.h>
 
 using std::string;
 using namespace mgm;
@@ -203,6 +468,10 @@ TEST(StationTest, BasicFunctionality) {
     EXPECT_EQ(s.getType(), "Direct");
     s.setName("NewCentral");
     EXPECT_EQ(s.getName(), "NewCentral");
+    EXPECT_EQ(s.getNameSymbol(), mgc::Symbol("NewCentral"));
+    EXPECT_EQ(s.getKind(), StationKind::Direct);
+    EXPECT_EQ(transition_station("Hub").getKind(), StationKind::Transition);
+    EXPECT_EQ(station("Depot", "service").getKind(), StationKind::Other);
 }
 
 TEST(TransitionStationTest, TransferHubFunctions) {
@@ -249,6 +518,34 @@ TEST(MetroLineTest, AddFindRemoveStation) {
     EXPECT_THROW(line.find("Station1"), std::invalid_argument);
 }
 
+TEST(MetroLineTest, ColumnsFollowStationTable) {
+    Line line("BlueLine");
+    line.addElement(station("A"));
+    line.addElement(transition_station("B"));
+    line.addElement(station("C", "service"));
+    line.addElement(transition_station("D"));
+    EXPECT_THROW(line.addElement(station("A")), std::invalid_argument);
+    ASSERT_EQ(line.getKindColumn().size(), 4u);
+
+    line.removeElement("B");
+    ASSERT_EQ(line.getNameColumn().size(), line.getStations().size());
+    for (size_t slot = 0; slot < line.getStations().size(); ++slot) {
+        const station &st = *line.getStations()[slot].second;
+        EXPECT_EQ(line.getNameColumn()[slot], st.getNameSymbol());
+        EXPECT_EQ(line.getTypeColumn()[slot], st.getTypeSymbol());
+        EXPECT_EQ(line.getKindColumn()[slot], st.getKind());
+    }
+    EXPECT_EQ(line.countOfKind(StationKind::Transition), 1u);
+    EXPECT_EQ(line.slotsOfKind(StationKind::Transition), std::vector<size_t>{2});
+    EXPECT_EQ(line.getTableStr(), "A-Direct\nC-service\nD-transition\n");
+
+    Line dense("Dense");
+    for (int i = 0; i < 3001; ++i)
+        dense.addElement(station("Dense" + std::to_string(i)));
+    EXPECT_EQ(dense.countOfKind(StationKind::Direct), 3001u);
+    EXPECT_EQ(dense.slotsOfKind(StationKind::Direct).back(), 3000u);
+}
+
 TEST(MetroSystemTest, BasicOperations) {
     MetroSystem system;
     
@@ -302,6 +599,947 @@ TEST(MetroSystemTest, FindTransitionStation) {
     EXPECT_EQ(ts->getType(), "transition");
 }
 
+TEST(MetroSystemTest, LookupsByViewDoNotIntern) {
+    MetroSystem system;
+    system.addLine("ViewLine");
+    system.addStationToLine("ViewLine", station("ViewStation", "Direct"));
+    std::string request = "ViewLine ViewStation ViewNeverAdded";
+    std::string_view fields(request);
+    size_t symbols = SymbolTable::instance().size();
+    EXPECT_EQ(system.findStationOnLine(fields.substr(0, 8), fields.substr(9, 11))->getName(), "ViewStation");
+    EXPECT_EQ(system.tryFindStationOnLine(fields.substr(0, 8), fields.substr(21)), nullptr);
+    EXPECT_EQ(system.tryFindLine(fields.substr(21)), nullptr);
+    EXPECT_THROW(system.removeStationFromLine(fields.substr(0, 8), fields.substr(21)), std::invalid_argument);
+    EXPECT_EQ(SymbolTable::instance().size(), symbols);
+    system.removeStationFromLine(fields.substr(0, 8), fields.substr(9, 11));
+    EXPECT_TRUE(system.findLine("ViewLine").getStations().empty());
+}
+
+TEST(MetroSystemTest, StationIndexFollowsMutations) {
+    MetroSystem system;
+    system.addLine("Red");
+    system.addLine("Blue");
+    system.addStationToLine("Red", station("Hub"));
+    system.addStationToLine("Blue", transition_station("Hub"));
+    system.addStationToLine("Blue", station("Other"));
+
+    EXPECT_EQ(system.findLinesOfStation("Hub").size(), 2u);
+    EXPECT_EQ(system.tryFindTransitionStationByName("Hub"),
+              system.findStationOnLine("Blue", "Hub"));
+    EXPECT_EQ(system.tryFindStationOnLine("Red", "Missing"), nullptr);
+    EXPECT_EQ(system.tryFindStationOnLine("Green", "Hub"), nullptr);
+    EXPECT_EQ(system.tryFindTransitionStationByName("Other"), nullptr);
+
+    system.modifyStationInLine("Blue", "Hub", "Renamed", "Direct");
+    EXPECT_EQ(system.tryFindTransitionStationByName("Hub"), nullptr);
+    EXPECT_THROW(system.findTransitionStationByName("Hub"), std::invalid_argument);
+    ASSERT_EQ(system.findLinesOfStation("Renamed").size(), 1u);
+    EXPECT_EQ(system.findLinesOfStation("Renamed")[0], "Blue");
+
+    system.modifyStationInLine("Red", "Hub", "Hub", "transition");
+    EXPECT_NE(system.tryFindTransitionStationByName("Hub"), nullptr);
+
+    MetroSystem copy(system);
+    system.removeLine("Red");
+    EXPECT_TRUE(system.findLinesOfStation("Hub").empty());
+    EXPECT_EQ(system.tryFindTransitionStationByName("Hub"), nullptr);
+    EXPECT_NE(copy.tryFindTransitionStationByName("Hub"), nullptr);
+
+    system.removeStationFromLine("Blue", "Other");
+    EXPECT_TRUE(system.findLinesOfStation("Other").empty());
+}
+
+TEST(MetroSystemTest, CopiesAreIndependent) {
+    MetroSystem system;
+    system.addLine("Red");
+    system.addLine("Blue");
+    system.addStationToLine("Red", transition_station("Hub"));
+    system.addStationToLine("Red", station("A"));
+    system.addStationToLine("Blue", transition_station("Hub"));
+    system.addTransfer("Red", "Hub", "Hub", "Blue");
+    system.setStationCopyOnWrite(true);
+    std::string description = system.getSystemDescription();
+
+    MetroSystem copy(system);
+    copy.removeStationFromLine("Red", "A");
+    copy.modifyStationInLine("Blue", "Hub", "Renamed", "Direct");
+    copy.addLine("Green");
+    copy.validateSystem();
+
+    EXPECT_EQ(system.getSystemDescription(), description);
+    EXPECT_NE(system.tryFindStationOnLine("Red", "A"), nullptr);
+    EXPECT_EQ(system.findLinesOfStation("Hub").size(), 2u);
+    EXPECT_EQ(system.tryFindStationOnLine("Green", "Hub"), nullptr);
+    EXPECT_EQ(copy.tryFindStationOnLine("Red", "A"), nullptr);
+    EXPECT_EQ(copy.findLinesOfStation("Hub").size(), 1u);
+    ASSERT_EQ(copy.findLinesOfStation("Renamed").size(), 1u);
+    EXPECT_TRUE(system.findLinesOfStation("Renamed").empty());
+}
+
+TEST(MetroSystemTest, DescriptionWritersAgree) {
+    MetroSystem system;
+    system.addLine("Red");
+    system.addStationToLine("Red", station("A"));
+    system.addStationToLine("Red", station("B", "transition"));
+    system.addLine("Long");
+    for (int i = 0; i < 2000; ++i)
+        system.addStationToLine("Long", station("Long" + std::to_string(i)));
+    string expected;
+    for (const auto &[name, line] : system.getLines())
+        expected += "Line: " + name.str() + "\n" + line.getTableStr() + "\n";
+    string description = system.getSystemDescription();
+    EXPECT_EQ(description, expected);
+    EXPECT_EQ(system.getSystemDescriptionSize(), description.size());
+
+    string buffer = "kept:";
+    {
+        mgc::TextSink out(buffer);
+        system.writeSystemDescription(out);
+        EXPECT_EQ(out.written(), description.size());
+    }
+    EXPECT_EQ(buffer, "kept:" + description);
+
+    std::ostringstream stream;
+    system.writeSystemDescription(stream) << "end";
+    EXPECT_EQ(stream.str(), description + "end");
+    std::ostringstream table;
+    system.findLine("Red").showTable(table);
+    EXPECT_EQ(table.str(), "A-Direct\nB-transition\n");
+
+    std::FILE *file = std::tmpfile();
+    ASSERT_NE(file, nullptr);
+    system.writeSystemDescription(fileno(file));
+    std::rewind(file);
+    string fromFile(description.size() + 1, '\0');
+    fromFile.resize(std::fread(fromFile.data(), 1, fromFile.size(), file));
+    std::fclose(file);
+    EXPECT_EQ(fromFile, description);
+}
+
+TEST(SharedMetroSystemTest, VersionsAreIsolated) {
+    MetroSystem initial;
+    initial.addLine("Red");
+    initial.addStationToLine("Red", station("A"));
+    initial.addStationToLine("Red", transition_station("Hub"));
+    SharedMetroSystem shared(std::move(initial));
+    EXPECT_EQ(shared.version(), 1u);
+
+    auto before = shared.snapshot();
+    auto hub = before->findStationOnLine("Red", "Hub");
+    EXPECT_EQ(shared.update([](MetroSystem &system) {
+        system.addLine("Blue");
+        system.addStationToLine("Blue", station("B"));
+        system.addTransfer("Red", "Hub", "B", "Blue");
+        system.addTransfer("Red", "Hub", "Gone", "Blue");
+    }), 2u);
+    auto after = shared.snapshot();
+    EXPECT_EQ(before->tryFindLine("Blue"), nullptr);
+    EXPECT_TRUE(dynamic_cast<transition_station &>(*hub).get_station_list().empty());
+    EXPECT_EQ(dynamic_cast<transition_station &>(*after->findStationOnLine("Red", "Hub")).get_station_list().size(), 2u);
+
+    shared.update([](MetroSystem &system) { EXPECT_EQ(system.validateSystem(ValidationMode::Full), 1u); });
+    EXPECT_EQ(dynamic_cast<transition_station &>(*after->findStationOnLine("Red", "Hub")).get_station_list().size(), 2u);
+    EXPECT_EQ(dynamic_cast<transition_station &>(*shared.snapshot()->findStationOnLine("Red", "Hub")).get_station_list().size(), 1u);
+
+    EXPECT_THROW(shared.update([](MetroSystem &system) {
+        system.addLine("Green");
+        system.addLine("Green");
+    }), std::invalid_argument);
+    EXPECT_EQ(shared.version(), 3u);
+    EXPECT_EQ(shared.snapshot()->tryFindLine("Green"), nullptr);
+}
+
+TEST(SharedMetroSystemTest, ReadersSeeWholeVersions) {
+    SharedMetroSystem shared;
+    std::atomic<bool> done{false};
+    std::atomic<size_t> torn{0};
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 4; ++r) {
+        readers.emplace_back([&] {
+            SharedMetroSystem::Reader reader(shared);
+            while (!done.load()) {
+                const MetroSystem &system = reader.pin();
+                for (const auto &linePair : system.getLines()) {
+                    if (linePair.second.getStations().size() != 2)
+                        ++torn;
+                }
+            }
+        });
+    }
+    for (int i = 0; i < 100; ++i) {
+        shared.update([i](MetroSystem &system) {
+            string line = "L" + std::to_string(i);
+            system.addLine(line);
+            system.addStationToLine(line, station("A"));
+            system.addStationToLine(line, station("B"));
+        });
+    }
+    done = true;
+    for (auto &reader : readers) {
+        reader.join();
+    }
+    EXPECT_EQ(torn.load(), 0u);
+    EXPECT_EQ(shared.snapshot()->getLines().size(), 100u);
+}
+
+TEST(MetroSystemTest, BatchEditsApplyAsOneUnit) {
+    MetroSystem system;
+    system.addLine("Red");
+    system.addStationToLine("Red", station("A"));
+    system.addStationToLine("Red", station("B"));
+    system.addStationToLine("Red", station("C"));
+    system.addLine("Blue");
+    system.addStationToLine("Blue", transition_station("X"));
+    system.addTransfer("Blue", "X", "C", "Red");
+    system.validateSystem();
+
+    std::vector<SystemEdit> edits = {
+        SystemEdit::addLine("Green"),
+        SystemEdit::addStation("Green", "G", "transition"),
+        SystemEdit::addTransfer("Green", "G", "A", "Red"),
+        SystemEdit::removeStation("Red", "A"),
+        SystemEdit::removeStation("Red", "C"),
+        SystemEdit::addStation("Red", "A"),
+        SystemEdit::modifyStation("Red", "B", "B2", "Direct"),
+        SystemEdit::addStation("Red", "D"),
+    };
+    EXPECT_EQ(system.applyBatch(edits), 1u);
+    EXPECT_EQ(system.findLine("Red").getTableStr(), "B2-Direct\nA-Direct\nD-Direct\n");
+    EXPECT_TRUE(dynamic_cast<transition_station &>(*system.findStationOnLine("Blue", "X")).get_station_list().empty());
+    EXPECT_EQ(dynamic_cast<transition_station &>(*system.findStationOnLine("Green", "G")).get_station_list().size(), 1u);
+    EXPECT_TRUE(system.findLinesOfStation("C").empty());
+    EXPECT_EQ(system.findLinesOfStation("B2").size(), 1u);
+
+    string before = system.getSystemDescription();
+    std::vector<SystemEdit> failing = {
+        SystemEdit::addStation("Red", "E"),
+        SystemEdit::removeLine("Green"),
+        SystemEdit::addTransfer("Green", "G", "A", "Red"),
+    };
+    EXPECT_THROW(system.applyBatch(failing), std::invalid_argument);
+    std::vector<SystemEdit> full = {
+        SystemEdit::addTransfer("Blue", "X", "A", "Red"),
+        SystemEdit::addTransfer("Blue", "X", "B2", "Red"),
+        SystemEdit::addTransfer("Blue", "X", "D", "Red"),
+        SystemEdit::addTransfer("Blue", "X", "D", "Red"),
+    };
+    EXPECT_THROW(system.applyBatch(full), std::invalid_argument);
+    EXPECT_THROW(system.applyBatch(std::vector{SystemEdit::addStation("Red", "A")}), std::invalid_argument);
+    // A rejected batch interns none of its names.
+    std::vector<SystemEdit> unknown = {
+        SystemEdit::addLine("BatchTest_NewLine"),
+        SystemEdit::addStation("BatchTest_NewLine", "BatchTest_NewStation"),
+        SystemEdit::modifyStation("BatchTest_NewLine", "BatchTest_NewStation", "BatchTest_Renamed", "Direct"),
+        SystemEdit::removeStation("BatchTest_MissingLine", "BatchTest_MissingStation"),
+    };
+    EXPECT_THROW(system.applyBatch(unknown), std::invalid_argument);
+    for (const char *name : {"BatchTest_NewLine", "BatchTest_NewStation", "BatchTest_Renamed",
+                             "BatchTest_MissingLine", "BatchTest_MissingStation"})
+        EXPECT_FALSE(mgc::Symbol::find(name).has_value()) << name;
+    EXPECT_EQ(system.getSystemDescription(), before);
+    EXPECT_TRUE(dynamic_cast<transition_station &>(*system.findStationOnLine("Blue", "X")).get_station_list().empty());
+}
+
+TEST(MetroSystemTest, ArenaStationStorage) {
+    MetroSystem system(StationStorage::Arena);
+    system.addLine("Red");
+    system.addStationToLine("Red", station("A"));
+    system.addStationToLine("Red", station("B", "transition"));
+    system.addTransfer("Red", "B", "A", "Red");
+    EXPECT_EQ(system.findLine("Red").getStorage(), StationStorage::Arena);
+    EXPECT_NE(std::dynamic_pointer_cast<transition_station>(system.findStationOnLine("Red", "B")), nullptr);
+
+    system.modifyStationInLine("Red", "A", "C", "Direct");
+    EXPECT_EQ(system.findLine("Red").getTableStr(), "C-Direct\nB-transition\n");
+    EXPECT_THROW(system.modifyStationInLine("Red", "C", "B", "Direct"), std::invalid_argument);
+    EXPECT_THROW(system.modifyStationInLine("Red", "A", "D", "Direct"), std::invalid_argument);
+    EXPECT_EQ(system.findLine("Red").getTableStr(), "C-Direct\nB-transition\n");
+
+    MetroSystem copy = system;
+    EXPECT_EQ(copy.getStationStorage(), StationStorage::Arena);
+    auto held = system.findStationOnLine("Red", "C");
+    system.removeLine("Red");
+    copy.removeLine("Red");
+    EXPECT_EQ(held->getName(), "C");
+}
+
+TEST(MetroSystemTest, IncrementalValidation) {
+    MetroSystem system;
+    system.addLine("Red");
+    system.addLine("Blue");
+    system.addLine("Green");
+    system.addStationToLine("Red", station("Hub", "transition"));
+    system.addStationToLine("Blue", station("B1"));
+    system.addStationToLine("Green", station("G1"));
+    system.addTransfer("Red", "Hub", "B1", "Blue");
+    system.addTransfer("Red", "Hub", "G1", "Green");
+    system.addTransfer("Red", "Hub", "Missing", "Blue");
+    EXPECT_THROW(system.addTransfer("Red", "Hub", "X", "Blue"), std::invalid_argument);
+    EXPECT_THROW(system.addTransfer("Blue", "B1", "Hub", "Red"), std::invalid_argument);
+
+    EXPECT_EQ(system.validateSystem(), 1u);
+    auto hub = std::dynamic_pointer_cast<transition_station>(system.findStationOnLine("Red", "Hub"));
+    ASSERT_NE(hub, nullptr);
+    EXPECT_EQ(hub->get_station_list().size(), 2u);
+    EXPECT_EQ(system.validateSystem(), 0u);
+
+    system.removeStationFromLine("Blue", "B1");
+    EXPECT_EQ(system.validateSystem(), 1u);
+    EXPECT_EQ(hub->get_stations_lines_names(), "G1-Green\n");
+
+    // A station removed and added back before validation keeps its connections.
+    system.removeStationFromLine("Green", "G1");
+    system.addStationToLine("Green", station("G1"));
+    EXPECT_EQ(system.validateSystem(), 0u);
+    EXPECT_EQ(hub->get_station_list().size(), 1u);
+
+    system.removeLine("Green");
+    EXPECT_EQ(system.validateSystem(), 1u);
+    EXPECT_TRUE(hub->get_station_list().empty());
+
+    // Edits made directly on the transfer_hub are only seen by a full pass.
+    hub->add_station("Ghost", "Blue");
+    EXPECT_EQ(system.validateSystem(), 0u);
+    EXPECT_EQ(system.validateSystem(ValidationMode::Full), 1u);
+    EXPECT_TRUE(hub->get_station_list().empty());
+}
+
+TEST(MetroSystemTest, ParallelValidationMatchesFull) {
+    MetroSystem system;
+    for (int i = 0; i < 12; ++i) {
+        string line = "L" + std::to_string(i);
+        system.addLine(line);
+        for (int j = 0; j < 30; ++j) {
+            string name = line + "_" + std::to_string(j);
+            if (j % 3 == 0) {
+                transition_station ts(name);
+                ts.add_station("L" + std::to_string((i + 1) % 12) + "_" + std::to_string(j), "L" + std::to_string((i + 1) % 12));
+                ts.add_station("Missing", "L0");
+                ts.add_station(name, "Nowhere");
+                system.addStationToLine(line, std::move(ts));
+            } else {
+                system.addStationToLine(line, station(name));
+            }
+        }
+    }
+    MetroSystem parallel = system;
+    parallel.setStationCopyOnWrite(true);
+    auto hub = std::dynamic_pointer_cast<transition_station>(system.findStationOnLine("L3", "L3_6"));
+    EXPECT_EQ(parallel.validateSystem(ValidationMode::Parallel, 4), 240u);
+    EXPECT_EQ(hub->get_station_list().size(), 3u);
+    EXPECT_EQ(system.validateSystem(ValidationMode::Full), 240u);
+    EXPECT_EQ(system.getSystemDescription(), parallel.getSystemDescription());
+    for (const auto &linePair : system.getLines()) {
+        for (const auto &stationPair : linePair.second.getStations()) {
+            auto *ts = dynamic_cast<transition_station *>(stationPair.second.get());
+            if (ts) {
+                auto *other = dynamic_cast<transition_station *>(
+                    parallel.findStationOnLine(linePair.first, stationPair.first).get());
+                EXPECT_EQ(ts->get_stations_lines_names(), other->get_stations_lines_names());
+            }
+        }
+    }
+    system.removeStationFromLine("L4", "L4_6");
+    parallel.removeStationFromLine("L4", "L4_6");
+    EXPECT_EQ(system.validateSystem(), 1u);
+    EXPECT_EQ(parallel.validateSystem(), 1u);
+    EXPECT_EQ(parallel.validateSystem(ValidationMode::Parallel, 1), 0u);
+}
+
+TEST(MetroSystemTest, MetricsCountCallsErrorsAndLatencies) {
+    for (uint64_t ticks : {0ull, 7ull, 8ull, 9ull, 1000ull, 123456789ull, ~0ull}) {
+        size_t bucket = metrics::bucketOf(ticks);
+        EXPECT_LE(metrics::bucketFloor(bucket), ticks);
+        if (bucket + 1 < metrics::BucketCount) {
+            EXPECT_GT(metrics::bucketFloor(bucket + 1), ticks);
+        }
+    }
+
+    auto before = MetroSystem::getMetrics();
+    MetroSystem system;
+    system.addLine("Red");
+    system.addStationToLine("Red", station("A"));
+    for (int i = 0; i < 100; ++i)
+        system.findStationOnLine("Red", "A");
+    EXPECT_THROW(system.findStationOnLine("Red", "B"), std::invalid_argument);
+    // Threads that have finished still count.
+    std::thread([&] { system.findStationOnLine("Red", "A"); }).join();
+    auto after = MetroSystem::getMetrics();
+
+    const auto &find = after[MetricOp::FindStationOnLine];
+#if METRO_METRICS
+    const auto &findBefore = before[MetricOp::FindStationOnLine];
+    EXPECT_TRUE(after.enabled);
+    EXPECT_EQ(find.calls - findBefore.calls, 102u);
+    EXPECT_EQ(find.errors - findBefore.errors, 1u);
+    EXPECT_GT(find.samples, findBefore.samples);
+    EXPECT_GT(find.percentileNs(0.99, after.nsPerTick), 0.0);
+    EXPECT_EQ(after[MetricOp::AddLine].calls - before[MetricOp::AddLine].calls, 1u);
+    EXPECT_NE(after.getText().find("\nfindStationOnLine "), string::npos);
+    EXPECT_TRUE(after.getJson().starts_with("{\"enabled\":true,"));
+#else
+    EXPECT_FALSE(before.enabled || after.enabled);
+    EXPECT_EQ(find.calls, 0u);
+#endif
+}
+
+TEST(NetworkLoaderTest, LoadAndSaveRoundTrip) {
+    std::istringstream in(
+        "# two lines\n"
+        "line Red 3\n"
+        "station A\n"
+        "station B transition\r\n"
+        "\tstation   C   Direct\n"
+        "transfer Red B X Blue\n"
+        "line Blue\n"
+        "station X transition\n"
+        "station Y\n"
+        "transfer Blue X B Red");
+    MetroSystem system;
+    auto stats = NetworkLoader(system).load(in);
+    EXPECT_EQ(stats.lines, 2u);
+    EXPECT_EQ(stats.stations, 5u);
+    EXPECT_EQ(stats.transfers, 2u);
+    EXPECT_EQ(system.findLine("Red").getTableStr(), "A-Direct\nB-transition\nC-Direct\n");
+    auto route = system.findRoute("A", "Y");
+    ASSERT_TRUE(route.has_value());
+    EXPECT_EQ(route->transferCount, 1u);
+
+    std::stringstream saved;
+    saveNetwork(system, saved);
+    MetroSystem copy;
+    auto copyStats = NetworkLoader(copy).load(saved);
+    EXPECT_EQ(copyStats.stations, 5u);
+    EXPECT_EQ(copyStats.transfers, 2u);
+    EXPECT_EQ(copy.getSystemDescription().size(), system.getSystemDescription().size());
+}
+
+TEST(NetworkLoaderTest, ErrorsNameTheInputLine) {
+    MetroSystem system;
+    std::istringstream orphan("station A\n");
+    EXPECT_THROW(NetworkLoader(system).load(orphan), std::invalid_argument);
+
+    std::istringstream duplicate("line Red\nstation A\nstation A\n");
+    try {
+        NetworkLoader(system).load(duplicate);
+        FAIL() << "duplicate station accepted";
+    } catch (const std::invalid_argument &ex) {
+        EXPECT_EQ(string(ex.what()), "Error: line 3: Station already exists on this line.");
+    }
+    // The rejected batch left the line empty.
+    EXPECT_TRUE(system.findLine("Red").getStations().empty());
+
+    std::istringstream reopened("line Blue\nstation A\n\nline Blue\nstation B\nstation A\n");
+    try {
+        NetworkLoader(system).load(reopened);
+        FAIL() << "station already on the line accepted";
+    } catch (const std::invalid_argument &ex) {
+        EXPECT_EQ(string(ex.what()), "Error: line 6: Station already exists on this line.");
+    }
+
+    std::istringstream unknown("line Red\nbogus record\n");
+    EXPECT_THROW(NetworkLoader(system).load(unknown), std::invalid_argument);
+
+    // Station count hints only size buffers, up to a cap.
+    std::istringstream huge("line Huge 99999999999999\nstation A\nline Max 18446744073709551615\n");
+    EXPECT_EQ(NetworkLoader(system).load(huge).stations, 1u);
+    std::istringstream overflow("line Red\nline Blue 99999999999999999999999\n");
+    try {
+        NetworkLoader(system).load(overflow);
+        FAIL() << "out-of-range station count accepted";
+    } catch (const std::invalid_argument &ex) {
+        EXPECT_EQ(string(ex.what()), "Error: line 2: station count is out of range.");
+    }
+}
+
+TEST(NetworkGeneratorTest, SeededNetworksAreReproducibleAndValid) {
+    GeneratorOptions options;
+    options.seed = 7;
+    options.lines = 12;
+    options.stationsPerLine = 40;
+    options.hubDensity = 0.2;
+    options.hubFanOut = 3;
+    for (auto profile : {NetworkProfile::Grid, NetworkProfile::City}) {
+        options.profile = profile;
+        std::ostringstream first, second;
+        auto written = NetworkGenerator(options).write(first);
+        NetworkGenerator(options).write(second);
+        EXPECT_EQ(first.str(), second.str());
+
+        MetroSystem system;
+        auto stats = NetworkGenerator(options).populate(system);
+        EXPECT_EQ(stats.lines, 12u);
+        EXPECT_EQ(stats.stations, written.stations);
+        EXPECT_EQ(stats.transfers, written.transfers);
+        EXPECT_GT(stats.transfers, 0u);
+        EXPECT_EQ(system.validateSystem(ValidationMode::Full), 0u);
+
+        // The import file describes the same network.
+        MetroSystem loaded;
+        std::istringstream in(first.str());
+        auto loadedStats = NetworkLoader(loaded).load(in);
+        EXPECT_EQ(loadedStats.transfers, stats.transfers);
+        EXPECT_EQ(loaded.findLine("L3").getTableStr(), system.findLine("L3").getTableStr());
+
+        size_t hubs = 0;
+        for (const auto &linePair : system.getLines()) {
+            for (const auto &stationPair : linePair.second.getStations()) {
+                auto *ts = dynamic_cast<const transition_station *>(stationPair.second.get());
+                if (!ts)
+                    continue;
+                ++hubs;
+                EXPECT_GE(ts->get_station_list().size(), 1u);
+                EXPECT_LE(ts->get_station_list().size(), options.hubFanOut);
+            }
+        }
+        EXPECT_GT(hubs, stats.stations / 10);
+        EXPECT_LT(hubs, stats.stations * 3 / 10);
+    }
+    // City interchanges carry one name on every line they serve.
+    options.seed = 8;
+    EXPECT_NO_THROW(NetworkGenerator(options).generate().findTransitionStationByName("Hub0"));
+
+    options.hubFanOut = transfer_hub::capacity + 1;
+    EXPECT_THROW(NetworkGenerator{options}, std::invalid_argument);
+}
+
+TEST(BatchRunnerTest, OneAnswerPerCommand) {
+    MetroSystem system;
+    std::istringstream script(
+        "# build\n"
+        "addline Red\n"
+        "add Red A\n"
+        "3 Red B transition\r\n"
+        "add Blue X\n"
+        "\n"
+        "find Red B\n"
+        "modify Red A A2 Direct\n"
+        "findtransfer B\n"
+        "teleport Red\n"
+        "rm Red\n"
+        "validate\n"
+        "9\n"
+        "rm Red A2\n"
+        "quit\n"
+        "rmline Red\n");
+    string answers;
+    mgc::TextSink out(answers);
+    BatchStats stats = BatchRunner(system).run(script, out);
+    EXPECT_EQ(stats.commands, 13u);
+    EXPECT_EQ(stats.errors, 3u);
+    string description = "Line: Red\nA2-Direct\nB-transition\n\n";
+    EXPECT_EQ(answers, "ok\nok\nok\n"
+                       "error 5 Line not found.\n"
+                       "ok B transition\nok\nok B\n"
+                       "error 10 unknown command 'teleport'.\n"
+                       "error 11 expected: rm <line> <station>.\n"
+                       "ok 0\n"
+                       "ok " + std::to_string(description.size()) + "\n" + description +
+                       "ok\n");
+    EXPECT_TRUE(system.tryFindLine("Red"));
+}
+
+TEST(SnapshotTest, SaveAndQueryMappedSnapshot) {
+    MetroSystem system;
+    system.addLine("Red");
+    system.addLine("Blue");
+    system.addStationsToLine("Red", std::vector<StationSpec>{{"A"}, {"Hub", "transition"}, {"C"}});
+    system.addStationsToLine("Blue", std::vector<StationSpec>{{"X"}, {"Hub"}, {"Z"}});
+    system.addTransfer("Red", "Hub", "Hub", "Blue");
+
+    const string path = ::testing::TempDir() + "metro_snapshot_test.bin";
+    saveSnapshot(system, path);
+    {
+        SnapshotView view(path);
+        EXPECT_EQ(view.lineCount(), 2u);
+        EXPECT_EQ(view.stationCount(), 6u);
+        EXPECT_EQ(view.getSystemDescription(), system.getSystemDescription());
+
+        auto c = view.findStationOnLine("Red", "C");
+        ASSERT_TRUE(c.has_value());
+        EXPECT_EQ(c->type, "Direct");
+        EXPECT_FALSE(view.findStationOnLine("Red", "X").has_value());
+        EXPECT_FALSE(view.findStationOnLine("Green", "A").has_value());
+
+        auto hub = view.findTransitionStationByName("Hub");
+        ASSERT_TRUE(hub.has_value());
+        EXPECT_EQ(hub->line, "Red");
+        EXPECT_EQ(view.getConnections(hub->node), "Hub-Blue\n");
+        EXPECT_FALSE(view.findTransitionStationByName("A").has_value());
+
+        auto fromSnapshot = view.findRoute("Red", "A", "Blue", "Z");
+        auto fromSystem = system.findRoute("Red", "A", "Blue", "Z");
+        ASSERT_TRUE(fromSnapshot.has_value());
+        ASSERT_TRUE(fromSystem.has_value());
+        EXPECT_EQ(fromSnapshot->stopCount, fromSystem->stopCount);
+        EXPECT_EQ(fromSnapshot->transferCount, 1u);
+        EXPECT_EQ(fromSnapshot->path.back().line, "Blue");
+    }
+
+    auto patch = [&path](uint64_t offset, uint32_t value) {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(static_cast<std::streamoff>(offset));
+        file.write(reinterpret_cast<const char *>(&value), sizeof value);
+    };
+    SnapshotHeader header{};
+    {
+        std::ifstream in(path, std::ios::binary);
+        in.read(reinterpret_cast<char *>(&header), sizeof header);
+    }
+    patch(header.nodes + offsetof(SnapshotNode, line), header.lineCount);
+    EXPECT_THROW(SnapshotView view(path), std::invalid_argument);
+    saveSnapshot(system, path);
+    patch(header.nodesByName + sizeof(uint32_t), header.nodeCount);
+    EXPECT_THROW(SnapshotView view(path), std::invalid_argument);
+    saveSnapshot(system, path);
+    patch(header.edgeTargets, header.nodeCount + 7);
+    EXPECT_THROW(SnapshotView view(path), std::invalid_argument);
+    saveSnapshot(system, path);
+    EXPECT_NO_THROW(SnapshotView view(path));
+
+    {
+        std::ofstream corrupt(path, std::ios::binary | std::ios::trunc);
+        corrupt << "definitely not a snapshot, but long enough to hold a header............"
+                   "................................................................";
+    }
+    EXPECT_THROW(SnapshotView view(path), std::invalid_argument);
+    std::remove(path.c_str());
+    EXPECT_THROW(SnapshotView view(path), std::invalid_argument);
+}
+
+TEST(RoutingTest, RouteAcrossTransferHub) {
+    MetroSystem system;
+    system.addLine("Red");
+    system.addLine("Blue");
+    system.addStationToLine("Red", station("A"));
+    transition_station b("B");
+    b.add_station("X", "Blue");
+    system.addStationToLine("Red", std::move(b));
+    system.addStationToLine("Red", station("C"));
+    for (const char *name : {"W", "X", "Y"})
+        system.addStationToLine("Blue", station(name));
+
+    auto route = system.findRoute("Red", "A", "Blue", "Y");
+    ASSERT_TRUE(route.has_value());
+    ASSERT_EQ(route->path.size(), 4u);
+    EXPECT_EQ(route->path[1].station, "B");
+    EXPECT_EQ(route->path[2].line, "Blue");
+    EXPECT_EQ(route->path[2].station, "X");
+    EXPECT_EQ(route->stopCount, 2u);
+    EXPECT_EQ(route->transferCount, 1u);
+
+    auto byName = system.findRoute("C", "W");
+    ASSERT_TRUE(byName.has_value());
+    EXPECT_EQ(byName->stopCount, 2u);
+    EXPECT_EQ(byName->transferCount, 1u);
+
+    system.removeStationFromLine("Blue", "X");
+    EXPECT_FALSE(system.findRoute("Red", "A", "Blue", "Y").has_value());
+    EXPECT_THROW(system.findRoute("Red", "A", "Blue", "X"), std::invalid_argument);
+}
+
+TEST(RoutingTest, ShortcutTradesStopsForTransfers) {
+    MetroSystem system;
+    system.addLine("Long");
+    system.addLine("Short");
+    system.addStationToLine("Long", station("A"));
+    transition_station b("B");
+    b.add_station("P", "Short");
+    system.addStationToLine("Long", std::move(b));
+    for (const char *name : {"C", "D", "E"})
+        system.addStationToLine("Long", station(name));
+    transition_station f("F");
+    f.add_station("Q", "Short");
+    system.addStationToLine("Long", std::move(f));
+    system.addStationToLine("Long", station("G"));
+    system.addStationToLine("Short", station("P"));
+    system.addStationToLine("Short", station("Q"));
+
+    auto fewestStops = system.findRoute("Long", "A", "Long", "G", RouteCost::FewestStops);
+    ASSERT_TRUE(fewestStops.has_value());
+    EXPECT_EQ(fewestStops->stopCount, 3u);
+    EXPECT_EQ(fewestStops->transferCount, 2u);
+    EXPECT_EQ(fewestStops->path[2].line, "Short");
+
+    auto fewestTransfers = system.findRoute("Long", "A", "Long", "G", RouteCost::FewestTransfers);
+    ASSERT_TRUE(fewestTransfers.has_value());
+    EXPECT_EQ(fewestTransfers->stopCount, 6u);
+    EXPECT_EQ(fewestTransfers->transferCount, 0u);
+
+    system.addLine("Island");
+    system.addStationToLine("Island", station("Z"));
+    EXPECT_FALSE(system.findRoute("A", "Z").has_value());
+    EXPECT_THROW(system.findRoute("A", "Nowhere"), std::invalid_argument);
+}
+
+TEST(RoutingTest, RouteCacheDropsOnlyWhatEditsCanChange) {
+    MetroSystem system;
+    system.addLine("Red");
+    system.addLine("Blue");
+    system.addLine("Island");
+    system.addStationToLine("Red", station("A"));
+    transition_station b("B");
+    b.add_station("X", "Blue");
+    system.addStationToLine("Red", std::move(b));
+    for (const char *name : {"W", "X", "Y"})
+        system.addStationToLine("Blue", station(name));
+    for (const char *name : {"P", "Q", "R"})
+        system.addStationToLine("Island", station(name));
+
+    auto route = system.findRoute("Red", "A", "Blue", "Y");
+    EXPECT_EQ(system.findRoute("Red", "A", "Blue", "Y")->path.size(), route->path.size());
+    EXPECT_TRUE(system.findRoute("Island", "P", "Island", "R").has_value());
+    EXPECT_FALSE(system.findRoute("A", "Q").has_value());
+    EXPECT_EQ(system.getRouteCacheStats().hits, 1u);
+    EXPECT_EQ(system.getRouteCacheStats().misses, 3u);
+
+    // Only the route along Island goes; appending an unconnected station keeps the rest.
+    system.removeStationFromLine("Island", "R");
+    system.addStationToLine("Red", station("C"));
+    EXPECT_EQ(system.getRouteCacheStats().invalidations, 1u);
+    EXPECT_EQ(system.findRoute("Red", "A", "Blue", "Y")->stopCount, 2u);
+    EXPECT_FALSE(system.findRoute("A", "Q").has_value());
+    EXPECT_EQ(system.getRouteCacheStats().hits, 3u);
+
+    // A new transfer can connect anything, so every result goes.
+    system.modifyStationInLine("Island", "P", "P", "transition");
+    system.addTransfer("Island", "P", "C", "Red");
+    auto connected = system.findRoute("A", "Q");
+    ASSERT_TRUE(connected.has_value());
+    EXPECT_EQ(connected->transferCount, 1u);
+
+    system.clearRouteCache();
+    system.setRouteCacheCapacity(1);
+    system.findRoute("A", "Q");
+    system.findRoute("A", "Y");
+    system.findRoute("A", "Y");
+    EXPECT_EQ(system.getRouteCacheStats().evictions, 1u);
+    EXPECT_EQ(system.getRouteCacheStats().hits, 1u);
+
+    // Unreachable results have no lines, yet removing or renaming an endpoint still drops them.
+    MetroSystem split;
+    split.addLine("L1");
+    split.addLine("L2");
+    split.addLine("L3");
+    split.addStationsToLine("L1", std::vector<StationSpec>{{"A"}, {"X"}});
+    split.addStationsToLine("L2", std::vector<StationSpec>{{"B"}, {"D"}});
+    split.addStationsToLine("L3", std::vector<StationSpec>{{"E"}});
+    EXPECT_FALSE(split.findRoute("L1", "A", "L2", "B").has_value());
+    EXPECT_FALSE(split.findRoute("L1", "X", "L2", "D").has_value());
+    EXPECT_FALSE(split.findRoute("B", "E").has_value());
+    EXPECT_FALSE(split.findRoute("L2", "B", "L3", "E").has_value());
+    split.removeStationFromLine("L1", "A");
+    EXPECT_THROW(split.findRoute("L1", "A", "L2", "B"), std::invalid_argument);
+    split.modifyStationInLine("L1", "X", "Y", "Direct");
+    EXPECT_THROW(split.findRoute("L1", "X", "L2", "D"), std::invalid_argument);
+    split.removeLine("L3");
+    EXPECT_THROW(split.findRoute("B", "E"), std::invalid_argument);
+    EXPECT_THROW(split.findRoute("L2", "B", "L3", "E"), std::invalid_argument);
+}
+
+TEST(RoutingTest, ContractionHierarchyMatchesPlainSearch) {
+    MetroSystem system;
+    auto name = [](int line, int slot) { return "C" + std::to_string(line) + "_" + std::to_string(slot); };
+    for (int i = 0; i < 6; ++i) {
+        system.addLine("C" + std::to_string(i));
+        for (int j = 0; j < 30; ++j) {
+            if (j % 7 == 3) {
+                transition_station ts(name(i, j));
+                ts.add_station(name((i + 1) % 5, j), "C" + std::to_string((i + 1) % 5));
+                ts.add_station(name((i + 2) % 5, (j + 7) % 30), "C" + std::to_string((i + 2) % 5));
+                system.addStationToLine("C" + std::to_string(i), std::move(ts));
+            } else {
+                system.addStationToLine("C" + std::to_string(i), station(name(i, j)));
+            }
+        }
+    }
+    const RouteGraph &graph = system.getRouteGraph();
+    RouteFinder plain;
+    HierarchyFinder fast;
+    for (RouteCost cost : {RouteCost::FewestStops, RouteCost::FewestTransfers}) {
+        const ContractionHierarchy &hierarchy = system.getRouteHierarchy(cost);
+        EXPECT_EQ(hierarchy.nodeCount(), graph.nodeCount());
+        for (uint32_t from = 0; from < graph.nodeCount(); from += 3) {
+            for (uint32_t to = 0; to < graph.nodeCount(); to += 5) {
+                auto expected = plain.search(graph.view(), std::span(&from, 1), std::span(&to, 1), cost);
+                auto found = fast.search(hierarchy, std::span(&from, 1), std::span(&to, 1));
+                ASSERT_EQ(found.has_value(), expected.has_value()) << from << " " << to;
+                if (!found)
+                    continue;
+                EXPECT_EQ(found->stopCount, expected->stopCount);
+                EXPECT_EQ(found->transferCount, expected->transferCount);
+                ASSERT_EQ(found->nodes.front(), from);
+                ASSERT_EQ(found->nodes.back(), to);
+                uint32_t rides = 0, transfers = 0;
+                for (size_t k = 1; k < found->nodes.size(); ++k) {
+                    uint32_t u = found->nodes[k - 1], v = found->nodes[k];
+                    bool joined = false;
+                    for (uint32_t e = graph.view().offsets[u]; e < graph.view().offsets[u + 1]; ++e)
+                        joined = joined || graph.view().targets[e] == v;
+                    ASSERT_TRUE(joined);
+                    (graph.lineName(u) == graph.lineName(v) ? rides : transfers) += 1;
+                }
+                EXPECT_EQ(rides, found->stopCount);
+                EXPECT_EQ(transfers, found->transferCount);
+            }
+        }
+    }
+
+    MetroSystem preprocessed = system;
+    preprocessed.addLine("Island");
+    preprocessed.addStationToLine("Island", station("Z"));
+    preprocessed.setRoutePreprocessing(true);
+    preprocessed.setRouteCacheCapacity(0);
+    auto byName = preprocessed.findRoute(name(0, 0), name(3, 29), RouteCost::FewestTransfers);
+    auto reference = system.findRoute(name(0, 0), name(3, 29), RouteCost::FewestTransfers);
+    ASSERT_TRUE(byName.has_value() && reference.has_value());
+    EXPECT_EQ(byName->transferCount, reference->transferCount);
+    EXPECT_EQ(byName->stopCount, reference->stopCount);
+    EXPECT_FALSE(preprocessed.findRoute("C0", name(0, 0), "Island", "Z").has_value());
+}
+
+#include "../routing/travel_matrix.hpp"
+
+TEST(TravelMatrixTest, HopsAndTransfersInMemoryAndOnDisk) {
+    MetroSystem system;
+    system.addLine("Long");
+    system.addLine("Short");
+    system.addLine("Island");
+    system.addStationToLine("Long", station("A"));
+    transition_station b("B");
+    b.add_station("P", "Short");
+    system.addStationToLine("Long", std::move(b));
+    for (const char *name : {"C", "D", "E"})
+        system.addStationToLine("Long", station(name));
+    transition_station f("F");
+    f.add_station("Q", "Short");
+    system.addStationToLine("Long", std::move(f));
+    system.addStationToLine("Long", station("G"));
+    system.addStationToLine("Short", station("P"));
+    system.addStationToLine("Short", station("Q"));
+    system.addStationToLine("Island", station("Z"));
+    const RouteGraph &graph = system.getRouteGraph();
+    auto node = [&graph](const char *line, const char *name) { return *graph.node(line, name); };
+
+    TravelMatrix all = TravelMatrix::computeAll(graph.view(), 3);
+    ASSERT_EQ(all.rows(), graph.nodeCount());
+    uint32_t a = node("Long", "A");
+    EXPECT_EQ(all.hops(a, a), 0u);
+    EXPECT_EQ(all.hops(a, node("Long", "G")), 5u);
+    EXPECT_EQ(all.transfers(a, node("Long", "G")), 2u);
+    EXPECT_EQ(all.hops(a, node("Long", "E")), 4u);
+    EXPECT_EQ(all.transfers(a, node("Long", "E")), 0u);
+    EXPECT_EQ(all.hops(a, node("Island", "Z")), TravelMatrix::Unreachable);
+    EXPECT_EQ(all.transfers(a, node("Island", "Z")), TravelMatrix::Unreachable);
+
+    std::vector<uint32_t> sources = {node("Long", "G"), a};
+    std::vector<uint32_t> targets = {node("Short", "Q"), node("Long", "A"), node("Long", "D")};
+    TravelMatrix some = TravelMatrix::compute(graph.view(), sources, targets, 1);
+    for (uint32_t row = 0; row < some.rows(); ++row) {
+        for (uint32_t col = 0; col < some.cols(); ++col) {
+            EXPECT_EQ(some.hops(row, col), all.hops(sources[row], targets[col]));
+            EXPECT_EQ(some.transfers(row, col), all.transfers(sources[row], targets[col]));
+        }
+    }
+
+    const string path = ::testing::TempDir() + "travel_matrix_test.bin";
+    {
+        TravelMatrix written = TravelMatrix::computeToFile(graph.view(), sources, targets, path, 2);
+        EXPECT_EQ(written.hops(1, 0), some.hops(1, 0));
+    }
+    TravelMatrix mapped = TravelMatrix::open(path);
+    ASSERT_EQ(mapped.rows(), 2u);
+    ASSERT_EQ(mapped.cols(), 3u);
+    EXPECT_EQ(mapped.source(1), a);
+    EXPECT_EQ(mapped.target(2), node("Long", "D"));
+    for (uint32_t row = 0; row < 2; ++row) {
+        for (uint32_t col = 0; col < 3; ++col) {
+            EXPECT_EQ(mapped.hops(row, col), some.hops(row, col));
+            EXPECT_EQ(mapped.transfers(row, col), some.transfers(row, col));
+        }
+    }
+    std::remove(path.c_str());
+
+    EXPECT_THROW(TravelMatrix::compute(graph.view(), std::vector<uint32_t>{graph.nodeCount()}, targets),
+                 std::invalid_argument);
+    EXPECT_THROW(TravelMatrix::open(path), std::invalid_argument);
+}
+
+#include "../server/metro_server.hpp"
+#include "../server/metro_client.hpp"
+
+TEST(MetroServerTest, AnswersPipelinedRequests) {
+    MetroSystem system;
+    system.addLine("Red");
+    system.addLine("Blue");
+    system.addStationToLine("Red", station("A"));
+    transition_station b("B");
+    b.add_station("X", "Blue");
+    system.addStationToLine("Red", std::move(b));
+    for (const char *name : {"W", "X", "Y"})
+        system.addStationToLine("Blue", station(name));
+    string description = system.getSystemDescription();
+    SharedMetroSystem shared(system);
+
+    string path = "/tmp/metro_server_test_" + std::to_string(::getpid()) + ".sock";
+    MetroServer server(shared, ServerOptions{path, 2, 4});
+    std::thread loop([&server] { server.run(); });
+
+    MetroClient client(path);
+    uint32_t find = client.find("Red", "B");
+    uint32_t missing = client.find("Red", "Q");
+    uint32_t route = client.route(RouteCost::FewestStops, "Red", "A", "Blue", "Y");
+    uint32_t byName = client.route(RouteCost::FewestTransfers, "", "A", "", "W");
+    uint32_t describe = client.describe();
+    std::map<uint32_t, std::pair<WireStatus, string>> answers;
+    for (int i = 0; i < 5; ++i) {
+        ClientResponse response = client.receive();
+        answers[response.id] = {response.status, string(response.body)};
+    }
+    EXPECT_EQ(answers[find], std::make_pair(WireStatus::Ok, string("transition")));
+    EXPECT_EQ(answers[missing].first, WireStatus::Error);
+    EXPECT_EQ(answers[describe], std::make_pair(WireStatus::Ok, description));
+
+    WireReader hops(answers[route].second);
+    EXPECT_EQ(answers[route].first, WireStatus::Ok);
+    EXPECT_EQ(hops.u32(), 2u);
+    EXPECT_EQ(hops.u32(), 1u);
+    ASSERT_EQ(hops.u32(), 4u);
+    std::vector<string> stops;
+    for (int i = 0; i < 4; ++i) {
+        string line(hops.str());
+        stops.push_back(line + ":" + string(hops.str()));
+    }
+    EXPECT_TRUE(hops.atEnd());
+    EXPECT_EQ(stops, (std::vector<string>{"Red:A", "Red:B", "Blue:X", "Blue:Y"}));
+    EXPECT_EQ(answers[byName].first, WireStatus::Ok);
+
+    MetroClient other(path);
+    shared.update([](MetroSystem &s) { s.removeStationFromLine("Blue", "X"); });
+    other.validate();
+    ClientResponse validated = other.receive();
+    EXPECT_EQ(validated.status, WireStatus::Ok);
+    EXPECT_EQ(WireReader(validated.body).u64(), 1u);
+    other.route(RouteCost::FewestStops, "Red", "A", "Blue", "Y");
+    EXPECT_EQ(other.receive().status, WireStatus::NotFound);
+
+    // A client that shuts down its sending side still gets every answer, then end of stream.
+    MetroClient closing(path);
+    for (int i = 0; i < 6; ++i)
+        closing.find("Red", "A");
+    closing.describe();
+    closing.shutdownSending();
+    for (int i = 0; i < 7; ++i)
+        EXPECT_EQ(closing.receive().status, WireStatus::Ok);
+    EXPECT_THROW(closing.receive(), std::invalid_argument);
+
+    server.stop();
+    loop.join();
+    EXPECT_EQ(server.stats().connections, 3u);
+    EXPECT_EQ(server.stats().requests, 14u);
+    EXPECT_EQ(server.stats().errors, 1u);
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();